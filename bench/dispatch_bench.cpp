@@ -0,0 +1,201 @@
+// Measures what a device-level call costs through the loader's trampoline, i.e. the pointer
+// vkGetInstanceProcAddr hands out for it, against the pointer from vkGetDeviceProcAddr that
+// vulkan_dispatch.hpp loads. vkCmdSetViewport only writes a few words into the command buffer, so
+// the difference is mostly dispatch. Runs on any ICD, e.g. lavapipe:
+//
+//     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json dispatch-bench [calls]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    constexpr uint64_t DEFAULT_CALLS        { 10'000'000 };
+    // Calls recorded per command buffer before the pool is reset, keeps the driver's memory flat.
+    constexpr uint32_t BATCH_CALLS          { 16384 };
+    constexpr uint32_t ROUNDS               { 5 };
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Context
+    {
+        VkInstance instance             { };
+        VkDevice device                 { };
+        VkCommandPool commandPool       { };
+        VkCommandBuffer commandBuffer   { };
+
+        ~Context()
+        {
+            if (device)
+            {
+                vkDestroyCommandPool(device, commandPool, nullptr);
+                vkDestroyDevice(device, nullptr);
+            }
+            if (instance)
+            {
+                vkDestroyInstance(instance, nullptr);
+            }
+        }
+    };
+
+    void createContext(Context& context)
+    {
+        loadGlobalDispatch();
+        VkApplicationInfo _appInfo {
+            .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            .pApplicationName = "dispatch-bench",
+            .apiVersion = VK_API_VERSION_1_2
+        };
+        VkInstanceCreateInfo _instanceInfo {
+            .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            .pApplicationInfo = &_appInfo
+        };
+        if (vkCreateInstance(&_instanceInfo, nullptr, &context.instance) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create vulkan instance!");
+        }
+        loadInstanceDispatch(context.instance);
+
+        uint32_t _deviceCount { };
+        vkEnumeratePhysicalDevices(context.instance, &_deviceCount, nullptr);
+        if (_deviceCount == 0)
+        {
+            throw std::runtime_error("Failed to find a vulkan device!");
+        }
+        std::vector<VkPhysicalDevice> _physicalDevices(_deviceCount);
+        vkEnumeratePhysicalDevices(context.instance, &_deviceCount, _physicalDevices.data());
+        const auto _physicalDevice { _physicalDevices.front() };
+
+        VkPhysicalDeviceProperties _properties { };
+        vkGetPhysicalDeviceProperties(_physicalDevice, &_properties);
+        std::cout << "Device: " << _properties.deviceName << "\n";
+
+        uint32_t _familyCount { };
+        vkGetPhysicalDeviceQueueFamilyProperties(_physicalDevice, &_familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> _families(_familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(_physicalDevice, &_familyCount, _families.data());
+        std::optional<uint32_t> _graphicsFamily;
+        for (uint32_t i = 0; i < _familyCount; i++)
+        {
+            if (_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+            {
+                _graphicsFamily = i;
+                break;
+            }
+        }
+        if (!_graphicsFamily)
+        {
+            throw std::runtime_error("Failed to find a graphics queue family!");
+        }
+
+        const float _priority { 1.0f };
+        VkDeviceQueueCreateInfo _queueInfo {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueFamilyIndex = *_graphicsFamily,
+            .queueCount = 1,
+            .pQueuePriorities = &_priority
+        };
+        VkDeviceCreateInfo _deviceInfo {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            .queueCreateInfoCount = 1,
+            .pQueueCreateInfos = &_queueInfo
+        };
+        if (vkCreateDevice(_physicalDevice, &_deviceInfo, nullptr, &context.device) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create logical device!");
+        }
+        loadDeviceDispatch(context.device);
+
+        VkCommandPoolCreateInfo _poolInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .queueFamilyIndex = *_graphicsFamily
+        };
+        if (vkCreateCommandPool(context.device, &_poolInfo, nullptr, &context.commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create command pool!");
+        }
+        VkCommandBufferAllocateInfo _allocInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = context.commandPool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+        if (vkAllocateCommandBuffers(context.device, &_allocInfo, &context.commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate command buffer!");
+        }
+    }
+
+    // Nanoseconds per call of setViewport, only the recording itself is timed.
+    double measure(const Context& context, PFN_vkCmdSetViewport setViewport, uint64_t calls)
+    {
+        const VkCommandBufferBeginInfo _beginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+        };
+        Clock::duration _elapsed { };
+        for (uint64_t done = 0; done < calls;)
+        {
+            const auto _batch { static_cast<uint32_t>(std::min<uint64_t>(BATCH_CALLS, calls - done)) };
+            vkResetCommandPool(context.device, context.commandPool, 0);
+            vkBeginCommandBuffer(context.commandBuffer, &_beginInfo);
+            const auto _start { Clock::now() };
+            for (uint32_t i = 0; i < _batch; i++)
+            {
+                const VkViewport _viewport { 0.0f, 0.0f, static_cast<float>(i & 1023), 1024.0f, 0.0f, 1.0f };
+                setViewport(context.commandBuffer, 0, 1, &_viewport);
+            }
+            _elapsed += Clock::now() - _start;
+            vkEndCommandBuffer(context.commandBuffer);
+            done += _batch;
+        }
+        return std::chrono::duration<double, std::nano>(_elapsed).count() / static_cast<double>(calls);
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        const uint64_t _calls { std::max<uint64_t>(argc > 1 ? std::stoull(argv[1]) : DEFAULT_CALLS, 1) };
+        Context _context;
+        createContext(_context);
+
+        const auto _trampoline { reinterpret_cast<PFN_vkCmdSetViewport>(
+            vkGetInstanceProcAddr(_context.instance, "vkCmdSetViewport")) };
+        if (!_trampoline)
+        {
+            throw std::runtime_error("Failed to load vkCmdSetViewport!");
+        }
+
+        // Alternate the two so clock ramp-up and cache state hit both alike, keep the best round.
+        measure(_context, vkCmdSetViewport, BATCH_CALLS);
+        double _loader { std::numeric_limits<double>::max() };
+        double _direct { std::numeric_limits<double>::max() };
+        for (uint32_t round = 0; round < ROUNDS; round++)
+        {
+            _loader = std::min(_loader, measure(_context, _trampoline, _calls));
+            _direct = std::min(_direct, measure(_context, vkCmdSetViewport, _calls));
+        }
+
+        std::cout << std::fixed << std::setprecision(2)
+            << _calls << " vkCmdSetViewport calls, best of " << ROUNDS << " rounds\n"
+            << "\tloader trampoline       " << _loader << " ns/call\n"
+            << "\tvkGetDeviceProcAddr     " << _direct << " ns/call (" << _loader - _direct << " ns saved, "
+            << _loader / _direct << "x)\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
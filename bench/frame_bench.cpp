@@ -0,0 +1,201 @@
+// Runs the application headlessly through a fixed list of scenarios and writes one JSON record per
+// scenario, so two builds can be compared by diffing their results. Every scenario is a full
+// run: instance, device, pipelines, frames, teardown. Meant for a software ICD, e.g. lavapipe:
+//
+//     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json frame-bench [results.json] [options]
+//
+// Options are the application's own (see --help) and apply to every scenario before its changes,
+// e.g. --frames or --device. Pipeline cache, device snapshot and validation are always off, so
+// each scenario starts the same way.
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "app_config.hpp"
+#include "application.hpp"
+
+namespace
+{
+    constexpr const char* DEFAULT_RESULTS_PATH { "frame_bench.json" };
+
+    struct Scenario
+    {
+        const char* name;
+        std::function<void(AppConfig&)> apply;
+        // Fails the scenario when the warmed up frame loop still allocates from the heap.
+        bool allocationFree     { true };
+    };
+
+    const std::vector<Scenario>& scenarios()
+    {
+        static const std::vector<Scenario> _scenarios {
+            { "instances-10000", [](AppConfig& config) { config.instanceCount = 10000; } },
+            { "instances-100000", [](AppConfig& config) { config.instanceCount = 100000; } },
+            { "draws-1000", [](AppConfig& config) { config.drawCount = 1000; } },
+            { "draws-10000", [](AppConfig& config) { config.drawCount = 10000; } },
+            // Same scene on both main pass paths, compare their cpuMsPerFrame. Devices without dynamic
+            // rendering run the render pass path twice.
+            { "dynamic-rendering", [](AppConfig& config) { config.drawCount = 1000; } },
+            { "render-pass", [](AppConfig& config) { config.drawCount = 1000; config.renderPasses = true; } },
+            { "frames-in-flight-1", [](AppConfig& config) { config.framesInFlight = 1; } },
+            { "frames-in-flight-2", [](AppConfig& config) { config.framesInFlight = 2; } },
+            { "frames-in-flight-3", [](AppConfig& config) { config.framesInFlight = 3; } },
+            { "resize-every-10-frames", [](AppConfig& config) { config.resizeInterval = 10; }, false },
+            { "upload-16MiB", [](AppConfig& config) { config.uploadBenchmarkMiB = 16; }, false },
+            { "upload-128MiB", [](AppConfig& config) { config.uploadBenchmarkMiB = 128; }, false },
+        };
+        return _scenarios;
+    }
+
+    struct Result
+    {
+        const char* name;
+        std::optional<RunReport> report;
+        std::string error;
+    };
+
+    std::string jsonString(std::string_view text)
+    {
+        std::string _escaped { "\"" };
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                _escaped += '\\';
+                _escaped += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                _escaped += ' ';
+            }
+            else
+            {
+                _escaped += c;
+            }
+        }
+        return _escaped + "\"";
+    }
+
+    void writeJson(std::ostream& out, const std::vector<Result>& results)
+    {
+        out << std::fixed << std::setprecision(3) << "{\n\t\"scenarios\": [";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const auto& _result { results[i] };
+            out << (i ? ",\n" : "\n") << "\t\t{ \"name\": " << jsonString(_result.name);
+            if (!_result.error.empty())
+            {
+                out << ", \"error\": " << jsonString(_result.error);
+            }
+            if (!_result.report)
+            {
+                out << " }";
+                continue;
+            }
+            const auto& _report { *_result.report };
+            out << ", \"device\": " << jsonString(_report.deviceName)
+                << ", \"startupMs\": " << _report.startupMs
+                << ", \"frames\": " << _report.frames
+                << ", \"framesPerSecond\": " << _report.framesPerSecond()
+                << ", \"cpuMsPerFrame\": " << _report.cpuMsPerFrame
+                << ", \"resizes\": " << _report.resizes
+                << ", \"gpuAllocations\": " << _report.gpuAllocations
+                << ", \"deviceMemoryAllocations\": " << _report.deviceMemoryAllocations
+                << ", \"heapAllocationsPerFrame\": " << _report.heapAllocationsPerFrame
+                << ", \"frameArenaPeakBytes\": " << _report.frameArenaPeakBytes
+                << ", \"asyncUploadMBps\": " << _report.asyncUploadMBps
+                << ", \"blockingUploadMBps\": " << _report.blockingUploadMBps << " }";
+        }
+        out << "\n\t]\n}\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        std::string _resultsPath { DEFAULT_RESULTS_PATH };
+        std::vector<char*> _appArgs { argv[0] };
+        for (int i = 1; i < argc; i++)
+        {
+            if (i == 1 && argv[i][0] != '-')
+            {
+                _resultsPath = argv[i];
+                continue;
+            }
+            _appArgs.push_back(argv[i]);
+        }
+        auto _base { parseCommandLine(static_cast<int>(_appArgs.size()), _appArgs.data()) };
+        _base.headless = true;
+        _base.pipelineCachePath.clear();
+        _base.deviceSnapshotPath.clear();
+        _base.validation.enabled = false;
+
+        std::vector<Result> _results;
+        for (const auto& scenario : scenarios())
+        {
+            std::cout << "=== " << scenario.name << " ===\n";
+            auto _config { _base };
+            scenario.apply(_config);
+            Result _result { .name = scenario.name };
+            try {
+                _result.report = runApplication(_config);
+                if (scenario.allocationFree && _result.report->heapAllocationsPerFrame > 0.0)
+                {
+                    _result.error = "heap allocations in the steady-state frame loop";
+                }
+            }
+            catch (const std::exception& e) {
+                std::cerr << scenario.name << " failed: " << e.what() << "\n";
+                _result.error = e.what();
+            }
+            _results.push_back(std::move(_result));
+        }
+
+        std::ofstream _file(_resultsPath);
+        writeJson(_file, _results);
+        if (!_file)
+        {
+            throw std::runtime_error("Failed to write " + _resultsPath + "!");
+        }
+
+        bool _failed { };
+        std::cout << std::fixed << std::setprecision(2) << "\nScenario                 frames/s  CPU ms/frame  startup ms\n";
+        for (const auto& result : _results)
+        {
+            std::cout << std::left << std::setw(24) << result.name << std::right;
+            if (!result.report)
+            {
+                std::cout << " failed\n";
+                _failed = true;
+                continue;
+            }
+            std::cout << std::setw(9) << result.report->framesPerSecond() << std::setw(14) << result.report->cpuMsPerFrame
+                << std::setw(12) << result.report->startupMs;
+            if (!result.error.empty())
+            {
+                std::cout << "  failed: " << result.error;
+                _failed = true;
+            }
+            std::cout << "\n";
+        }
+        std::cout << "Wrote " << _resultsPath << "\n";
+        if (_failed)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
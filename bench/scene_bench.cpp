@@ -0,0 +1,204 @@
+// Compares SceneGraph's SoA/SIMD update against the obvious array-of-structs loop that does glm
+// matrix math one object at a time. Both build the same two-level hierarchy as the demo scene and
+// write their results into a GpuTransform array standing in for the mapped instance buffer.
+//
+//     scene-bench [instances] [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "scene_graph.hpp"
+
+namespace
+{
+    constexpr uint32_t DEFAULT_INSTANCES    { 100000 };
+    constexpr uint32_t DEFAULT_FRAMES       { 200 };
+    constexpr uint32_t CLUSTER_SIZE         { 16 };
+    // Every SPIN_INTERVAL-th cluster moves in the incremental case, as in the demo scene.
+    constexpr uint32_t SPIN_INTERVAL        { 8 };
+
+    using Clock = std::chrono::steady_clock;
+
+    // What a scene usually starts out as: one struct per object with a full glm::mat4.
+    struct AosNode
+    {
+        uint32_t parent             { SceneGraph::NO_PARENT };
+        glm::vec3 position          { 0.0f };
+        glm::quat rotation          { 1.0f, 0.0f, 0.0f, 0.0f };
+        float scale                 { 1.0f };
+        SceneGraph::Aabb bounds;
+        glm::mat4 world             { 1.0f };
+        glm::vec3 worldMin          { 0.0f };
+        glm::vec3 worldMax          { 0.0f };
+    };
+
+    struct Scenes
+    {
+        std::vector<AosNode> aos;
+        SceneGraph graph;
+        std::vector<uint32_t> roots;
+    };
+
+    Scenes buildScenes(uint32_t instanceCount)
+    {
+        Scenes _scenes { };
+        std::mt19937 _random { 1234 };
+        std::uniform_real_distribution<float> _position { -50.0f, 50.0f };
+        std::uniform_real_distribution<float> _offset { -4.0f, 4.0f };
+        std::uniform_real_distribution<float> _unit { -1.0f, 1.0f };
+        std::uniform_real_distribution<float> _scale { 0.4f, 1.2f };
+        const SceneGraph::Aabb _meshBounds { glm::vec3(0.0f), glm::vec3(0.5f) };
+
+        const auto _add = [&](uint32_t parent, const glm::vec3& position, const glm::quat& rotation, float scale,
+            const SceneGraph::Aabb& bounds) {
+            _scenes.graph.addNode(parent, position, rotation, scale, bounds);
+            _scenes.aos.push_back({ .parent = parent, .position = position, .rotation = rotation, .scale = scale, .bounds = bounds });
+        };
+        const uint32_t _clusterCount { (instanceCount + CLUSTER_SIZE - 1) / CLUSTER_SIZE };
+        for (uint32_t i = 0; i < _clusterCount; i++)
+        {
+            _scenes.roots.push_back(i);
+            _add(SceneGraph::NO_PARENT, { _position(_random), _position(_random), _position(_random) },
+                glm::quat(1.0f, 0.0f, 0.0f, 0.0f), 1.0f, { });
+        }
+        for (uint32_t i = 0; i < instanceCount; i++)
+        {
+            const glm::vec3 _translation { _offset(_random), _offset(_random), _offset(_random) };
+            const auto _rotation { glm::normalize(glm::quat(_unit(_random), _unit(_random), _unit(_random), _unit(_random))) };
+            _add(i / CLUSTER_SIZE, _translation, _rotation, _scale(_random), _meshBounds);
+        }
+        return _scenes;
+    }
+
+    // Recomputes every node, parents come before children so one pass is enough.
+    void updateAos(std::vector<AosNode>& nodes, std::span<GpuTransform> out)
+    {
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            auto& _node { nodes[i] };
+            const auto _local { glm::translate(glm::mat4(1.0f), _node.position) * glm::mat4_cast(_node.rotation)
+                * glm::scale(glm::mat4(1.0f), glm::vec3(_node.scale)) };
+            _node.world = _node.parent == SceneGraph::NO_PARENT ? _local : nodes[_node.parent].world * _local;
+
+            _node.worldMin = glm::vec3(std::numeric_limits<float>::max());
+            _node.worldMax = glm::vec3(std::numeric_limits<float>::lowest());
+            for (int corner = 0; corner < 8; corner++)
+            {
+                const glm::vec3 _sign { corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f };
+                const glm::vec3 _point { _node.world * glm::vec4(_node.bounds.center + _sign * _node.bounds.extent, 1.0f) };
+                _node.worldMin = glm::min(_node.worldMin, _point);
+                _node.worldMax = glm::max(_node.worldMax, _point);
+            }
+
+            auto& _transform { out[i] };
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    _transform.rows[r][c] = _node.world[c][r];
+                }
+                _transform.bounds[r] = 0.5f * (_node.worldMin[r] + _node.worldMax[r]);
+            }
+            _transform.bounds[3] = 0.5f * glm::length(_node.worldMax - _node.worldMin);
+        }
+    }
+
+    // Average milliseconds per frame of step(frame).
+    template<typename Step>
+    double measure(uint32_t frames, Step step)
+    {
+        const auto _start { Clock::now() };
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            step(frame);
+        }
+        const std::chrono::duration<double, std::milli> _elapsed { Clock::now() - _start };
+        return _elapsed.count() / frames;
+    }
+
+    glm::quat spin(uint32_t frame)
+    {
+        return glm::angleAxis(0.01f * static_cast<float>(frame), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        const uint32_t _instances { argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : DEFAULT_INSTANCES };
+        const uint32_t _frames { std::max(argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : DEFAULT_FRAMES, 1u) };
+        auto _scenes { buildScenes(_instances) };
+        const auto _nodes { _scenes.graph.size() };
+        std::vector<GpuTransform> _aosOut(_nodes);
+        std::vector<GpuTransform> _soaOut(_nodes);
+
+        // Warm up and check that both produce the same transforms.
+        updateAos(_scenes.aos, _aosOut);
+        _scenes.graph.update();
+        _scenes.graph.writeTransforms(_soaOut, _scenes.graph.changedNodes());
+        float _maxError { };
+        for (uint32_t i = 0; i < _nodes; i++)
+        {
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    _maxError = std::max(_maxError, std::fabs(_aosOut[i].rows[r][c] - _soaOut[i].rows[r][c]));
+                }
+            }
+        }
+
+        const auto _aos { measure(_frames, [&](uint32_t frame) {
+            for (const auto root : _scenes.roots)
+            {
+                _scenes.aos[root].rotation = spin(frame);
+            }
+            updateAos(_scenes.aos, _aosOut);
+        }) };
+        const auto _soaFull { measure(_frames, [&](uint32_t frame) {
+            for (const auto root : _scenes.roots)
+            {
+                _scenes.graph.setRotation(root, spin(frame));
+            }
+            _scenes.graph.update();
+            _scenes.graph.writeTransforms(_soaOut, _scenes.graph.changedNodes());
+        }) };
+        uint64_t _changed { };
+        const auto _soaIncremental { measure(_frames, [&](uint32_t frame) {
+            for (size_t i = 0; i < _scenes.roots.size(); i += SPIN_INTERVAL)
+            {
+                _scenes.graph.setRotation(_scenes.roots[i], spin(frame));
+            }
+            _changed += _scenes.graph.update();
+            _scenes.graph.writeTransforms(_soaOut, _scenes.graph.changedNodes());
+        }) };
+
+        const auto _perNode = [&](double milliseconds) { return milliseconds * 1e6 / _nodes; };
+        std::cout << std::fixed << std::setprecision(3)
+            << _nodes << " nodes (" << _instances << " instances), " << _frames << " frames, max difference "
+            << std::scientific << _maxError << std::fixed << "\n"
+            << "\tAoS glm, all nodes      " << _aos << " ms (" << _perNode(_aos) << " ns/node)\n"
+            << "\tSoA SIMD, all nodes     " << _soaFull << " ms (" << _perNode(_soaFull) << " ns/node, "
+            << _aos / _soaFull << "x)\n"
+            << "\tSoA SIMD, 1/" << SPIN_INTERVAL << " dirty      " << _soaIncremental << " ms ("
+            << _changed / _frames << " nodes changed per frame, " << _aos / _soaIncremental << "x)\n";
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+// Shared declarations of the bindless scene, mirrored by src/scene.hpp, src/scene_graph.hpp and the
+// push constants in src/indirect_renderer.hpp.
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Quantized by src/mesh_optimizer.cpp, decodeVertex() unpacks it.
+struct Vertex
+{
+    // Half floats x, y and z, the upper half of positionZ is padding.
+    uint positionXY;
+    uint positionZ;
+    // Octahedral unit normal, two snorm16.
+    uint normal;
+    // Two unorm16.
+    uint uv;
+};
+
+// Inverse of encodeOctahedral() in src/mesh_optimizer.cpp.
+vec3 decodeOctahedral(vec2 encoded)
+{
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    const float fold = max(-normal.z, 0.0);
+    normal.xy += vec2(normal.x >= 0.0 ? -fold : fold, normal.y >= 0.0 ? -fold : fold);
+    return normalize(normal);
+}
+
+void decodeVertex(Vertex vertex, out vec3 position, out vec3 normal, out vec2 uv)
+{
+    position = vec3(unpackHalf2x16(vertex.positionXY), unpackHalf2x16(vertex.positionZ).x);
+    normal = decodeOctahedral(unpackSnorm2x16(vertex.normal));
+    uv = unpackUnorm2x16(vertex.uv);
+}
+
+// Mesh value of nodes that only carry a transform.
+const uint NO_MESH = 0xffffffffu;
+
+struct Instance
+{
+    vec4 color;
+    uint mesh;
+    uint texture;
+    uint padding0;
+    uint padding1;
+};
+
+struct Transform
+{
+    // Rows of the 3x4 world matrix.
+    vec4 rows[3];
+    // World bounding sphere: xyz center, w radius.
+    vec4 bounds;
+};
+
+struct MeshInfo
+{
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    float radius;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint padding0;
+    uint padding1;
+};
+
+struct Meshlet
+{
+    // Mesh space sphere: xyz center, w radius.
+    vec4 bounds;
+    // Normal cone: xyz axis, w sine of its half angle, 1 for cones too wide to cull.
+    vec4 cone;
+    uint firstIndex;
+    uint indexCount;
+    uint padding0;
+    uint padding1;
+};
+
+struct DrawCommand
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+struct FrameUniforms
+{
+    mat4 viewProjection;
+    // Camera the Hi-Z pyramid was rendered with, i.e. the previous frame's.
+    mat4 previousViewProjection;
+    vec4 frustumPlanes[6];
+    vec4 cameraPosition;
+    // Hi-Z pyramid: texture index, level count (0 disables the occlusion test), depth buffer size.
+    uvec4 pyramid;
+};
+
+// Every buffer lives in the one storage buffer array at binding 0, the blocks below are just
+// different views of it. FrameUniforms live in the allocator's transient ring, one element per frame.
+layout(set = 0, binding = 0) readonly buffer FrameRing { FrameUniforms frames[]; } frameRings[];
+
+layout(set = 0, binding = 0) readonly buffer VertexBuffer { Vertex vertices[]; } vertexBuffers[];
+layout(set = 0, binding = 0) readonly buffer InstanceBuffer { Instance instances[]; } instanceBuffers[];
+layout(set = 0, binding = 0) readonly buffer TransformBuffer { Transform transforms[]; } transformBuffers[];
+layout(set = 0, binding = 0) readonly buffer MeshBuffer { MeshInfo meshes[]; } meshBuffers[];
+layout(set = 0, binding = 0) readonly buffer MeshletBuffer { Meshlet meshlets[]; } meshletBuffers[];
+layout(set = 0, binding = 0) writeonly buffer DrawBuffer { DrawCommand commands[]; } drawBuffers[];
+layout(set = 0, binding = 0) buffer CountBuffer
+{
+    uint drawCount;
+    uint frustumCulled;
+    uint occlusionCulled;
+    // Meshlets of visible instances rejected by their own frustum or normal cone test.
+    uint clusterCulled;
+} countBuffers[];
+
+layout(set = 0, binding = 1) uniform sampler2D textures[];
+
+// Bindless indices of this frame's buffers.
+layout(push_constant) uniform PushConstants
+{
+    uint frame;
+    uint vertices;
+    uint instances;
+    uint meshes;
+    uint draws;
+    uint count;
+    uint instanceCount;
+    uint transforms;
+    uint meshlets;
+    uint frameRing;
+} pc;
@@ -0,0 +1,18 @@
+#version 460
+#include "common.glsl"
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec2 inUv;
+layout(location = 2) in vec4 inColor;
+layout(location = 3) flat in uint inTexture;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 LIGHT_DIRECTION = normalize(vec3(0.4, 0.8, 0.3));
+
+void main()
+{
+    const float diffuse = 0.25 + 0.75 * max(dot(normalize(inNormal), LIGHT_DIRECTION), 0.0);
+    const vec4 albedo = texture(textures[nonuniformEXT(inTexture)], inUv) * inColor;
+    outColor = vec4(albedo.rgb * diffuse, albedo.a);
+}
@@ -0,0 +1,29 @@
+#version 460
+#include "common.glsl"
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec2 outUv;
+layout(location = 2) out vec4 outColor;
+layout(location = 3) flat out uint outTexture;
+
+// Vertex pulling: no vertex input state, gl_VertexIndex already includes the draw's vertexOffset
+// and gl_InstanceIndex is the instance the cull pass stored in firstInstance.
+void main()
+{
+    const Instance instance = instanceBuffers[pc.instances].instances[gl_InstanceIndex];
+    const Transform transform = transformBuffers[pc.transforms].transforms[gl_InstanceIndex];
+    vec3 vertexPosition;
+    vec3 vertexNormal;
+    vec2 vertexUv;
+    decodeVertex(vertexBuffers[pc.vertices].vertices[gl_VertexIndex], vertexPosition, vertexNormal, vertexUv);
+
+    const vec4 local = vec4(vertexPosition, 1.0);
+    const vec3 position = vec3(dot(transform.rows[0], local), dot(transform.rows[1], local), dot(transform.rows[2], local));
+    gl_Position = frameRings[pc.frameRing].frames[pc.frame].viewProjection * vec4(position, 1.0);
+    // Scale is uniform, so the upper 3x3 transforms normals too, the fragment shader renormalizes.
+    outNormal = vec3(dot(transform.rows[0].xyz, vertexNormal), dot(transform.rows[1].xyz, vertexNormal),
+        dot(transform.rows[2].xyz, vertexNormal));
+    outUv = vertexUv;
+    outColor = instance.color;
+    outTexture = instance.texture;
+}
@@ -0,0 +1,299 @@
+#include "app_config.hpp"
+
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    uint32_t parseUint(std::string_view option, std::string_view value)
+    {
+        uint32_t result { };
+        const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (ec != std::errc() || ptr != value.data() + value.size())
+        {
+            throw std::runtime_error("Invalid value '" + std::string(value) + "' for " + std::string(option));
+        }
+        return result;
+    }
+
+    PresentPolicy parsePresentPolicy(std::string_view option, std::string_view value)
+    {
+        if (value == "low-latency")
+        {
+            return PresentPolicy::LowLatency;
+        }
+        if (value == "power-saving")
+        {
+            return PresentPolicy::PowerSaving;
+        }
+        if (value == "uncapped")
+        {
+            return PresentPolicy::Uncapped;
+        }
+        throw std::runtime_error("Invalid value '" + std::string(value) + "' for " + std::string(option)
+            + ", expected low-latency, power-saving or uncapped");
+    }
+
+    ValidationSeverity parseValidationSeverity(std::string_view option, std::string_view value)
+    {
+        if (value == "verbose")
+        {
+            return ValidationSeverity::Verbose;
+        }
+        if (value == "info")
+        {
+            return ValidationSeverity::Info;
+        }
+        if (value == "warning")
+        {
+            return ValidationSeverity::Warning;
+        }
+        if (value == "error")
+        {
+            return ValidationSeverity::Error;
+        }
+        throw std::runtime_error("Invalid value '" + std::string(value) + "' for " + std::string(option)
+            + ", expected verbose, info, warning or error");
+    }
+
+    // Comma separated list of general, validation and performance.
+    void parseValidationTypes(std::string_view option, std::string_view value, ValidationConfig& validation)
+    {
+        validation.general = validation.validation = validation.performance = false;
+        while (!value.empty())
+        {
+            const auto _comma { value.find(',') };
+            const auto _type { value.substr(0, _comma) };
+            if (_type == "general")
+            {
+                validation.general = true;
+            }
+            else if (_type == "validation")
+            {
+                validation.validation = true;
+            }
+            else if (_type == "performance")
+            {
+                validation.performance = true;
+            }
+            else
+            {
+                throw std::runtime_error("Invalid value '" + std::string(_type) + "' for " + std::string(option)
+                    + ", expected general, validation or performance");
+            }
+            value = _comma == std::string_view::npos ? std::string_view { } : value.substr(_comma + 1);
+        }
+    }
+
+    bool envFlag(const char* name)
+    {
+        const char* value = std::getenv(name);
+        return value && std::string_view(value) != "0" && std::string_view(value) != "";
+    }
+
+    void printUsage(std::string_view program)
+    {
+        std::cout << "Usage: " << program << " [options]\n"
+            << "\t--headless            Render offscreen, no window or swapchain (env VKP_HEADLESS=1)\n"
+            << "\t--frames <n>          Stop after n frames\n"
+            << "\t--width <px>          Render target width\n"
+            << "\t--height <px>         Render target height\n"
+            << "\t--offscreen-images <n> Offscreen render targets cycled in headless mode\n"
+            << "\t--frames-in-flight <n> Frames recorded ahead of the GPU\n"
+            << "\t--draws <n>           Record n clear-rect draws per frame instead of the GPU-driven scene\n"
+            << "\t--instances <n>       Instances in the GPU-driven scene (default 10000)\n"
+            << "\t--record-threads <n>  Command recording threads (default: cores - 1)\n"
+            << "\t--pipeline-cache <file> Pipeline cache location, \"\" disables it\n"
+            << "\t--device-snapshot <file> Cached GPU capabilities location, \"\" always probes every GPU\n"
+            << "\t--verbose             List instance extensions, layers and all GPUs at startup (env VKP_VERBOSE=1)\n"
+            << "\t--device <n|name>     GPU index or name substring, default picks the best (env VKP_DEVICE)\n"
+            << "\t--present-policy <p> low-latency (default), power-saving or uncapped (env VKP_PRESENT_POLICY)\n"
+            << "\t--trace <file.json>   Write a Chrome trace of CPU scopes and GPU timestamps\n"
+            << "\t--staging-ring <MiB>  Staging ring size for streaming uploads\n"
+            << "\t--bench-upload <MiB>  Compare async and blocking upload throughput\n"
+            << "\t--assets <file.vkpa>  Stream scene meshes and textures from a baked asset archive\n"
+            << "\t--bench-assets        Compare the streaming asset loader against a plain one\n"
+            << "\t--render-pass         Use render pass objects even where dynamic rendering is available\n"
+            << "\t--resize-every <n>    Resize the render target every n frames\n"
+            << "\t--validation, --no-validation  Khronos validation layer, default on in debug builds (env VKP_VALIDATION)\n"
+            << "\t--validation-severity <s> Lowest logged severity: verbose, info, warning (default) or error\n"
+            << "\t--validation-types <list> Logged message types, comma separated: general,validation,performance\n"
+            << "\t--validation-repeats <n> Print each message ID n times, then only count it (default 5, 0 = all)\n";
+    }
+}
+
+AppConfig parseCommandLine(int argc, char** argv)
+{
+    AppConfig config { };
+    config.headless = envFlag("VKP_HEADLESS");
+    config.verbose = envFlag("VKP_VERBOSE");
+    if (const char* _device = std::getenv("VKP_DEVICE"))
+    {
+        config.devicePreference = _device;
+    }
+    if (const char* _policy = std::getenv("VKP_PRESENT_POLICY"))
+    {
+        config.presentPolicy = parsePresentPolicy("VKP_PRESENT_POLICY", _policy);
+    }
+    if (std::getenv("VKP_VALIDATION"))
+    {
+        config.validation.enabled = envFlag("VKP_VALIDATION");
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view _arg { argv[i] };
+        const auto _nextValue = [&]() -> std::string_view
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::runtime_error("Missing value for " + std::string(_arg));
+            }
+            return argv[++i];
+        };
+
+        if (_arg == "--headless")
+        {
+            config.headless = true;
+        }
+        else if (_arg == "--frames")
+        {
+            config.frameCount = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--width")
+        {
+            config.width = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--height")
+        {
+            config.height = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--offscreen-images")
+        {
+            config.offscreenImageCount = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--frames-in-flight")
+        {
+            config.framesInFlight = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--draws")
+        {
+            config.drawCount = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--instances")
+        {
+            config.instanceCount = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--record-threads")
+        {
+            config.recordThreads = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--pipeline-cache")
+        {
+            config.pipelineCachePath = _nextValue();
+        }
+        else if (_arg == "--device-snapshot")
+        {
+            config.deviceSnapshotPath = _nextValue();
+        }
+        else if (_arg == "--verbose")
+        {
+            config.verbose = true;
+        }
+        else if (_arg == "--device")
+        {
+            config.devicePreference = _nextValue();
+        }
+        else if (_arg == "--present-policy")
+        {
+            config.presentPolicy = parsePresentPolicy(_arg, _nextValue());
+        }
+        else if (_arg == "--trace")
+        {
+            config.tracePath = _nextValue();
+        }
+        else if (_arg == "--staging-ring")
+        {
+            config.stagingRingMiB = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--bench-upload")
+        {
+            config.uploadBenchmarkMiB = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--assets")
+        {
+            config.assetArchive = _nextValue();
+        }
+        else if (_arg == "--bench-assets")
+        {
+            config.assetBenchmark = true;
+        }
+        else if (_arg == "--render-pass")
+        {
+            config.renderPasses = true;
+        }
+        else if (_arg == "--resize-every")
+        {
+            config.resizeInterval = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--validation")
+        {
+            config.validation.enabled = true;
+        }
+        else if (_arg == "--no-validation")
+        {
+            config.validation.enabled = false;
+        }
+        else if (_arg == "--validation-severity")
+        {
+            config.validation.minSeverity = parseValidationSeverity(_arg, _nextValue());
+        }
+        else if (_arg == "--validation-types")
+        {
+            parseValidationTypes(_arg, _nextValue(), config.validation);
+        }
+        else if (_arg == "--validation-repeats")
+        {
+            config.validation.maxRepeats = parseUint(_arg, _nextValue());
+        }
+        else if (_arg == "--help" || _arg == "-h")
+        {
+            printUsage(argv[0]);
+            std::exit(EXIT_SUCCESS);
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option " + std::string(_arg) + ", see --help");
+        }
+    }
+
+    if (!config.width || !config.height)
+    {
+        throw std::runtime_error("Render target size must be non-zero!");
+    }
+    if (!config.offscreenImageCount)
+    {
+        throw std::runtime_error("At least one offscreen image is required!");
+    }
+    if (!config.framesInFlight)
+    {
+        throw std::runtime_error("At least one frame in flight is required!");
+    }
+    if (!config.stagingRingMiB)
+    {
+        throw std::runtime_error("Staging ring must be non-zero!");
+    }
+    if (config.assetBenchmark && config.assetArchive.empty())
+    {
+        throw std::runtime_error("--bench-assets needs an archive, see --assets!");
+    }
+    if (!config.validation.general && !config.validation.validation && !config.validation.performance)
+    {
+        throw std::runtime_error("--validation-types needs at least one message type!");
+    }
+    return config;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+constexpr uint32_t WIDTH = 800;
+constexpr uint32_t HEIGHT = 600;
+
+constexpr uint32_t DEFAULT_HEADLESS_FRAME_COUNT = 300;
+
+// What the swapchain present mode and image count are tuned for, see choosePresentConfig().
+enum class PresentPolicy
+{
+    LowLatency,
+    PowerSaving,
+    Uncapped
+};
+
+// Lowest debug messenger severity that is logged.
+enum class ValidationSeverity
+{
+    Verbose,
+    Info,
+    Warning,
+    Error
+};
+
+struct ValidationConfig
+{
+    // Khronos validation layer and debug messenger, on by default in debug builds.
+    bool enabled
+    {
+#ifdef NDEBUG
+        false
+#else
+        true
+#endif
+    };
+    ValidationSeverity minSeverity  { ValidationSeverity::Warning };
+    // Message types that are logged.
+    bool general                    { true };
+    bool validation                 { true };
+    bool performance                { true };
+    // Times the same message ID is printed before further repeats are only counted, 0 prints all.
+    uint32_t maxRepeats             { 5 };
+};
+
+struct AppConfig
+{
+    // Render into offscreen images instead of a GLFW window + swapchain.
+    bool headless                   { };
+    uint32_t width                  { WIDTH };
+    uint32_t height                 { HEIGHT };
+    // Number of frames to render before run() returns, 0 means until the window is closed
+    // (or DEFAULT_HEADLESS_FRAME_COUNT when headless).
+    uint32_t frameCount             { };
+    // Number of offscreen render targets cycled through in headless mode.
+    uint32_t offscreenImageCount    { 3 };
+    // Frames the CPU may record ahead of the GPU, each with its own command pool and sync objects.
+    uint32_t framesInFlight         { 2 };
+    // Size of the generated clear-rect draw list recorded every frame, replaces the GPU-driven
+    // scene when non-zero.
+    uint32_t drawCount              { };
+    // Instances in the GPU-driven scene, culled and drawn without per-draw CPU work.
+    uint32_t instanceCount          { 10000 };
+    // Worker threads recording secondary command buffers, 0 picks one per spare core.
+    uint32_t recordThreads          { };
+    // Where the VkPipelineCache blob is persisted between runs, empty disables persistence.
+    std::filesystem::path pipelineCachePath { "pipeline_cache.bin" };
+    // Where the chosen GPU's capabilities are cached between runs (see device_snapshot.hpp), empty
+    // always probes every GPU.
+    std::filesystem::path deviceSnapshotPath { "device_snapshot.bin" };
+    // Print instance extensions, layers and every GPU probed at startup. Off, the device snapshot
+    // is used when it matches and the listings are only printed to explain a failure.
+    bool verbose                    { };
+    // GPU to use instead of the best scoring one: an index from the startup GPU list or part of
+    // the device name.
+    std::string devicePreference;
+    PresentPolicy presentPolicy     { PresentPolicy::LowLatency };
+    // Chrome trace JSON of CPU scopes and GPU timestamps written when run() finishes, empty disables it.
+    std::filesystem::path tracePath;
+    // Size of the persistently mapped staging ring used for streaming uploads, in MiB.
+    uint32_t stagingRingMiB         { 32 };
+    // When non-zero, run() streams this many MiB to the GPU while rendering and compares the
+    // transfer-queue path against blocking uploads on the graphics queue.
+    uint32_t uploadBenchmarkMiB     { };
+    // Packed asset archive (see tools/asset_baker.cpp) the scene's meshes and textures are
+    // streamed from, empty generates them in memory instead.
+    std::filesystem::path assetArchive;
+    // Load assetArchive with a plain single-threaded reader first and report both load times.
+    bool assetBenchmark             { };
+    ValidationConfig validation;
+    // Draw through VkRenderPass and VkFramebuffer objects even where dynamic rendering is available.
+    bool renderPasses               { };
+    // Resize the render target every n frames, alternating between width x height and three
+    // quarters of it. 0 never resizes.
+    uint32_t resizeInterval         { };
+};
+
+// Parses the command line, environment overrides (VKP_HEADLESS=1, VKP_DEVICE, VKP_PRESENT_POLICY,
+// VKP_VALIDATION=0|1, VKP_VERBOSE=1) are applied first so that explicit options always win. Throws std::runtime_error on malformed input.
+AppConfig parseCommandLine(int argc, char** argv);
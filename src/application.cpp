@@ -0,0 +1,1884 @@
+#include "application.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "app_config.hpp"
+#include "asset_archive.hpp"
+#include "asset_streamer.hpp"
+#include "bindless_set.hpp"
+#include "deferred_deleter.hpp"
+#include "device_selector.hpp"
+#include "device_snapshot.hpp"
+#include "draw_list.hpp"
+#include "frame_arena.hpp"
+#include "frame_stats.hpp"
+#include "gpu_allocator.hpp"
+#include "heap_counter.hpp"
+#include "hiz_pyramid.hpp"
+#include "indirect_renderer.hpp"
+#include "mesh_optimizer.hpp"
+#include "parallel_recorder.hpp"
+#include "pipeline_cache.hpp"
+#include "present_policy.hpp"
+#include "profiler.hpp"
+#include "render_graph.hpp"
+#include "scene.hpp"
+#include "scene_archive.hpp"
+#include "scene_assets.hpp"
+#include "staging_uploader.hpp"
+#include "startup_timings.hpp"
+#include "validation_log.hpp"
+#include "vulkan_dispatch.hpp"
+
+constexpr std::array<const char*, 1> validationLayers
+{
+    "VK_LAYER_KHRONOS_validation",
+};
+
+// Persistently mapped ring for per-frame data: the scene's camera uniforms and cull readback.
+constexpr VkDeviceSize TRANSIENT_RING_SIZE = 8ull << 20;
+constexpr VkDeviceSize UPLOAD_BENCHMARK_CHUNK = 4ull << 20;
+// CPU scratch per frame in flight, see FrameArena. Grows by itself if a frame needs more.
+constexpr size_t FRAME_ARENA_SIZE = 64 << 10;
+// Heap allocations only count as steady state after this many frames: scene uploads, first use
+// growth of reused containers and frame arena growth are over by then.
+constexpr uint32_t HEAP_WARMUP_FRAMES = 60;
+
+// Semaphore wait and barrier source stage of the present queue's ownership acquire.
+constexpr VkPipelineStageFlags PRESENT_ACQUIRE_STAGE = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+// Capacity of the global bindless descriptor set.
+constexpr uint32_t BINDLESS_MAX_BUFFERS = 256;
+constexpr uint32_t BINDLESS_MAX_TEXTURES = 1024;
+// Scene animation advances by a fixed step per frame, so headless runs render identical frames.
+constexpr float SCENE_TIME_STEP = 1.0f / 60.0f;
+
+// Descriptor indexing and draw-indirect-count are core from 1.2 on.
+constexpr uint32_t REQUIRED_API_VERSION = VK_API_VERSION_1_2;
+// What the instance asks for, so that 1.3 devices expose dynamic rendering and synchronization2 as core.
+constexpr uint32_t INSTANCE_API_VERSION = VK_API_VERSION_1_3;
+
+constexpr std::array<const char*, 1> deviceExtensions
+{
+    VK_KHR_SWAPCHAIN_EXTENSION_NAME
+};
+
+class HelloTriangleApplication {
+public:
+    HelloTriangleApplication(const AppConfig& appConfig)
+        : config(appConfig)
+    {
+        if (!config.headless)
+        {
+            startupTimings.measure("initWindow", [&] { initWindow(); });
+        }
+        initVulkan();
+    }
+
+    ~HelloTriangleApplication()
+    {
+        vkDeviceWaitIdle(device);
+        deferredDeleter.flush();
+        if (pipelineCache)
+        {
+            pipelineCache->save();
+            pipelineCache.reset();
+        }
+        if (debugMessenger)
+        {
+            vkDestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+        }
+        profiler.reset();
+        parallelRecorder.reset();
+        renderGraph.reset();
+        hiZPyramid.reset();
+        indirectRenderer.reset();
+        if (stagingUploader)
+        {
+            stagingUploader->waitIdle();
+            destroySceneAssets(device, *gpuAllocator, comparisonAssets);
+        }
+        bindlessSet.reset();
+        stagingUploader.reset();
+        destroyFrameResources();
+        for (auto framebuffer : swapChainFramebuffers)
+        {
+            vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+        for (auto imageView : swapChainImageViews)
+        {
+            vkDestroyImageView(device, imageView, nullptr);
+        }
+        vkDestroyRenderPass(device, renderPass, nullptr);
+        for (auto& image : offscreenImages)
+        {
+            gpuAllocator->destroyImage(image);
+        }
+        gpuAllocator.reset();
+        if (!config.headless)
+        {
+            vkDestroySwapchainKHR(device, swapChain, nullptr);
+            vkDestroySurfaceKHR(instance, surface, nullptr);
+        }
+        vkDestroyDevice(device, nullptr);
+        vkDestroyInstance(instance, nullptr);
+        // Only now, the layer may still report while the instance is destroyed.
+        validationLog.reset();
+        if (window)
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+    }
+
+    void run()
+    {
+        runReport.deviceName = deviceInfo.properties.deviceName;
+        if (config.uploadBenchmarkMiB)
+        {
+            reportStartup();
+            runUploadBenchmark();
+            return;
+        }
+
+        const uint32_t _frameLimit { config.frameCount || !config.headless ? config.frameCount : DEFAULT_HEADLESS_FRAME_COUNT };
+        const auto _start { std::chrono::steady_clock::now() };
+        std::chrono::duration<double, std::milli> _drawTime { };
+        uint64_t _warmupAllocations { };
+
+        while (!_frameLimit || frameNumber < _frameLimit)
+        {
+            if (window)
+            {
+                if (glfwWindowShouldClose(window))
+                {
+                    break;
+                }
+                glfwPollEvents();
+            }
+            if (config.resizeInterval && frameNumber && frameNumber % config.resizeInterval == 0)
+            {
+                resizeRenderTarget();
+            }
+            if (frameNumber == HEAP_WARMUP_FRAMES)
+            {
+                _warmupAllocations = heapAllocationCount();
+            }
+            const auto _drawStart { std::chrono::steady_clock::now() };
+            if (!frameNumber)
+            {
+                startupTimings.measure("first frame", [&] { drawFrame(); });
+                reportStartup();
+            }
+            else
+            {
+                drawFrame();
+            }
+            _drawTime += std::chrono::steady_clock::now() - _drawStart;
+        }
+        vkDeviceWaitIdle(device);
+
+        const std::chrono::duration<double, std::milli> _elapsed { std::chrono::steady_clock::now() - _start };
+        runReport.frames = static_cast<uint32_t>(frameNumber);
+        runReport.renderMs = _elapsed.count();
+        runReport.cpuMsPerFrame = frameNumber ? (_drawTime.count() - frameWaitMs) / frameNumber : 0.0;
+        const auto _allocatorStats { gpuAllocator->stats() };
+        runReport.gpuAllocations = _allocatorStats.totalAllocations;
+        runReport.deviceMemoryAllocations = _allocatorStats.deviceMemoryAllocations;
+        if (frameNumber > HEAP_WARMUP_FRAMES)
+        {
+            runReport.heapAllocationsPerFrame = static_cast<double>(heapAllocationCount() - _warmupAllocations)
+                / static_cast<double>(frameNumber - HEAP_WARMUP_FRAMES);
+        }
+        std::cout << "Rendered " << frameNumber << (config.headless ? " offscreen" : "") << " frames in "
+            << _elapsed.count() << " ms (" << frameNumber / (_elapsed.count() / 1000.0) << " frames/s, "
+            << frames.size() << " in flight)\n";
+        frameStats.report(std::cout);
+        profiler->report(std::cout);
+        if (indirectRenderer)
+        {
+            indirectRenderer->reportStats(std::cout);
+        }
+        renderGraph->reportStats(std::cout);
+        if (!config.tracePath.empty())
+        {
+            if (profiler->writeChromeTrace(config.tracePath))
+            {
+                std::cout << "Wrote frame trace to " << config.tracePath << '\n';
+            }
+            else
+            {
+                std::cerr << "Failed to write frame trace to " << config.tracePath << '\n';
+            }
+        }
+        if (parallelRecorder)
+        {
+            parallelRecorder->reportStats(std::cout);
+        }
+        gpuAllocator->reportStats(std::cout);
+        reportFrameMemory(std::cout);
+    }
+
+    const RunReport& report() const { return runReport; }
+
+    // Frame arena use, and the heap allocations the frame loop still makes once warmed up.
+    void reportFrameMemory(std::ostream& out)
+    {
+        FrameArenaStats _total { };
+        for (const auto& frame : frames)
+        {
+            const auto& _stats { frame.arena->stats() };
+            _total.allocations += _stats.allocations;
+            _total.overflowAllocations += _stats.overflowAllocations;
+            _total.peakBytes = std::max(_total.peakBytes, _stats.peakBytes);
+        }
+        runReport.frameArenaPeakBytes = _total.peakBytes;
+        out << "Frame arenas: " << _total.allocations << " allocations, peak " << _total.peakBytes
+            << " bytes per frame, " << _total.overflowAllocations << " served by the heap\n";
+        if (frameNumber > HEAP_WARMUP_FRAMES)
+        {
+            out << "Heap allocations: " << runReport.heapAllocationsPerFrame << " per frame after the first "
+                << HEAP_WARMUP_FRAMES << " frames\n";
+        }
+    }
+
+    // Streams config.uploadBenchmarkMiB to a device-local buffer while rendering, one chunk per frame:
+    // first through the staging ring on the transfer queue, then as blocking copies on the graphics
+    // queue (submit + vkQueueWaitIdle). Reports throughput and the worst frame time of both.
+    void runUploadBenchmark()
+    {
+        const VkDeviceSize _total { VkDeviceSize { config.uploadBenchmarkMiB } << 20 };
+        auto _destination { gpuAllocator->createBuffer(_total, VK_BUFFER_USAGE_TRANSFER_DST_BIT, MemoryUsage::GpuOnly) };
+        std::vector<std::byte> _chunk(UPLOAD_BENCHMARK_CHUNK);
+        for (size_t i = 0; i < _chunk.size(); i++)
+        {
+            _chunk[i] = static_cast<std::byte>(i * 31);
+        }
+
+        const auto _measure = [&](const char* label, const std::function<void(VkDeviceSize, VkDeviceSize)>& upload,
+            const std::function<bool()>& finished)
+        {
+            VkDeviceSize _offset { };
+            double _worstFrameMs { };
+            uint32_t _frames { };
+            const auto _start { std::chrono::steady_clock::now() };
+            while (_offset < _total || !finished())
+            {
+                const auto _frameStart { std::chrono::steady_clock::now() };
+                if (window)
+                {
+                    glfwPollEvents();
+                }
+                if (_offset < _total)
+                {
+                    const auto _size { std::min(UPLOAD_BENCHMARK_CHUNK, _total - _offset) };
+                    upload(_offset, _size);
+                    _offset += _size;
+                }
+                drawFrame();
+                const std::chrono::duration<double, std::milli> _frameTime { std::chrono::steady_clock::now() - _frameStart };
+                _worstFrameMs = std::max(_worstFrameMs, _frameTime.count());
+                _frames++;
+            }
+            vkDeviceWaitIdle(device);
+            const std::chrono::duration<double> _elapsed { std::chrono::steady_clock::now() - _start };
+            const auto _throughput { _total / 1e6 / _elapsed.count() };
+            std::cout << "\t" << label << ": " << _throughput << " MB/s, worst frame "
+                << _worstFrameMs << " ms over " << _frames << " frames\n";
+            return _throughput;
+        };
+
+        std::cout << "Upload benchmark: " << config.uploadBenchmarkMiB << " MiB in " << (UPLOAD_BENCHMARK_CHUNK >> 20)
+            << " MiB chunks\n";
+
+        runReport.asyncUploadMBps = _measure(stagingUploader->usesDedicatedQueue() ? "async, dedicated transfer queue" : "async, shared graphics queue",
+            [&](VkDeviceSize offset, VkDeviceSize size)
+            {
+                stagingUploader->uploadBuffer(_destination.buffer, offset, std::span(_chunk).first(size));
+                stagingUploader->flush();
+            },
+            [&] { return !stagingUploader->hasPendingWork(); });
+
+        auto _staging { gpuAllocator->createBuffer(UPLOAD_BENCHMARK_CHUNK, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::Upload) };
+        const auto _pool { createCommandPool(graphicsQueueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT) };
+        const auto _commandBuffer { allocateCommandBuffer(_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY) };
+        runReport.blockingUploadMBps = _measure("blocking, graphics queue",
+            [&](VkDeviceSize offset, VkDeviceSize size)
+            {
+                std::memcpy(_staging.allocation.mapped, _chunk.data(), size);
+                vkResetCommandPool(device, _pool, 0);
+                VkCommandBufferBeginInfo beginInfo {
+                    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+                };
+                vkBeginCommandBuffer(_commandBuffer, &beginInfo);
+                const VkBufferCopy _region { 0, offset, size };
+                vkCmdCopyBuffer(_commandBuffer, _staging.buffer, _destination.buffer, 1, &_region);
+                vkEndCommandBuffer(_commandBuffer);
+                VkSubmitInfo submitInfo {
+                    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                    .commandBufferCount = 1,
+                    .pCommandBuffers = &_commandBuffer
+                };
+                if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("Failed to submit upload!");
+                }
+                vkQueueWaitIdle(graphicsQueue);
+            },
+            [] { return true; });
+
+        vkDestroyCommandPool(device, _pool, nullptr);
+        gpuAllocator->destroyBuffer(_staging);
+        gpuAllocator->destroyBuffer(_destination);
+        const auto _allocatorStats { gpuAllocator->stats() };
+        runReport.gpuAllocations = _allocatorStats.totalAllocations;
+        runReport.deviceMemoryAllocations = _allocatorStats.deviceMemoryAllocations;
+        gpuAllocator->reportStats(std::cout);
+    }
+
+private:
+
+    void initWindow()
+    {
+        glfwInit();
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+
+        window = glfwCreateWindow(config.width, config.height, "Vulkan", nullptr, nullptr);
+        glfwSetWindowUserPointer(window, this);
+        glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+    }
+
+    static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
+    {
+        auto* _app { static_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window)) };
+        _app->framebufferResized = true;
+    }
+
+    void initVulkan()
+    {
+        startupTimings.measure("createInstance", [&] { createInstance(); });
+        if (config.validation.enabled)
+        {
+            startupTimings.measure("setupDebugMessenger", [&] { setupDebugMessenger(); });
+        }
+        if (!config.headless)
+        {
+            startupTimings.measure("createSurface", [&] { createSurface(); });
+        }
+        startupTimings.measure("pickPhysicalDevice", [&] { pickPhysicalDevice(); });
+        startupTimings.measure("createLogicalDevice", [&] { createLogicalDevice(); });
+        startupTimings.measure("createGpuAllocator", [&] { createGpuAllocator(); });
+        startupTimings.measure("createStagingUploader", [&] { createStagingUploader(); });
+        startupTimings.measure("createPipelineCache", [&] { createPipelineCache(); });
+        if (config.headless)
+        {
+            startupTimings.measure("createOffscreenTargets", [&] { createOffscreenTargets({ config.width, config.height }); });
+        }
+        else
+        {
+            startupTimings.measure("createSwapChain", [&] { createSwapChain(); });
+        }
+        startupTimings.measure("createImageViews", [&] { createImageViews(); });
+        startupTimings.measure("createRenderPass", [&] { createRenderPass(); });
+        startupTimings.measure("createFrameResources", [&] { createFrameResources(); });
+        startupTimings.measure("createParallelRecorder", [&] { createParallelRecorder(); });
+        startupTimings.measure("createIndirectRenderer", [&] { createIndirectRenderer(); });
+        startupTimings.measure("createRenderGraph", [&] { createRenderGraph(); });
+        startupTimings.measure("createFramebuffers", [&] { createFramebuffers(); });
+        startupTimings.measure("createProfiler", [&] { createProfiler(); });
+        if (!config.headless)
+        {
+            std::cout << "Presenting with " << presentModeName(presentConfig.presentMode) << ", "
+                << swapChainImages.size() << " swapchain images\n";
+        }
+    }
+
+    // Time to first frame, or to the end of initVulkan() when no frame is rendered the usual way.
+    void reportStartup()
+    {
+        std::string _label { pipelineCache->isWarm() ? "warm pipeline cache" : "cold pipeline cache" };
+        _label += deviceSnapshotHit ? ", cached device capabilities" : ", probed devices";
+        startupTimings.report(std::cout, _label);
+        runReport.startupMs = startupTimings.totalMs();
+    }
+
+    void setupDebugMessenger()
+    {
+        const auto createInfo { validationLog->messengerCreateInfo() };
+        if (!vkCreateDebugUtilsMessengerEXT ||
+            vkCreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to setup debug messenger!");
+        }
+    }
+
+    bool checkValidationLayerSupport()
+    {
+        uint32_t layerCount {};
+        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+
+        std::vector<VkLayerProperties> availableLayers(layerCount);
+        vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+        for (const auto& layer : validationLayers)
+        {
+            bool layerFound { };
+            for (const auto& availableLayer : availableLayers)
+            {
+                if (std::strcmp(layer, availableLayer.layerName) == 0)
+                {
+                    std::cout << "Validation layer " << layer << " found!\n";
+                    layerFound = true;
+                    break;
+                }
+            }
+            if (!layerFound)
+            {
+                std::cout << "Required validation layer " << layer << " not found!\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::vector<const char*> getRequiredExtensions()
+    {
+        // Headless runs never touch GLFW, so there is no surface extension to ask for.
+        std::vector<const char*> requiredExtensions;
+        if (!config.headless)
+        {
+            uint32_t numExts {};
+            const char** exts = glfwGetRequiredInstanceExtensions(&numExts);
+            requiredExtensions.assign(exts, exts + numExts);
+        }
+        if (config.validation.enabled)
+        {
+            requiredExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        if (config.verbose)
+        {
+            reportInstanceExtensions(requiredExtensions);
+        }
+        return requiredExtensions;
+    }
+
+    // Only with --verbose or to explain a failed vkCreateInstance(), enumerating extensions and
+    // layers costs the loader a scan of every manifest.
+    void reportInstanceExtensions(std::span<const char* const> requiredExtensions)
+    {
+        uint32_t extCount {};
+        vkEnumerateInstanceExtensionProperties(nullptr, &extCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extCount, extensions.data());
+
+        std::cout << "Available extensions:\n";
+        for (const auto& ext : extensions)
+        {
+            std::cout << '\t' << ext.extensionName << "\n";
+        }
+
+        for (const auto reqExt : requiredExtensions)
+        {
+            auto foundIt = std::find_if(extensions.begin(), extensions.end(), [reqExt](const auto& ext) {
+                return std::strcmp(ext.extensionName, reqExt) == 0;
+            });
+            if (foundIt == extensions.end())
+            {
+                std::cout << "\t\tExtension " << reqExt << " required but not available!\n";
+            }
+            else
+            {
+                std::cout << "Extension " << reqExt << " found.\n";
+            }
+        }
+    }
+
+    void createInstance()
+    {
+        loadGlobalDispatch();
+        if (config.validation.enabled)
+        {
+            if (config.verbose && !checkValidationLayerSupport())
+            {
+                throw std::runtime_error("Validation layers requested, but not available.");
+            }
+            validationLog = std::make_unique<ValidationLog>(config.validation);
+        }
+        VkApplicationInfo appInfo {
+            .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            .pApplicationName = "Hello Triangle",
+            .applicationVersion = VK_MAKE_API_VERSION(0, 1, 0, 0),
+            .pEngineName = "No Engine",
+            .engineVersion = VK_MAKE_API_VERSION(0, 1, 0, 0),
+            .apiVersion = INSTANCE_API_VERSION
+        };
+
+        VkInstanceCreateInfo instanceInfo {
+            .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            .pApplicationInfo = &appInfo,
+        };
+        // Also covers messages from vkCreateInstance and vkDestroyInstance themselves.
+        VkDebugUtilsMessengerCreateInfoEXT createInfo { };
+        if (config.validation.enabled)
+        {
+            createInfo = validationLog->messengerCreateInfo();
+            instanceInfo.enabledLayerCount = validationLayers.size();
+            instanceInfo.ppEnabledLayerNames = validationLayers.data();
+            instanceInfo.pNext = &createInfo;
+        }
+        else
+        {
+            instanceInfo.enabledLayerCount = 0;
+            instanceInfo.pNext = nullptr;
+        }
+
+        auto reqExts = getRequiredExtensions();
+        instanceInfo.enabledExtensionCount = reqExts.size();
+        instanceInfo.ppEnabledExtensionNames = reqExts.data();
+
+        const auto _result { vkCreateInstance(&instanceInfo, nullptr, &instance) };
+        if (_result == VK_ERROR_LAYER_NOT_PRESENT && !config.verbose)
+        {
+            checkValidationLayerSupport();
+            throw std::runtime_error("Validation layers requested, but not available.");
+        }
+        if (_result == VK_ERROR_EXTENSION_NOT_PRESENT && !config.verbose)
+        {
+            reportInstanceExtensions(reqExts);
+        }
+        if (_result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create vulkan instance!");
+        }
+        loadInstanceDispatch(instance);
+    }
+
+    void createSurface()
+    {
+        if (glfwCreateWindowSurface(instance, window, nullptr, &surface) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create window surface!");
+        }
+    }
+
+    // Checked by pickPhysicalDevice() and enabled as is by createLogicalDevice().
+    DeviceRequirements deviceRequirements() const
+    {
+        DeviceRequirements _requirements {
+            .apiVersion = REQUIRED_API_VERSION,
+            .extensions = requiredDeviceExtensions()
+        };
+        // GPU-driven rendering: the cull pass writes a variable number of indexed draws, each
+        // naming its instance through firstInstance.
+        _requirements.features.multiDrawIndirect = VK_TRUE;
+        _requirements.features.drawIndirectFirstInstance = VK_TRUE;
+        _requirements.features.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+        _requirements.features12.drawIndirectCount = VK_TRUE;
+        // The global bindless set, see BindlessSet.
+        _requirements.features12.descriptorIndexing = VK_TRUE;
+        _requirements.features12.runtimeDescriptorArray = VK_TRUE;
+        _requirements.features12.descriptorBindingPartiallyBound = VK_TRUE;
+        _requirements.features12.descriptorBindingVariableDescriptorCount = VK_TRUE;
+        _requirements.features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        _requirements.features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        _requirements.features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        return _requirements;
+    }
+
+    // Reuses the snapshot of last run's device when it still matches, only the surface dependent
+    // checks are redone. Otherwise every GPU is probed and the choice is snapshotted for next time.
+    void pickPhysicalDevice()
+    {
+        const auto _requirements { deviceRequirements() };
+        if (!config.verbose)
+        {
+            if (auto _cached = loadDeviceSnapshot(instance, config.deviceSnapshotPath, config.devicePreference))
+            {
+                evaluateDevice(*_cached, surface, _requirements);
+                if (_cached->suitable())
+                {
+                    std::cout << "GPU: " << _cached->properties.deviceName << " (cached capabilities)\n";
+                    deviceInfo = std::move(*_cached);
+                    physicalDevice = deviceInfo.device;
+                    deviceSnapshotHit = true;
+                    return;
+                }
+            }
+        }
+
+        const auto _devices { probeDevices(instance, surface, _requirements) };
+        const auto& _selected { selectDevice(_devices, config.devicePreference) };
+        if (config.verbose)
+        {
+            reportDevices(std::cout, _devices, _selected);
+        }
+        else
+        {
+            std::cout << "GPU: " << _selected.properties.deviceName << " (" << _devices.size()
+                << " probed, --verbose lists them)\n";
+        }
+        deviceInfo = _selected;
+        physicalDevice = deviceInfo.device;
+        saveDeviceSnapshot(config.deviceSnapshotPath, deviceInfo, config.devicePreference,
+            static_cast<uint32_t>(_devices.size()));
+    }
+
+    void createLogicalDevice()
+    {
+        const auto& indicies { deviceInfo.queueFamilies };
+
+        float queuePriority = 1.0f;
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+        std::set<uint32_t> uniqueQueueFamilies { indicies.graphicsFamily.value() };
+        if (indicies.presentFamily)
+        {
+            uniqueQueueFamilies.insert(indicies.presentFamily.value());
+        }
+        if (indicies.transferFamily)
+        {
+            uniqueQueueFamilies.insert(indicies.transferFamily.value());
+        }
+        auto _requirements { deviceRequirements() };
+        VkPhysicalDeviceFeatures2 deviceFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+            .pNext = &_requirements.features12,
+            .features = _requirements.features
+        };
+        // Archived textures are BC1: sampled as they are where the device can, decompressed while
+        // loading elsewhere.
+        VkFormatProperties _bc1Properties { };
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, VK_FORMAT_BC1_RGB_UNORM_BLOCK, &_bc1Properties);
+        compressedTextures = deviceInfo.features.textureCompressionBC
+            && (_bc1Properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+        deviceFeatures.features.textureCompressionBC = compressedTextures ? VK_TRUE : VK_FALSE;
+        // Dynamic rendering and synchronization2 go together: the main pass renders straight into
+        // the swapchain views and the render graph's barriers become vkCmdPipelineBarrier2.
+        dynamicRendering = deviceInfo.dynamicRendering && !config.renderPasses;
+        std::vector<const char*> _extensions(_requirements.extensions.begin(), _requirements.extensions.end());
+        VkPhysicalDeviceVulkan13Features _features13 {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+            .synchronization2 = VK_TRUE,
+            .dynamicRendering = VK_TRUE
+        };
+        VkPhysicalDeviceSynchronization2Features _synchronization2 {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+            .synchronization2 = VK_TRUE
+        };
+        VkPhysicalDeviceDynamicRenderingFeatures _dynamicRenderingFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES,
+            .pNext = &_synchronization2,
+            .dynamicRendering = VK_TRUE
+        };
+        if (dynamicRendering && deviceInfo.properties.apiVersion >= VK_API_VERSION_1_3)
+        {
+            _requirements.features12.pNext = &_features13;
+        }
+        else if (dynamicRendering)
+        {
+            _requirements.features12.pNext = &_dynamicRenderingFeatures;
+            _extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+            _extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        }
+        for (const auto& queueFamilyIndex : uniqueQueueFamilies)
+        {
+            VkDeviceQueueCreateInfo queueCreateInfo{
+                .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .queueFamilyIndex = queueFamilyIndex,
+                .queueCount = 1,
+                .pQueuePriorities = &queuePriority
+            };
+            queueCreateInfos.push_back(queueCreateInfo);
+        }
+        VkDeviceCreateInfo createInfo {
+            .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+            // Features go through the pNext chain so the 1.2 ones can be enabled too.
+            .pNext = &deviceFeatures,
+            .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
+            .pQueueCreateInfos = queueCreateInfos.data(),
+            .enabledLayerCount = 0,
+            .enabledExtensionCount = static_cast<uint32_t>(_extensions.size()),
+            .ppEnabledExtensionNames = _extensions.data(),
+            .pEnabledFeatures = nullptr,
+        };
+        if (config.validation.enabled)
+        {
+            createInfo.enabledLayerCount = validationLayers.size();
+            createInfo.ppEnabledLayerNames = validationLayers.data();
+        }
+
+        if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create logical device!");
+        }
+        // From here on device calls go straight to the driver.
+        loadDeviceDispatch(device);
+        if (dynamicRendering && (!vkCmdBeginRendering || !vkCmdEndRendering || !vkCmdPipelineBarrier2))
+        {
+            throw std::runtime_error("Failed to load dynamic rendering!");
+        }
+        std::cout << "Rendering with " << (dynamicRendering ? "dynamic rendering and synchronization2" : "render passes") << "\n";
+
+        vkGetDeviceQueue(device, indicies.graphicsFamily.value(), 0, &graphicsQueue);
+        if (indicies.presentFamily)
+        {
+            vkGetDeviceQueue(device, indicies.presentFamily.value(), 0, &presentQueue);
+        }
+        graphicsQueueFamily = indicies.graphicsFamily.value();
+        presentQueueFamily = indicies.presentFamily.value_or(graphicsQueueFamily);
+        // Without a dedicated transfer family uploads share the graphics queue.
+        transferQueueFamily = indicies.transferFamily.value_or(graphicsQueueFamily);
+        vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+    }
+
+    void createGpuAllocator()
+    {
+        gpuAllocator = std::make_unique<GpuAllocator>(physicalDevice, device, TRANSIENT_RING_SIZE);
+    }
+
+    void createStagingUploader()
+    {
+        stagingUploader = std::make_unique<StagingUploader>(device, *gpuAllocator, transferQueueFamily, transferQueue,
+            graphicsQueueFamily, VkDeviceSize { config.stagingRingMiB } << 20);
+    }
+
+    void createPipelineCache()
+    {
+        pipelineCache = std::make_unique<PipelineCache>(device, deviceInfo.properties, config.pipelineCachePath);
+    }
+
+    VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
+    {
+        for (const auto& _format : availableFormats)
+        {
+            if (_format.format == VK_FORMAT_B8G8R8A8_SRGB && _format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+            {
+                return _format;
+            }
+        }
+        return availableFormats.at(0);
+    }
+
+    VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
+    {
+        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
+        {
+            return capabilities.currentExtent;
+        }
+        else
+        {
+            int width{ }, height{ };
+            glfwGetFramebufferSize(window, &width, &height);
+            VkExtent2D actualExtent{
+                .width = std::clamp(static_cast<uint32_t>(width),
+                    capabilities.minImageExtent.width,
+                    capabilities.maxImageExtent.width),
+                .height = std::clamp(static_cast<uint32_t>(height),
+                    capabilities.minImageExtent.height,
+                    capabilities.maxImageExtent.height)
+            };
+            return actualExtent;
+        }
+    }
+
+    void createSwapChain()
+    {
+        // Formats and present modes are fixed for the surface, the capabilities follow the window.
+        const auto& _swapChainSupport  { deviceInfo.swapChainSupport };
+        VkSurfaceCapabilitiesKHR _capabilities { };
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &_capabilities);
+
+        const auto _surfaceFormat      { chooseSwapSurfaceFormat(_swapChainSupport.formats) };
+        const auto _extent             { chooseSwapExtent(_capabilities) };
+        presentConfig = choosePresentConfig(config.presentPolicy, _swapChainSupport.presentModes, _capabilities);
+
+        auto _imageCount               { presentConfig.imageCount };
+        VkSwapchainCreateInfoKHR createInfo{
+            .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+            .surface = surface,
+            .minImageCount = _imageCount,
+            .imageFormat = _surfaceFormat.format,
+            .imageColorSpace = _surfaceFormat.colorSpace,
+            .imageExtent = _extent,
+            .imageArrayLayers = 1,
+            .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+            // Exclusive even when graphics and present families differ, drawFrame() transfers
+            // ownership explicitly on the dedicated present path instead.
+            .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .preTransform = _capabilities.currentTransform,
+            .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+            .presentMode = presentConfig.presentMode,
+            .clipped = VK_TRUE,
+            // Lets the driver hand over resources, the caller still owns and destroys the old one.
+            .oldSwapchain = swapChain
+        };
+        if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create swap chain");
+        }
+        vkGetSwapchainImagesKHR(device, swapChain, &_imageCount, nullptr);
+        swapChainImages.resize(_imageCount);
+        vkGetSwapchainImagesKHR(device, swapChain, &_imageCount, swapChainImages.data());
+        swapChainFormat = _surfaceFormat.format;
+        swapChainExtent = _extent;
+    }
+
+    std::span<const char* const> requiredDeviceExtensions() const
+    {
+        if (config.headless)
+        {
+            return { };
+        }
+        return deviceExtensions;
+    }
+
+    // Headless stand-in for createSwapChain(): plain images we own, cycled round-robin.
+    void createOffscreenTargets(VkExtent2D extent)
+    {
+        swapChainFormat = VK_FORMAT_R8G8B8A8_UNORM;
+        swapChainExtent = extent;
+        swapChainImages.resize(config.offscreenImageCount);
+        offscreenImages.resize(config.offscreenImageCount);
+
+        for (size_t i = 0; i < swapChainImages.size(); i++)
+        {
+            VkImageCreateInfo imageInfo {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                .imageType = VK_IMAGE_TYPE_2D,
+                .format = swapChainFormat,
+                .extent = { swapChainExtent.width, swapChainExtent.height, 1 },
+                .mipLevels = 1,
+                .arrayLayers = 1,
+                .samples = VK_SAMPLE_COUNT_1_BIT,
+                .tiling = VK_IMAGE_TILING_OPTIMAL,
+                .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+            };
+            offscreenImages[i] = gpuAllocator->createImage(imageInfo, MemoryUsage::GpuOnly);
+            swapChainImages[i] = offscreenImages[i].image;
+        }
+    }
+
+    void createImageView(size_t index)
+    {
+        VkImageViewCreateInfo createInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image = swapChainImages[index],
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = swapChainFormat,
+            .components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+                VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY },
+            .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+        };
+        if (vkCreateImageView(device, &createInfo, nullptr, &swapChainImageViews[index]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create image view!");
+        }
+    }
+
+    void createImageViews()
+    {
+        swapChainImageViews.resize(swapChainImages.size());
+        for (size_t i = 0; i < swapChainImages.size(); i++)
+        {
+            createImageView(i);
+        }
+    }
+
+    VkFormat chooseDepthFormat() const
+    {
+        for (const auto format : { VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM })
+        {
+            VkFormatProperties _properties { };
+            vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &_properties);
+            // Sampled by the Hi-Z pyramid build.
+            constexpr VkFormatFeatureFlags REQUIRED_FEATURES {
+                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+            };
+            if ((_properties.optimalTilingFeatures & REQUIRED_FEATURES) == REQUIRED_FEATURES)
+            {
+                return format;
+            }
+        }
+        throw std::runtime_error("Failed to find a supported depth format!");
+    }
+
+    // The frame as a render graph: the cull pass, the main pass and the Hi-Z build, with the depth
+    // buffer as a transient between the last two. Rebuilt with the swapchain, since the depth buffer
+    // follows its extent; the graph places every barrier between the passes.
+    void createRenderGraph()
+    {
+        renderGraph = std::make_unique<RenderGraph>(device, *gpuAllocator, dynamicRendering);
+        auto& _graph { *renderGraph };
+        // Offscreen targets are left ready for readback, and on the dedicated present path the
+        // ownership transfer at the end of recordCommandBuffer() moves the image to PRESENT_SRC.
+        const auto _finalAccess { config.headless ? GraphAccess::TransferRead
+            : usesDedicatedPresentQueue() ? GraphAccess::ColorAttachmentWrite : GraphAccess::Present };
+        graphBackbuffer = _graph.importImage("backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, GraphAccess::Acquired, _finalAccess);
+        graphDepth = _graph.createImage("depth", {
+            .format = depthFormat,
+            .extent = swapChainExtent,
+            .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+        });
+        const auto _recordMainPass = [this](VkCommandBuffer commandBuffer) { recordMainPass(commandBuffer); };
+        if (!indirectRenderer)
+        {
+            _graph.addPass("main pass", { { graphBackbuffer, GraphAccess::ColorAttachmentWrite },
+                { graphDepth, GraphAccess::DepthAttachmentWrite } }, _recordMainPass);
+            _graph.compile();
+            return;
+        }
+
+        const auto _draws { _graph.importBuffer("draws") };
+        graphHiZ = _graph.importImage("hi-z", VK_IMAGE_ASPECT_COLOR_BIT);
+        _graph.addPass("cull", { { _draws, GraphAccess::ComputeWrite }, { graphHiZ, GraphAccess::ComputeRead } },
+            [this](VkCommandBuffer commandBuffer) { recordCullPass(commandBuffer); });
+        _graph.addPass("main pass", { { graphBackbuffer, GraphAccess::ColorAttachmentWrite },
+            { graphDepth, GraphAccess::DepthAttachmentWrite }, { _draws, GraphAccess::IndirectRead } }, _recordMainPass);
+        // Occluders for the next frame's cull pass.
+        _graph.addPass("hi-z", { { graphDepth, GraphAccess::ComputeSampledRead }, { graphHiZ, GraphAccess::ComputeWrite } },
+            [this](VkCommandBuffer commandBuffer) { recordHiZPass(commandBuffer); });
+        _graph.compile();
+        hiZPyramid->resize(_graph.imageView(graphDepth), swapChainExtent, frameNumber);
+    }
+
+    // Attachments start and end in their attachment layouts, the render graph transitions them
+    // and synchronises everything around the pass. Not needed at all with dynamic rendering.
+    void createRenderPass()
+    {
+        depthFormat = chooseDepthFormat();
+        if (dynamicRendering)
+        {
+            return;
+        }
+        VkAttachmentDescription colorAttachment {
+            .format = swapChainFormat,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+        };
+        // Kept for the Hi-Z pyramid build after the pass.
+        VkAttachmentDescription depthAttachment {
+            .format = depthFormat,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+        };
+        const std::array<VkAttachmentDescription, 2> _attachments { colorAttachment, depthAttachment };
+        VkAttachmentReference colorAttachmentRef {
+            .attachment = 0,
+            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+        };
+        VkAttachmentReference depthAttachmentRef {
+            .attachment = 1,
+            .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+        };
+        VkSubpassDescription subpass {
+            .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &colorAttachmentRef,
+            .pDepthStencilAttachment = &depthAttachmentRef
+        };
+        VkRenderPassCreateInfo renderPassInfo {
+            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+            .attachmentCount = static_cast<uint32_t>(_attachments.size()),
+            .pAttachments = _attachments.data(),
+            .subpassCount = 1,
+            .pSubpasses = &subpass
+        };
+        if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create render pass!");
+        }
+    }
+
+    void createFramebuffer(size_t index)
+    {
+        const std::array<VkImageView, 2> _attachments { swapChainImageViews[index], renderGraph->imageView(graphDepth) };
+        VkFramebufferCreateInfo framebufferInfo {
+            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+            .renderPass = renderPass,
+            .attachmentCount = static_cast<uint32_t>(_attachments.size()),
+            .pAttachments = _attachments.data(),
+            .width = swapChainExtent.width,
+            .height = swapChainExtent.height,
+            .layers = 1
+        };
+        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapChainFramebuffers[index]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create framebuffer!");
+        }
+    }
+
+    void createFramebuffers()
+    {
+        if (dynamicRendering)
+        {
+            return;
+        }
+        swapChainFramebuffers.resize(swapChainImageViews.size());
+        for (size_t i = 0; i < swapChainImageViews.size(); i++)
+        {
+            createFramebuffer(i);
+        }
+    }
+
+    // Replaces the swapchain in place instead of idling the device: the new one is created with
+    // the current one as oldSwapchain, and only the per-image views, framebuffers and semaphores
+    // are reset. They are recreated on first acquire of each image (see prepareImage()), so a
+    // resize costs one vkCreateSwapchainKHR and a new depth buffer on the frame that notices it.
+    void recreateSwapChain()
+    {
+        int _width { }, _height { };
+        glfwGetFramebufferSize(window, &_width, &_height);
+        while (_width == 0 || _height == 0)
+        {
+            // Minimised, nothing can be presented until the window comes back.
+            if (glfwWindowShouldClose(window))
+            {
+                return;
+            }
+            glfwWaitEvents();
+            glfwGetFramebufferSize(window, &_width, &_height);
+        }
+        framebufferResized = false;
+
+        // Presents have no completion signal in core Vulkan, so everything per swapchain image is
+        // kept until the first frame on the replacement has completed: that frame waited on an
+        // acquire from the new swapchain, which the presentation engine orders after the old
+        // chain's last present. The render graph owns the depth buffer the framebuffers reference.
+        auto _semaphores { std::move(renderFinishedSemaphores) };
+        _semaphores.insert(_semaphores.end(), presentReadySemaphores.begin(), presentReadySemaphores.end());
+        deferredDeleter.enqueue(frameNumber, [this, oldSwapChain = swapChain, imageViews = std::move(swapChainImageViews),
+            framebuffers = std::move(swapChainFramebuffers), semaphores = std::move(_semaphores),
+            graph = std::move(renderGraph)]
+        {
+            for (auto framebuffer : framebuffers)
+            {
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+            }
+            for (auto imageView : imageViews)
+            {
+                vkDestroyImageView(device, imageView, nullptr);
+            }
+            for (auto semaphore : semaphores)
+            {
+                vkDestroySemaphore(device, semaphore, nullptr);
+            }
+            vkDestroySwapchainKHR(device, oldSwapChain, nullptr);
+        });
+
+        // The surface format does not change for the same surface, so the render pass stays valid.
+        createSwapChain();
+        createRenderGraph();
+        const auto _imageCount { swapChainImages.size() };
+        swapChainImageViews.assign(_imageCount, VK_NULL_HANDLE);
+        swapChainFramebuffers.assign(dynamicRendering ? 0 : _imageCount, VK_NULL_HANDLE);
+        renderFinishedSemaphores.assign(_imageCount, VK_NULL_HANDLE);
+        presentReadySemaphores.assign(usesDedicatedPresentQueue() ? _imageCount : 0, VK_NULL_HANDLE);
+        // Frames still in flight reference old images only, which their slot fences cover.
+        imagesInFlight.assign(_imageCount, VK_NULL_HANDLE);
+        drawList = buildDrawGrid(config.drawCount, swapChainExtent);
+    }
+
+    // Headless counterpart of recreateSwapChain(). Nothing is created lazily here, the old targets
+    // with their views, framebuffers and render graph are retired through the deferred deleter and
+    // the new ones created right away.
+    void recreateOffscreenTargets(VkExtent2D extent)
+    {
+        deferredDeleter.enqueue(frameNumber, [this, images = std::move(offscreenImages), imageViews = std::move(swapChainImageViews),
+            framebuffers = std::move(swapChainFramebuffers), graph = std::move(renderGraph)]() mutable
+        {
+            for (auto framebuffer : framebuffers)
+            {
+                vkDestroyFramebuffer(device, framebuffer, nullptr);
+            }
+            for (auto imageView : imageViews)
+            {
+                vkDestroyImageView(device, imageView, nullptr);
+            }
+            for (auto& image : images)
+            {
+                gpuAllocator->destroyImage(image);
+            }
+        });
+
+        createOffscreenTargets(extent);
+        createRenderGraph();
+        createImageViews();
+        createFramebuffers();
+        imagesInFlight.assign(swapChainImages.size(), VK_NULL_HANDLE);
+        drawList = buildDrawGrid(config.drawCount, swapChainExtent);
+    }
+
+    // --resize-every: alternates the render target between the configured size and three quarters
+    // of it. Windows go through the usual resize callback and swapchain recreation.
+    void resizeRenderTarget()
+    {
+        runReport.resizes++;
+        const bool _shrink { runReport.resizes % 2 == 1 };
+        const VkExtent2D _extent {
+            _shrink ? std::max(config.width * 3 / 4, 1u) : config.width,
+            _shrink ? std::max(config.height * 3 / 4, 1u) : config.height
+        };
+        if (window)
+        {
+            glfwSetWindowSize(window, static_cast<int>(_extent.width), static_cast<int>(_extent.height));
+            return;
+        }
+        recreateOffscreenTargets(_extent);
+    }
+
+    // Lazily creates what recreateSwapChain() reset for this image.
+    void prepareImage(uint32_t imageIndex)
+    {
+        if (config.headless)
+        {
+            return;
+        }
+        if (!swapChainImageViews[imageIndex])
+        {
+            createImageView(imageIndex);
+        }
+        if (!dynamicRendering && !swapChainFramebuffers[imageIndex])
+        {
+            createFramebuffer(imageIndex);
+        }
+        if (!renderFinishedSemaphores[imageIndex])
+        {
+            renderFinishedSemaphores[imageIndex] = createSemaphore();
+        }
+        if (usesDedicatedPresentQueue() && !presentReadySemaphores[imageIndex])
+        {
+            presentReadySemaphores[imageIndex] = createSemaphore();
+        }
+    }
+
+    // Graphics and present live in different queue families, so every frame has to hand the
+    // swapchain image over to the present queue before it can be presented.
+    bool usesDedicatedPresentQueue() const
+    {
+        return !config.headless && graphicsQueueFamily != presentQueueFamily;
+    }
+
+    VkCommandPool createCommandPool(uint32_t queueFamily, VkCommandPoolCreateFlags flags)
+    {
+        VkCommandPoolCreateInfo poolInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = flags,
+            .queueFamilyIndex = queueFamily
+        };
+        VkCommandPool _pool { };
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &_pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create command pool!");
+        }
+        return _pool;
+    }
+
+    VkCommandBuffer allocateCommandBuffer(VkCommandPool pool, VkCommandBufferLevel level)
+    {
+        VkCommandBufferAllocateInfo allocInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = pool,
+            .level = level,
+            .commandBufferCount = 1
+        };
+        VkCommandBuffer _commandBuffer { };
+        if (vkAllocateCommandBuffers(device, &allocInfo, &_commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate command buffer!");
+        }
+        return _commandBuffer;
+    }
+
+    VkSemaphore createSemaphore()
+    {
+        VkSemaphoreCreateInfo semaphoreInfo { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+        VkSemaphore _semaphore { };
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &_semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create semaphore!");
+        }
+        return _semaphore;
+    }
+
+    struct FrameData
+    {
+        VkCommandPool commandPool           { };
+        VkCommandBuffer commandBuffer       { };
+        VkSemaphore imageAvailable          { };
+        VkFence inFlight                    { };
+        std::optional<uint64_t> submittedFrame;
+        // Dedicated present path only, see usesDedicatedPresentQueue().
+        VkCommandPool presentCommandPool    { };
+        VkCommandBuffer presentCommandBuffer { };
+        // CPU scratch for the frame, reset along with the command pool.
+        std::unique_ptr<FrameArena> arena;
+    };
+
+    void createFrameResources()
+    {
+        frames.resize(config.framesInFlight);
+        for (auto& frame : frames)
+        {
+            // Transient pools, reset wholesale once the frame's fence has signalled.
+            frame.commandPool = createCommandPool(graphicsQueueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+            frame.commandBuffer = allocateCommandBuffer(frame.commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+            frame.arena = std::make_unique<FrameArena>(FRAME_ARENA_SIZE);
+            if (usesDedicatedPresentQueue())
+            {
+                frame.presentCommandPool = createCommandPool(presentQueueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+                frame.presentCommandBuffer = allocateCommandBuffer(frame.presentCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+            }
+            if (!config.headless)
+            {
+                frame.imageAvailable = createSemaphore();
+            }
+
+            VkFenceCreateInfo fenceInfo {
+                .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+                .flags = VK_FENCE_CREATE_SIGNALED_BIT
+            };
+            if (vkCreateFence(device, &fenceInfo, nullptr, &frame.inFlight) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create fence!");
+            }
+        }
+
+        // Render-finished semaphores are tied to the image rather than the frame: presentation
+        // holds on to them until the image is re-acquired, which may be after the frame slot is reused.
+        imagesInFlight.assign(swapChainImages.size(), VK_NULL_HANDLE);
+        if (!config.headless)
+        {
+            renderFinishedSemaphores.resize(swapChainImages.size());
+            for (auto& semaphore : renderFinishedSemaphores)
+            {
+                semaphore = createSemaphore();
+            }
+            if (usesDedicatedPresentQueue())
+            {
+                presentReadySemaphores.resize(swapChainImages.size());
+                for (auto& semaphore : presentReadySemaphores)
+                {
+                    semaphore = createSemaphore();
+                }
+            }
+        }
+    }
+
+    void destroyFrameResources()
+    {
+        for (auto& frame : frames)
+        {
+            vkDestroyFence(device, frame.inFlight, nullptr);
+            vkDestroySemaphore(device, frame.imageAvailable, nullptr);
+            vkDestroyCommandPool(device, frame.presentCommandPool, nullptr);
+            vkDestroyCommandPool(device, frame.commandPool, nullptr);
+        }
+        frames.clear();
+        for (auto semaphore : renderFinishedSemaphores)
+        {
+            vkDestroySemaphore(device, semaphore, nullptr);
+        }
+        renderFinishedSemaphores.clear();
+        for (auto semaphore : presentReadySemaphores)
+        {
+            vkDestroySemaphore(device, semaphore, nullptr);
+        }
+        presentReadySemaphores.clear();
+    }
+
+    void createProfiler()
+    {
+        profiler = std::make_unique<Profiler>(device, deviceInfo.properties.limits.timestampPeriod,
+            deviceInfo.queueFamilyProperties[graphicsQueueFamily].timestampValidBits, config.framesInFlight);
+    }
+
+    void createParallelRecorder()
+    {
+        drawList = buildDrawGrid(config.drawCount, swapChainExtent);
+        if (drawList.empty())
+        {
+            return;
+        }
+        const auto _workers { config.recordThreads ? config.recordThreads : JobSystem::defaultWorkerCount() };
+        parallelRecorder = std::make_unique<ParallelRecorder>(device, graphicsQueueFamily, config.framesInFlight, _workers);
+    }
+
+    // The GPU-driven scene is the default workload, --draws switches to the clear-rect draw list.
+    void createIndirectRenderer()
+    {
+        if (parallelRecorder || !config.instanceCount)
+        {
+            return;
+        }
+        GpuSceneAssets _assets { };
+        if (config.assetArchive.empty())
+        {
+            sceneData = buildDemoScene(config.instanceCount);
+            reportGeometry(std::cout, sceneData.sourceGeometry, sceneData.geometry);
+            _assets = uploadSceneAssets(device, *gpuAllocator, *stagingUploader, sceneData);
+        }
+        else
+        {
+            _assets = loadSceneAssets();
+        }
+        bindlessSet = std::make_unique<BindlessSet>(device, BINDLESS_MAX_BUFFERS, BINDLESS_MAX_TEXTURES);
+        indirectRenderer = std::make_unique<IndirectRenderer>(device, *gpuAllocator, *stagingUploader, *bindlessSet,
+            pipelineCache->handle(), RenderTargetFormats { renderPass, swapChainFormat, depthFormat }, config.framesInFlight,
+            sceneData, std::move(_assets));
+        hiZPyramid = std::make_unique<HiZPyramid>(device, *gpuAllocator, *bindlessSet, deferredDeleter, pipelineCache->handle());
+    }
+
+    // Places the demo instances over an archived scene and streams its assets in. The copies
+    // themselves finish on the transfer queue while the first frames render.
+    GpuSceneAssets loadSceneAssets()
+    {
+        const AssetArchive _archive { config.assetArchive };
+        const auto _textureCount { loadSceneLayout(_archive, sceneData) };
+        placeDemoInstances(sceneData, config.instanceCount, _textureCount);
+
+        std::cout << "Asset load: " << config.assetArchive.string() << ", textures "
+            << (compressedTextures ? "BC1" : "decompressed to RGBA8") << '\n';
+        if (config.assetBenchmark)
+        {
+            // Read first so the streaming loader can't get an unfair head start from a cold page cache.
+            AssetLoadStats _stats { };
+            comparisonAssets = loadSceneAssetsPlain(device, *gpuAllocator, *stagingUploader, config.assetArchive,
+                compressedTextures, _stats);
+            reportAssetLoad(std::cout, "plain, single thread", _stats);
+        }
+        JobSystem _jobs { JobSystem::defaultWorkerCount() };
+        AssetLoadStats _stats { };
+        auto _assets { streamSceneAssets(device, *gpuAllocator, *stagingUploader, _jobs, _archive, compressedTextures, _stats) };
+        reportAssetLoad(std::cout, "mapped, " + std::to_string(_jobs.workerCount()) + " workers", _stats);
+        return _assets;
+    }
+
+    void recordDraws(VkCommandBuffer commandBuffer, uint32_t firstDraw, uint32_t drawCount) const
+    {
+        for (uint32_t i = firstDraw; i < firstDraw + drawCount; i++)
+        {
+            const auto& _item { drawList[i] };
+            VkClearAttachment clearAttachment {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .colorAttachment = 0,
+                .clearValue = { .color = _item.color }
+            };
+            VkClearRect clearRect { .rect = _item.rect, .baseArrayLayer = 0, .layerCount = 1 };
+            vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
+        }
+    }
+
+    // Barrier moving a swapchain image between the graphics and present queue families. Recorded
+    // twice with identical parameters, as the release on the graphics queue and the acquire on the
+    // present queue; it also performs the transition to PRESENT_SRC, the render graph leaves the
+    // image as a color attachment on this path.
+    VkImageMemoryBarrier presentOwnershipBarrier(VkImage image) const
+    {
+        return VkImageMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = 0,
+            .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+            .srcQueueFamilyIndex = graphicsQueueFamily,
+            .dstQueueFamilyIndex = presentQueueFamily,
+            .image = image,
+            .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+        };
+    }
+
+    // Outside the render pass: resets the counters and culls against the previous frame's Hi-Z.
+    void recordCullPass(VkCommandBuffer commandBuffer)
+    {
+        // Scene uploads may still be in flight on the transfer queue, until then only the clear shows.
+        if (!indirectRenderer->ready())
+        {
+            return;
+        }
+        const auto _frameIndex { static_cast<uint32_t>(currentFrame) };
+        const auto _cullScope { profiler->beginGpuScope(commandBuffer, _frameIndex, "cull") };
+        indirectRenderer->recordCull(commandBuffer, _frameIndex);
+        profiler->endGpuScope(commandBuffer, _frameIndex, _cullScope);
+    }
+
+    void recordMainPass(VkCommandBuffer commandBuffer)
+    {
+        const auto _frameIndex { static_cast<uint32_t>(currentFrame) };
+        const float _t = static_cast<float>(frameNumber % 256) / 255.0f;
+        const std::array<VkClearValue, 2> _clearValues { {
+            { .color = { { _t, 0.2f, 1.0f - _t, 1.0f } } },
+            { .depthStencil = { 1.0f, 0 } }
+        } };
+        const auto _passScope { profiler->beginGpuScope(commandBuffer, _frameIndex, "main pass") };
+        if (parallelRecorder)
+        {
+            // Secondaries inherit either the render pass and framebuffer, or the attachment formats.
+            const VkCommandBufferInheritanceRenderingInfo inheritanceRendering {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+                .colorAttachmentCount = 1,
+                .pColorAttachmentFormats = &swapChainFormat,
+                .depthAttachmentFormat = depthFormat,
+                .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
+            };
+            VkCommandBufferInheritanceInfo inheritance {
+                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+                .pNext = dynamicRendering ? &inheritanceRendering : nullptr,
+                .renderPass = renderPass,
+                .subpass = 0,
+                .framebuffer = dynamicRendering ? VK_NULL_HANDLE : swapChainFramebuffers[recordingImage]
+            };
+            const auto _secondaries { parallelRecorder->record(_frameIndex, inheritance,
+                static_cast<uint32_t>(drawList.size()),
+                [this](VkCommandBuffer secondary, uint32_t firstDraw, uint32_t drawCount)
+                {
+                    recordDraws(secondary, firstDraw, drawCount);
+                }) };
+            beginMainPass(commandBuffer, _clearValues, true);
+            vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(_secondaries.size()), _secondaries.data());
+        }
+        else
+        {
+            beginMainPass(commandBuffer, _clearValues, false);
+            if (indirectRenderer && indirectRenderer->ready())
+            {
+                indirectRenderer->recordDraw(commandBuffer, _frameIndex, swapChainExtent);
+            }
+        }
+        if (dynamicRendering)
+        {
+            vkCmdEndRendering(commandBuffer);
+        }
+        else
+        {
+            vkCmdEndRenderPass(commandBuffer);
+        }
+        profiler->endGpuScope(commandBuffer, _frameIndex, _passScope);
+    }
+
+    // Dynamic rendering needs no render pass or framebuffer, only the views of this frame's
+    // attachments, already in attachment layouts thanks to the render graph.
+    void beginMainPass(VkCommandBuffer commandBuffer, const std::array<VkClearValue, 2>& clearValues, bool secondaries)
+    {
+        const VkRect2D _renderArea { { 0, 0 }, swapChainExtent };
+        if (!dynamicRendering)
+        {
+            VkRenderPassBeginInfo renderPassInfo {
+                .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+                .renderPass = renderPass,
+                .framebuffer = swapChainFramebuffers[recordingImage],
+                .renderArea = _renderArea,
+                .clearValueCount = static_cast<uint32_t>(clearValues.size()),
+                .pClearValues = clearValues.data()
+            };
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo,
+                secondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+            return;
+        }
+        const VkRenderingAttachmentInfo colorAttachment {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView = swapChainImageViews[recordingImage],
+            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = clearValues[0]
+        };
+        // Kept for the Hi-Z pyramid build after the pass.
+        const VkRenderingAttachmentInfo depthAttachment {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .imageView = renderGraph->imageView(graphDepth),
+            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = clearValues[1]
+        };
+        const VkRenderingInfo renderingInfo {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+            .flags = secondaries ? static_cast<VkRenderingFlags>(VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT) : 0,
+            .renderArea = _renderArea,
+            .layerCount = 1,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &colorAttachment,
+            .pDepthAttachment = &depthAttachment
+        };
+        vkCmdBeginRendering(commandBuffer, &renderingInfo);
+    }
+
+    void recordHiZPass(VkCommandBuffer commandBuffer)
+    {
+        if (!indirectRenderer->ready())
+        {
+            return;
+        }
+        const auto _frameIndex { static_cast<uint32_t>(currentFrame) };
+        const auto _hiZScope { profiler->beginGpuScope(commandBuffer, _frameIndex, "hi-z") };
+        hiZPyramid->record(commandBuffer);
+        profiler->endGpuScope(commandBuffer, _frameIndex, _hiZScope);
+    }
+
+    void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+    {
+        VkCommandBufferBeginInfo beginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+        };
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to begin recording command buffer!");
+        }
+        const auto _frameIndex { static_cast<uint32_t>(currentFrame) };
+        profiler->resetQueries(commandBuffer, _frameIndex);
+        const auto _frameScope { profiler->beginGpuScope(commandBuffer, _frameIndex, "frame") };
+        stagingUploader->acquireOnGraphics(commandBuffer);
+
+        recordingImage = imageIndex;
+        renderGraph->setImage(graphBackbuffer, swapChainImages[imageIndex]);
+        if (hiZPyramid)
+        {
+            renderGraph->setImage(graphHiZ, hiZPyramid->image());
+        }
+        renderGraph->execute(commandBuffer);
+
+        if (usesDedicatedPresentQueue())
+        {
+            auto _release { presentOwnershipBarrier(swapChainImages[imageIndex]) };
+            _release.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0, 0, nullptr, 0, nullptr, 1, &_release);
+        }
+        profiler->endGpuScope(commandBuffer, _frameIndex, _frameScope);
+
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to record command buffer!");
+        }
+    }
+
+    void recordPresentAcquire(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+    {
+        VkCommandBufferBeginInfo beginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+        };
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to begin recording present command buffer!");
+        }
+        // srcStageMask must match the submission's semaphore wait stage, or the acquire and layout
+        // transition are not ordered after the release on the graphics queue. ALL_COMMANDS because
+        // the present queue need not support graphics stages.
+        const auto _acquire { presentOwnershipBarrier(swapChainImages[imageIndex]) };
+        vkCmdPipelineBarrier(commandBuffer, PRESENT_ACQUIRE_STAGE, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, 0, nullptr, 0, nullptr, 1, &_acquire);
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to record present command buffer!");
+        }
+    }
+
+    // Returns nullopt when the swapchain was out of date and had to be recreated first.
+    std::optional<uint32_t> acquireImage(const FrameData& frame)
+    {
+        if (config.headless)
+        {
+            // Offscreen targets are simply cycled, imagesInFlight keeps us from reusing one early.
+            return static_cast<uint32_t>(frameNumber % swapChainImages.size());
+        }
+
+        uint32_t _imageIndex { };
+        const auto _result { vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(),
+            frame.imageAvailable, VK_NULL_HANDLE, &_imageIndex) };
+        if (_result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            recreateSwapChain();
+            return std::nullopt;
+        }
+        // Suboptimal still presents fine, present() recreates once the frame is out.
+        if (_result != VK_SUCCESS && _result != VK_SUBOPTIMAL_KHR)
+        {
+            throw std::runtime_error("Failed to acquire swap chain image!");
+        }
+        return _imageIndex;
+    }
+
+    void drawFrame()
+    {
+        frameStats.beginFrame();
+        auto& _frame { frames[currentFrame] };
+        {
+            const auto _scope { profiler->cpuScope("wait for frame") };
+            const auto _waitStart { std::chrono::steady_clock::now() };
+            vkWaitForFences(device, 1, &_frame.inFlight, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            frameWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _waitStart).count();
+        }
+        _frame.arena->reset();
+        profiler->beginFrame(static_cast<uint32_t>(currentFrame), *_frame.arena);
+        if (_frame.submittedFrame)
+        {
+            // Submissions retire in order, so every frame up to this slot's last one is done. The
+            // cull counters are read from that frame's transient memory, before it is released.
+            if (indirectRenderer)
+            {
+                indirectRenderer->collectStats(static_cast<uint32_t>(currentFrame));
+            }
+            gpuAllocator->releaseFrames(*_frame.submittedFrame);
+            deferredDeleter.collect(*_frame.submittedFrame);
+        }
+        stagingUploader->collect();
+
+        std::optional<uint32_t> _acquired;
+        {
+            const auto _scope { profiler->cpuScope("acquire") };
+            _acquired = acquireImage(_frame);
+        }
+        if (!_acquired)
+        {
+            // Nothing was submitted, the slot's fence is still signalled for the next attempt.
+            return;
+        }
+        const auto _imageIndex { *_acquired };
+        const auto _acquiredAt { FrameStats::Clock::now() };
+        prepareImage(_imageIndex);
+        if (imagesInFlight[_imageIndex] != VK_NULL_HANDLE)
+        {
+            // Only possible when there are more frames in flight than images.
+            vkWaitForFences(device, 1, &imagesInFlight[_imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+        imagesInFlight[_imageIndex] = _frame.inFlight;
+        vkResetFences(device, 1, &_frame.inFlight);
+
+        const float _sceneTime { static_cast<float>(frameNumber) * SCENE_TIME_STEP };
+        if (indirectRenderer)
+        {
+            // Only once an image is acquired, every graph update has to reach updateFrame().
+            const auto _scope { profiler->cpuScope("scene update") };
+            animateDemoScene(sceneData, _sceneTime);
+            sceneData.graph.update();
+        }
+        {
+            const auto _scope { profiler->cpuScope("record") };
+            vkResetCommandPool(device, _frame.commandPool, 0);
+            if (parallelRecorder)
+            {
+                parallelRecorder->beginFrame(static_cast<uint32_t>(currentFrame));
+            }
+            if (indirectRenderer)
+            {
+                indirectRenderer->updateFrame(static_cast<uint32_t>(currentFrame), swapChainExtent, _sceneTime,
+                    sceneData.graph, hiZPyramid.get());
+            }
+            recordCommandBuffer(_frame.commandBuffer, _imageIndex);
+        }
+
+        const VkPipelineStageFlags _waitStage { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+        VkSubmitInfo submitInfo {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &_frame.commandBuffer
+        };
+        if (!config.headless)
+        {
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &_frame.imageAvailable;
+            submitInfo.pWaitDstStageMask = &_waitStage;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &renderFinishedSemaphores[_imageIndex];
+        }
+        {
+            const auto _scope { profiler->cpuScope("submit") };
+            if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, _frame.inFlight) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to submit draw command buffer!");
+            }
+        }
+        profiler->markSubmitted(static_cast<uint32_t>(currentFrame));
+        gpuAllocator->endFrame(frameNumber);
+        _frame.submittedFrame = frameNumber;
+
+        bool _outOfDate { };
+        if (!config.headless)
+        {
+            const auto _scope { profiler->cpuScope("present") };
+            _outOfDate = !present(_frame, _imageIndex);
+        }
+        if (!config.headless)
+        {
+            frameStats.recordAcquireToPresent(_acquiredAt, FrameStats::Clock::now());
+        }
+        currentFrame = (currentFrame + 1) % frames.size();
+        frameNumber++;
+        if (_outOfDate)
+        {
+            // After the increment, so the retired swapchain is tied to the frame that follows it.
+            recreateSwapChain();
+        }
+    }
+
+    // Returns false when the swapchain no longer matches the surface and must be recreated.
+    bool present(FrameData& frame, uint32_t imageIndex)
+    {
+        VkSemaphore _presentWait { renderFinishedSemaphores[imageIndex] };
+        if (usesDedicatedPresentQueue())
+        {
+            // The present pool is only reused after this slot's fence signalled. The render-finished
+            // semaphore wait and the acquire barrier share PRESENT_ACQUIRE_STAGE, which chains the
+            // acquire after the graphics queue's release.
+            vkResetCommandPool(device, frame.presentCommandPool, 0);
+            recordPresentAcquire(frame.presentCommandBuffer, imageIndex);
+
+            const VkPipelineStageFlags _waitStage { PRESENT_ACQUIRE_STAGE };
+            VkSubmitInfo submitInfo {
+                .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+                .waitSemaphoreCount = 1,
+                .pWaitSemaphores = &_presentWait,
+                .pWaitDstStageMask = &_waitStage,
+                .commandBufferCount = 1,
+                .pCommandBuffers = &frame.presentCommandBuffer,
+                .signalSemaphoreCount = 1,
+                .pSignalSemaphores = &presentReadySemaphores[imageIndex]
+            };
+            if (vkQueueSubmit(presentQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to submit present ownership transfer!");
+            }
+            _presentWait = presentReadySemaphores[imageIndex];
+        }
+
+        VkPresentInfoKHR presentInfo {
+            .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &_presentWait,
+            .swapchainCount = 1,
+            .pSwapchains = &swapChain,
+            .pImageIndices = &imageIndex
+        };
+        const auto _result { vkQueuePresentKHR(presentQueue, &presentInfo) };
+        if (_result == VK_ERROR_OUT_OF_DATE_KHR || _result == VK_SUBOPTIMAL_KHR)
+        {
+            return false;
+        }
+        if (_result != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to present swap chain image!");
+        }
+        return !framebufferResized;
+    }
+
+    AppConfig config;
+
+    GLFWwindow* window                      { };
+
+    VkInstance instance                     { };
+    VkSurfaceKHR surface                    { };
+    VkPhysicalDevice physicalDevice         { VK_NULL_HANDLE };
+    DeviceProbe deviceInfo;
+    // deviceInfo came from the device snapshot instead of probing every GPU.
+    bool deviceSnapshotHit                  { };
+    RunReport runReport;
+    // Spent in drawFrame() waiting for frame slots to retire, excluded from RunReport::cpuMsPerFrame.
+    double frameWaitMs                      { };
+    VkDevice device                         { };
+    VkQueue graphicsQueue                   { };
+    VkQueue presentQueue                    { };
+    VkQueue transferQueue                   { };
+    uint32_t graphicsQueueFamily            { };
+    uint32_t presentQueueFamily             { };
+    uint32_t transferQueueFamily            { };
+    VkSwapchainKHR swapChain                { };
+    VkFormat swapChainFormat                { };
+    VkExtent2D swapChainExtent              { };
+    std::vector<VkImage> swapChainImages;
+    std::vector<VkImageView> swapChainImageViews;
+    std::vector<VkFramebuffer> swapChainFramebuffers;
+    VkFormat depthFormat                    { };
+    VkRenderPass renderPass                 { };
+    PresentConfig presentConfig;
+    bool framebufferResized                 { };
+
+    std::vector<FrameData> frames;
+    std::vector<VkSemaphore> renderFinishedSemaphores;
+    std::vector<VkSemaphore> presentReadySemaphores;
+    std::vector<VkFence> imagesInFlight;
+    size_t currentFrame                     { };
+
+    std::vector<DrawItem> drawList;
+    std::unique_ptr<ParallelRecorder> parallelRecorder;
+    SceneData sceneData;
+    // BC1 textures can be sampled, see createLogicalDevice().
+    bool compressedTextures                 { };
+    // No render pass or framebuffers, see createLogicalDevice() and recordMainPass().
+    bool dynamicRendering                   { };
+    // What --bench-assets loaded for comparison, kept until shutdown as the uploader may still
+    // have acquire barriers pending for it.
+    GpuSceneAssets comparisonAssets;
+    std::unique_ptr<BindlessSet> bindlessSet;
+    std::unique_ptr<IndirectRenderer> indirectRenderer;
+    std::unique_ptr<HiZPyramid> hiZPyramid;
+    std::unique_ptr<RenderGraph> renderGraph;
+    GraphResource graphBackbuffer           { };
+    GraphResource graphDepth                { };
+    GraphResource graphHiZ                  { };
+    // Swapchain image recordCommandBuffer() is recording for, what the graph's passes render to.
+    uint32_t recordingImage                 { };
+    uint64_t frameNumber                    { };
+    // Keyed on frameNumber, collected once a frame slot's fence has signalled.
+    DeferredDeleter deferredDeleter;
+    FrameStats frameStats;
+    std::unique_ptr<Profiler> profiler;
+
+    // Pass pipelineCache->handle() to every vkCreate*Pipelines call.
+    std::unique_ptr<PipelineCache> pipelineCache;
+    StartupTimings startupTimings;
+
+    std::unique_ptr<GpuAllocator> gpuAllocator;
+    std::unique_ptr<StagingUploader> stagingUploader;
+    // Headless mode only: the images behind swapChainImages.
+    std::vector<GpuImage> offscreenImages;
+
+    // Validation only, see ValidationConfig.
+    std::unique_ptr<ValidationLog> validationLog;
+    VkDebugUtilsMessengerEXT debugMessenger { };
+};
+
+RunReport runApplication(const AppConfig& config)
+{
+    HelloTriangleApplication app(config);
+    app.run();
+    return app.report();
+}
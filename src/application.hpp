@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "app_config.hpp"
+
+// What one run measured, besides what it printed. Zero where the run did not get that far, e.g.
+// no frame times for an upload benchmark.
+struct RunReport
+{
+    std::string deviceName;
+    // Construction up to the end of the first frame, see StartupTimings.
+    double startupMs                    { };
+    uint32_t frames                     { };
+    // Wall time of the frame loop.
+    double renderMs                     { };
+    // Time spent in drawFrame() minus waiting for the frame slot's fence, i.e. the CPU cost of a frame.
+    double cpuMsPerFrame                { };
+    uint32_t resizes                    { };
+    // GpuAllocator::allocate() calls and live VkDeviceMemory allocations when rendering stopped.
+    uint64_t gpuAllocations             { };
+    uint64_t deviceMemoryAllocations    { };
+    // Global operator new calls per frame once warmed up, see HEAP_WARMUP_FRAMES. 0 unless
+    // something in the frame loop still allocates, resizes do.
+    double heapAllocationsPerFrame      { };
+    size_t frameArenaPeakBytes          { };
+    // Only for config.uploadBenchmarkMiB.
+    double asyncUploadMBps              { };
+    double blockingUploadMBps           { };
+
+    double framesPerSecond() const { return renderMs > 0.0 ? frames / (renderMs / 1000.0) : 0.0; }
+};
+
+// Initialises the application for config, renders until the frame limit or the window closes,
+// prints its reports and tears everything down. Throws std::runtime_error on failure.
+RunReport runApplication(const AppConfig& config);
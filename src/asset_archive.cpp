@@ -0,0 +1,246 @@
+#include "asset_archive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Blobs start right after the header, rounded up to ASSET_ALIGNMENT.
+    constexpr uint64_t BLOB_START { (sizeof(ArchiveHeader) + ASSET_ALIGNMENT - 1) / ASSET_ALIGNMENT * ASSET_ALIGNMENT };
+
+    // Far beyond any device limit, only there to keep size computations from overflowing.
+    constexpr uint32_t MAX_TEXTURE_EXTENT { 1u << 16 };
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    void validateHeader(const ArchiveHeader& header, uint64_t fileSize)
+    {
+        const ArchiveHeader _expected { };
+        if (std::memcmp(header.magic, _expected.magic, sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error("Not an asset archive!");
+        }
+        if (header.version != ASSET_ARCHIVE_VERSION)
+        {
+            throw std::runtime_error("Unsupported asset archive version " + std::to_string(header.version) + "!");
+        }
+        if (header.tableOffset > fileSize || header.entryCount > (fileSize - header.tableOffset) / sizeof(ArchiveEntry))
+        {
+            throw std::runtime_error("Asset archive table is truncated!");
+        }
+    }
+
+    void validateEntries(std::span<const ArchiveEntry> entries, uint64_t fileSize)
+    {
+        for (const auto& entry : entries)
+        {
+            if (std::find(std::begin(entry.name), std::end(entry.name), '\0') == std::end(entry.name))
+            {
+                throw std::runtime_error("Asset archive entry name is not terminated!");
+            }
+            if (entry.offset > fileSize || entry.size > fileSize - entry.offset || entry.offset % ASSET_ALIGNMENT != 0)
+            {
+                throw std::runtime_error("Asset archive entry '" + std::string(entry.nameView()) + "' is out of bounds!");
+            }
+            if (entry.type == AssetType::Texture && (entry.encoding > TextureEncoding::Bc1
+                || !entry.width || !entry.height || entry.width > MAX_TEXTURE_EXTENT || entry.height > MAX_TEXTURE_EXTENT
+                || !entry.mipLevels || entry.mipLevels > mipLevelCount(entry.width, entry.height)
+                || textureSize(entry.encoding, entry.width, entry.height, entry.mipLevels) != entry.size))
+            {
+                throw std::runtime_error("Asset archive texture '" + std::string(entry.nameView()) + "' is malformed!");
+            }
+        }
+    }
+}
+
+std::string_view ArchiveEntry::nameView() const
+{
+    return { name, static_cast<size_t>(std::find(std::begin(name), std::end(name), '\0') - std::begin(name)) };
+}
+
+std::vector<ArchiveEntry> readArchiveTable(std::istream& in, uint64_t fileSize)
+{
+    ArchiveHeader _header { };
+    if (fileSize < sizeof(_header) || !in.seekg(0).read(reinterpret_cast<char*>(&_header), sizeof(_header)))
+    {
+        throw std::runtime_error("Failed to read asset archive header!");
+    }
+    validateHeader(_header, fileSize);
+    std::vector<ArchiveEntry> _entries(_header.entryCount);
+    const auto _tableSize { static_cast<std::streamsize>(_entries.size() * sizeof(ArchiveEntry)) };
+    if (!in.seekg(static_cast<std::streamoff>(_header.tableOffset)).read(reinterpret_cast<char*>(_entries.data()), _tableSize))
+    {
+        throw std::runtime_error("Failed to read asset archive table!");
+    }
+    validateEntries(_entries, fileSize);
+    return _entries;
+}
+
+const ArchiveEntry& findArchiveEntry(std::span<const ArchiveEntry> entries, std::string_view name, AssetType type)
+{
+    const auto _entry { std::find_if(entries.begin(), entries.end(), [&](const auto& entry) { return entry.nameView() == name; }) };
+    if (_entry == entries.end())
+    {
+        throw std::runtime_error("Asset archive has no entry '" + std::string(name) + "'!");
+    }
+    if (_entry->type != type)
+    {
+        throw std::runtime_error("Asset archive entry '" + std::string(name) + "' has the wrong type!");
+    }
+    return *_entry;
+}
+
+AssetArchive::AssetArchive(const std::filesystem::path& path)
+{
+    const auto _error = [&](const char* what) { return std::runtime_error(what + (": " + path.string())); };
+#ifdef _WIN32
+    file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+        throw _error("Failed to open asset archive");
+    }
+    LARGE_INTEGER _size { };
+    GetFileSizeEx(file, &_size);
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* _view { mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr };
+    if (!_view)
+    {
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        throw _error("Failed to map asset archive");
+    }
+    mapped = { static_cast<const std::byte*>(_view), static_cast<size_t>(_size.QuadPart) };
+#else
+    const int _file { open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (_file < 0)
+    {
+        throw _error("Failed to open asset archive");
+    }
+    struct stat _stat { };
+    void* _view { MAP_FAILED };
+    if (fstat(_file, &_stat) == 0 && _stat.st_size > 0)
+    {
+        _view = mmap(nullptr, static_cast<size_t>(_stat.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+    }
+    // The mapping keeps the file referenced.
+    close(_file);
+    if (_view == MAP_FAILED)
+    {
+        throw _error("Failed to map asset archive");
+    }
+    // Everything is going to be read, start the read-ahead now.
+    madvise(_view, static_cast<size_t>(_stat.st_size), MADV_WILLNEED);
+    mapped = { static_cast<const std::byte*>(_view), static_cast<size_t>(_stat.st_size) };
+#endif
+
+    try
+    {
+        ArchiveHeader _header { };
+        if (mapped.size() < sizeof(_header))
+        {
+            throw std::runtime_error("Asset archive is truncated!");
+        }
+        std::memcpy(&_header, mapped.data(), sizeof(_header));
+        validateHeader(_header, mapped.size());
+        table.resize(_header.entryCount);
+        std::memcpy(table.data(), mapped.data() + _header.tableOffset, table.size() * sizeof(ArchiveEntry));
+        validateEntries(table, mapped.size());
+    }
+    catch (...)
+    {
+        unmap();
+        throw;
+    }
+}
+
+AssetArchive::~AssetArchive()
+{
+    unmap();
+}
+
+void AssetArchive::unmap()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(mapped.data());
+    CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    munmap(const_cast<std::byte*>(mapped.data()), mapped.size());
+#endif
+}
+
+void AssetArchiveWriter::addBuffer(std::string_view name, std::span<const std::byte> data)
+{
+    add(name, { .type = AssetType::Buffer }, data);
+}
+
+void AssetArchiveWriter::addTexture(std::string_view name, TextureEncoding encoding, uint32_t width, uint32_t height,
+    uint32_t mipLevels, std::span<const std::byte> data)
+{
+    if (textureSize(encoding, width, height, mipLevels) != data.size())
+    {
+        throw std::runtime_error("Texture '" + std::string(name) + "' does not match its size!");
+    }
+    add(name, {
+        .type = AssetType::Texture,
+        .encoding = encoding,
+        .width = width,
+        .height = height,
+        .mipLevels = mipLevels
+    }, data);
+}
+
+void AssetArchiveWriter::add(std::string_view name, ArchiveEntry entry, std::span<const std::byte> data)
+{
+    if (name.size() >= sizeof(entry.name))
+    {
+        throw std::runtime_error("Asset name '" + std::string(name) + "' is too long!");
+    }
+    std::memcpy(entry.name, name.data(), name.size());
+    blobs.resize(alignUp(blobs.size(), ASSET_ALIGNMENT));
+    entry.offset = BLOB_START + blobs.size();
+    entry.size = data.size();
+    blobs.insert(blobs.end(), data.begin(), data.end());
+    table.push_back(entry);
+}
+
+void AssetArchiveWriter::write(const std::filesystem::path& path) const
+{
+    const ArchiveHeader _header {
+        .entryCount = static_cast<uint32_t>(table.size()),
+        .tableOffset = alignUp(BLOB_START + blobs.size(), alignof(ArchiveEntry))
+    };
+    std::ofstream _file { path, std::ios::binary | std::ios::trunc };
+    const std::vector<char> _padding(ASSET_ALIGNMENT);
+    _file.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    _file.write(_padding.data(), static_cast<std::streamsize>(BLOB_START - sizeof(_header)));
+    _file.write(reinterpret_cast<const char*>(blobs.data()), static_cast<std::streamsize>(blobs.size()));
+    _file.write(_padding.data(), static_cast<std::streamsize>(_header.tableOffset - BLOB_START - blobs.size()));
+    _file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(ArchiveEntry)));
+    if (!_file.flush())
+    {
+        throw std::runtime_error("Failed to write asset archive " + path.string() + "!");
+    }
+}
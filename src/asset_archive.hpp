@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "texture_codec.hpp"
+
+// Packed asset archive (.vkpa): a header, the blobs, then a table describing them. Blobs are
+// stored exactly as they are uploaded (vertex/index data, GPU-compressed texture mip chains), so
+// loading is a copy from the mapped file into staging memory. Integers are little endian.
+constexpr uint32_t ASSET_ARCHIVE_VERSION { 2 };
+// Blob offsets are aligned to this, enough for any vertex attribute and BC block.
+constexpr uint64_t ASSET_ALIGNMENT { 16 };
+
+enum class AssetType : uint32_t
+{
+    Buffer,
+    Texture
+};
+
+struct ArchiveHeader
+{
+    char magic[4]           { 'V', 'K', 'P', 'A' };
+    uint32_t version        { ASSET_ARCHIVE_VERSION };
+    uint32_t entryCount     { };
+    uint32_t padding        { };
+    uint64_t tableOffset    { };
+};
+static_assert(sizeof(ArchiveHeader) == 24);
+
+struct ArchiveEntry
+{
+    // Zero terminated.
+    char name[32]           { };
+    AssetType type          { };
+    // Textures only.
+    TextureEncoding encoding { };
+    uint32_t width          { };
+    uint32_t height         { };
+    uint32_t mipLevels      { };
+    uint32_t padding        { };
+    uint64_t offset         { };
+    uint64_t size           { };
+
+    std::string_view nameView() const;
+};
+static_assert(sizeof(ArchiveEntry) == 72);
+
+// Reads and validates the header and entry table, for loaders that read the file themselves.
+// Throws std::runtime_error when the file is not a valid archive.
+std::vector<ArchiveEntry> readArchiveTable(std::istream& in, uint64_t fileSize);
+
+// Finds an entry by name, throws when it is missing or of a different type.
+const ArchiveEntry& findArchiveEntry(std::span<const ArchiveEntry> entries, std::string_view name, AssetType type);
+
+// Read-only memory mapping of an archive. Pages are faulted in by whoever touches them first, so
+// copying blobs on several threads also reads the file in parallel.
+class AssetArchive
+{
+public:
+    explicit AssetArchive(const std::filesystem::path& path);
+    ~AssetArchive();
+
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    std::span<const ArchiveEntry> entries() const { return table; }
+    const ArchiveEntry& entry(std::string_view name, AssetType type) const { return findArchiveEntry(table, name, type); }
+    std::span<const std::byte> data(const ArchiveEntry& entry) const { return mapped.subspan(entry.offset, entry.size); }
+    uint64_t fileSize() const { return mapped.size(); }
+
+private:
+    void unmap();
+
+    std::span<const std::byte> mapped;
+    std::vector<ArchiveEntry> table;
+#ifdef _WIN32
+    void* file          { };
+    void* mapping       { };
+#endif
+};
+
+// Collects blobs in memory and writes them out as an archive, used by the asset baker.
+class AssetArchiveWriter
+{
+public:
+    void addBuffer(std::string_view name, std::span<const std::byte> data);
+    void addTexture(std::string_view name, TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t mipLevels,
+        std::span<const std::byte> data);
+
+    // Throws std::runtime_error when the file can't be written.
+    void write(const std::filesystem::path& path) const;
+
+private:
+    void add(std::string_view name, ArchiveEntry entry, std::span<const std::byte> data);
+
+    std::vector<ArchiveEntry> table;
+    std::vector<std::byte> blobs;
+};
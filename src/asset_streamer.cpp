@@ -0,0 +1,276 @@
+#include "asset_streamer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Copies are split into pieces of this size so a single big blob still spreads over all workers.
+    constexpr size_t PIECE_SIZE { 256 * 1024 };
+    // BC1 block rows decompressed per job.
+    constexpr uint32_t DECODE_ROWS { 32 };
+
+    struct SceneBuffer
+    {
+        const char* name;
+        VkBufferUsageFlags usage;
+        GpuBuffer GpuSceneAssets::* member;
+    };
+
+    constexpr std::array<SceneBuffer, 4> SCENE_BUFFERS { {
+        { SCENE_VERTICES_ASSET, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &GpuSceneAssets::vertices },
+        { SCENE_INDICES_ASSET, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &GpuSceneAssets::indices },
+        { SCENE_MESHES_ASSET, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &GpuSceneAssets::meshes },
+        { SCENE_MESHLETS_ASSET, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &GpuSceneAssets::meshlets }
+    } };
+
+    // Textures are decompressed when the device can't sample what the archive stores.
+    TextureEncoding uploadEncoding(const ArchiveEntry& entry, bool compressedTextures)
+    {
+        return compressedTextures ? entry.encoding : TextureEncoding::Rgba8;
+    }
+
+    // Either a plain copy of source into staging, or the BC1 block rows [firstRow, firstRow + rowCount)
+    // of a level whose whole blocks and pixels are source and staging.
+    struct StagingJob
+    {
+        std::span<std::byte> staging;
+        std::span<const std::byte> source;
+        bool decode                 { };
+        uint32_t width              { };
+        uint32_t height             { };
+        uint32_t firstRow           { };
+        uint32_t rowCount           { };
+    };
+
+    void runStagingJob(const StagingJob& job)
+    {
+        if (job.decode)
+        {
+            decodeBc1(job.source, job.width, job.height, job.firstRow, job.rowCount, job.staging);
+        }
+        else
+        {
+            std::memcpy(job.staging.data(), job.source.data(), job.source.size());
+        }
+    }
+
+    void queueCopy(std::vector<StagingJob>& jobs, std::span<std::byte> staging, std::span<const std::byte> source)
+    {
+        for (size_t offset = 0; offset < source.size(); offset += PIECE_SIZE)
+        {
+            const auto _size { std::min(PIECE_SIZE, source.size() - offset) };
+            jobs.push_back({ .staging = staging.subspan(offset, _size), .source = source.subspan(offset, _size) });
+        }
+    }
+
+    // Decompresses every level of a BC1 mip chain into an RGBA8 one.
+    void queueDecode(std::vector<StagingJob>& jobs, std::span<std::byte> staging, std::span<const std::byte> source,
+        const ArchiveEntry& entry)
+    {
+        for (uint32_t level = 0; level < entry.mipLevels; level++)
+        {
+            const auto _width { mipExtent(entry.width, level) };
+            const auto _height { mipExtent(entry.height, level) };
+            const auto _blocks { source.subspan(textureLevelOffset(TextureEncoding::Bc1, entry.width, entry.height, level),
+                textureLevelSize(TextureEncoding::Bc1, entry.width, entry.height, level)) };
+            const auto _pixels { staging.subspan(textureLevelOffset(TextureEncoding::Rgba8, entry.width, entry.height, level),
+                textureLevelSize(TextureEncoding::Rgba8, entry.width, entry.height, level)) };
+            const uint32_t _rows { (_height + 3) / 4 };
+            for (uint32_t row = 0; row < _rows; row += DECODE_ROWS)
+            {
+                jobs.push_back({
+                    .staging = _pixels,
+                    .source = _blocks,
+                    .decode = true,
+                    .width = _width,
+                    .height = _height,
+                    .firstRow = row,
+                    .rowCount = std::min(DECODE_ROWS, _rows - row)
+                });
+            }
+        }
+    }
+
+    std::vector<std::byte> readBlob(std::ifstream& file, const ArchiveEntry& entry)
+    {
+        std::vector<std::byte> _data(entry.size);
+        if (!file.seekg(static_cast<std::streamoff>(entry.offset))
+            .read(reinterpret_cast<char*>(_data.data()), static_cast<std::streamsize>(_data.size())))
+        {
+            throw std::runtime_error("Failed to read asset '" + std::string(entry.nameView()) + "'!");
+        }
+        return _data;
+    }
+
+    GpuTexture createTexture(VkDevice device, GpuAllocator& allocator, const ArchiveEntry& entry, TextureEncoding encoding)
+    {
+        return createSceneTexture(device, allocator, textureFormat(encoding), entry.width, entry.height, entry.mipLevels);
+    }
+}
+
+GpuSceneAssets streamSceneAssets(VkDevice device, GpuAllocator& allocator, StagingUploader& uploader, JobSystem& jobs,
+    const AssetArchive& archive, bool compressedTextures, AssetLoadStats& stats)
+{
+    const auto _start { std::chrono::steady_clock::now() };
+    GpuSceneAssets _assets { };
+    std::vector<StagingJob> _jobs;
+
+    // Everything reserved so far has its copy recorded; fill it in parallel and submit it.
+    const auto _runJobs = [&]() {
+        jobs.parallelFor(static_cast<uint32_t>(_jobs.size()),
+            [&](uint32_t, uint32_t index) { runStagingJob(_jobs[index]); });
+        _jobs.clear();
+        uploader.flush();
+    };
+    const auto _reserve = [&](const auto& reserve) {
+        auto _reservation { reserve() };
+        if (!_reservation)
+        {
+            _runJobs();
+            _reservation = reserve();
+        }
+        if (!_reservation)
+        {
+            throw std::runtime_error("Failed to reserve staging memory!");
+        }
+        _assets.uploadSerial = std::max(_assets.uploadSerial, _reservation->serial);
+        stats.bytesStaged += _reservation->memory.size();
+        return _reservation->memory;
+    };
+
+    try
+    {
+        for (const auto& buffer : SCENE_BUFFERS)
+        {
+            const auto& _entry { archive.entry(buffer.name, AssetType::Buffer) };
+            auto& _buffer { _assets.*buffer.member };
+            _buffer = createSceneBuffer(allocator, _entry.size, buffer.usage);
+            const auto _data { archive.data(_entry) };
+            stats.bytesRead += _data.size();
+            // Reserve in pieces too, a buffer may be bigger than the staging ring.
+            const auto _maxPiece { std::max<VkDeviceSize>(uploader.stagingCapacity() / 4, PIECE_SIZE) };
+            for (VkDeviceSize offset = 0; offset < _data.size(); offset += _maxPiece)
+            {
+                const auto _size { std::min<VkDeviceSize>(_data.size() - offset, _maxPiece) };
+                const auto _staging { _reserve([&]() { return uploader.reserveBuffer(_buffer.buffer, offset, _size); }) };
+                queueCopy(_jobs, _staging, _data.subspan(offset, _size));
+            }
+        }
+
+        const auto _textureCount { sceneTextureCount(archive.entries()) };
+        for (uint32_t i = 0; i < _textureCount; i++)
+        {
+            const auto& _entry { archive.entry(sceneTextureAsset(i), AssetType::Texture) };
+            const auto _encoding { uploadEncoding(_entry, compressedTextures) };
+            const auto _size { textureSize(_encoding, _entry.width, _entry.height, _entry.mipLevels) };
+            if (_size > uploader.stagingCapacity())
+            {
+                throw std::runtime_error("Texture '" + sceneTextureAsset(i) + "' does not fit the staging ring!");
+            }
+            const auto& _texture { _assets.textures.emplace_back(createTexture(device, allocator, _entry, _encoding)) };
+            const auto _regions { textureCopyRegions(_encoding, _entry.width, _entry.height, _entry.mipLevels) };
+            const auto _staging { _reserve([&]() {
+                return uploader.reserveImage(_texture.image.image, { VK_IMAGE_ASPECT_COLOR_BIT, 0, _entry.mipLevels, 0, 1 },
+                    _regions, _size, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }) };
+            const auto _data { archive.data(_entry) };
+            stats.bytesRead += _data.size();
+            if (_encoding == _entry.encoding)
+            {
+                queueCopy(_jobs, _staging, _data);
+            }
+            else
+            {
+                queueDecode(_jobs, _staging, _data, _entry);
+            }
+        }
+        _runJobs();
+    }
+    catch (...)
+    {
+        // Recorded copies still target these resources, let them finish first.
+        uploader.waitIdle();
+        destroySceneAssets(device, allocator, _assets);
+        throw;
+    }
+    stats.elapsed = std::chrono::steady_clock::now() - _start;
+    return _assets;
+}
+
+GpuSceneAssets loadSceneAssetsPlain(VkDevice device, GpuAllocator& allocator, StagingUploader& uploader,
+    const std::filesystem::path& path, bool compressedTextures, AssetLoadStats& stats)
+{
+    const auto _start { std::chrono::steady_clock::now() };
+    std::ifstream _file { path, std::ios::binary };
+    if (!_file)
+    {
+        throw std::runtime_error("Failed to open asset archive: " + path.string());
+    }
+    const auto _entries { readArchiveTable(_file, std::filesystem::file_size(path)) };
+
+    GpuSceneAssets _assets { };
+    try
+    {
+        for (const auto& buffer : SCENE_BUFFERS)
+        {
+            const auto& _entry { findArchiveEntry(_entries, buffer.name, AssetType::Buffer) };
+            auto& _buffer { _assets.*buffer.member };
+            _buffer = createSceneBuffer(allocator, _entry.size, buffer.usage);
+            const auto _data { readBlob(_file, _entry) };
+            stats.bytesRead += _data.size();
+            if (!_data.empty())
+            {
+                _assets.uploadSerial = std::max(_assets.uploadSerial, uploader.uploadBuffer(_buffer.buffer, 0, _data));
+                stats.bytesStaged += _data.size();
+            }
+        }
+
+        const auto _textureCount { sceneTextureCount(_entries) };
+        for (uint32_t i = 0; i < _textureCount; i++)
+        {
+            const auto& _entry { findArchiveEntry(_entries, sceneTextureAsset(i), AssetType::Texture) };
+            const auto _encoding { uploadEncoding(_entry, compressedTextures) };
+            auto _data { readBlob(_file, _entry) };
+            stats.bytesRead += _data.size();
+            if (_encoding != _entry.encoding)
+            {
+                std::vector<std::byte> _pixels(textureSize(_encoding, _entry.width, _entry.height, _entry.mipLevels));
+                std::vector<StagingJob> _jobs;
+                queueDecode(_jobs, _pixels, _data, _entry);
+                for (const auto& job : _jobs)
+                {
+                    runStagingJob(job);
+                }
+                _data = std::move(_pixels);
+            }
+            const auto& _texture { _assets.textures.emplace_back(createTexture(device, allocator, _entry, _encoding)) };
+            const auto _regions { textureCopyRegions(_encoding, _entry.width, _entry.height, _entry.mipLevels) };
+            _assets.uploadSerial = std::max(_assets.uploadSerial, uploader.uploadImage(_texture.image.image,
+                { VK_IMAGE_ASPECT_COLOR_BIT, 0, _entry.mipLevels, 0, 1 }, _regions, _data, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+            stats.bytesStaged += _data.size();
+        }
+        uploader.flush();
+    }
+    catch (...)
+    {
+        uploader.waitIdle();
+        destroySceneAssets(device, allocator, _assets);
+        throw;
+    }
+    stats.elapsed = std::chrono::steady_clock::now() - _start;
+    return _assets;
+}
+
+void reportAssetLoad(std::ostream& out, std::string_view loader, const AssetLoadStats& stats)
+{
+    const auto _seconds { stats.elapsed.count() };
+    out << "\t" << loader << ": " << stats.bytesRead / 1e6 << " MB read, " << stats.bytesStaged / 1e6 << " MB staged in "
+        << _seconds * 1e3 << " ms (" << (_seconds > 0.0 ? stats.bytesRead / 1e6 / _seconds : 0.0) << " MB/s)\n";
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <string_view>
+
+#include <vulkan/vulkan.h>
+
+#include "asset_archive.hpp"
+#include "gpu_allocator.hpp"
+#include "job_system.hpp"
+#include "scene_archive.hpp"
+#include "scene_assets.hpp"
+#include "staging_uploader.hpp"
+
+struct AssetLoadStats
+{
+    // Bytes read from the archive and bytes written to staging memory, more than read when BC1
+    // textures had to be decompressed.
+    uint64_t bytesRead          { };
+    uint64_t bytesStaged        { };
+    // Until the last batch was submitted, the copies themselves run on the transfer queue.
+    std::chrono::duration<double> elapsed { };
+};
+
+// Loads an archived scene's geometry and textures. Workers copy (or, when the device can't sample
+// BC1, decompress) every blob from the mapped archive straight into reserved staging memory, the
+// calling thread only reserves, records and submits.
+GpuSceneAssets streamSceneAssets(VkDevice device, GpuAllocator& allocator, StagingUploader& uploader, JobSystem& jobs,
+    const AssetArchive& archive, bool compressedTextures, AssetLoadStats& stats);
+
+// The same load done the way a tutorial loader would: read each blob into a std::vector on the
+// calling thread, decompress into another one if needed, and hand that to the uploader. Only
+// here as the baseline for --bench-assets.
+GpuSceneAssets loadSceneAssetsPlain(VkDevice device, GpuAllocator& allocator, StagingUploader& uploader,
+    const std::filesystem::path& path, bool compressedTextures, AssetLoadStats& stats);
+
+void reportAssetLoad(std::ostream& out, std::string_view loader, const AssetLoadStats& stats);
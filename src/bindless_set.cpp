@@ -0,0 +1,160 @@
+#include "bindless_set.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include "vulkan_dispatch.hpp"
+
+uint32_t BindlessSet::SlotAllocator::allocate(const char* kind)
+{
+    if (!freeSlots.empty())
+    {
+        const auto _index { freeSlots.back() };
+        freeSlots.pop_back();
+        return _index;
+    }
+    if (next == capacity)
+    {
+        throw std::runtime_error(std::string("Bindless set is out of ") + kind + " slots!");
+    }
+    return next++;
+}
+
+void BindlessSet::SlotAllocator::free(uint32_t index)
+{
+    freeSlots.push_back(index);
+}
+
+BindlessSet::BindlessSet(VkDevice device, uint32_t maxBuffers, uint32_t maxTextures)
+    : device(device)
+{
+    buffers.capacity = maxBuffers;
+    textures.capacity = maxTextures;
+
+    const std::array<VkDescriptorSetLayoutBinding, 2> _bindings { {
+        {
+            .binding = BUFFER_BINDING,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = maxBuffers,
+            .stageFlags = VK_SHADER_STAGE_ALL
+        },
+        {
+            .binding = TEXTURE_BINDING,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = maxTextures,
+            .stageFlags = VK_SHADER_STAGE_ALL
+        }
+    } };
+    constexpr VkDescriptorBindingFlags BINDLESS_FLAGS {
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+    };
+    const std::array<VkDescriptorBindingFlags, 2> _bindingFlags {
+        BINDLESS_FLAGS,
+        BINDLESS_FLAGS | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT
+    };
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(_bindingFlags.size()),
+        .pBindingFlags = _bindingFlags.data()
+    };
+    VkDescriptorSetLayoutCreateInfo layoutInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &bindingFlagsInfo,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = static_cast<uint32_t>(_bindings.size()),
+        .pBindings = _bindings.data()
+    };
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create bindless descriptor set layout!");
+    }
+
+    const std::array<VkDescriptorPoolSize, 2> _poolSizes { {
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxBuffers },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxTextures }
+    } };
+    VkDescriptorPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = static_cast<uint32_t>(_poolSizes.size()),
+        .pPoolSizes = _poolSizes.data()
+    };
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create bindless descriptor pool!");
+    }
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
+        .descriptorSetCount = 1,
+        .pDescriptorCounts = &maxTextures
+    };
+    VkDescriptorSetAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = &variableCountInfo,
+        .descriptorPool = pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &setLayout
+    };
+    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate bindless descriptor set!");
+    }
+}
+
+BindlessSet::~BindlessSet()
+{
+    vkDestroyDescriptorPool(device, pool, nullptr);
+    vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+}
+
+uint32_t BindlessSet::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+    const auto _index { buffers.allocate("buffer") };
+    VkDescriptorBufferInfo bufferInfo { buffer, offset, range };
+    VkWriteDescriptorSet write {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = descriptorSet,
+        .dstBinding = BUFFER_BINDING,
+        .dstArrayElement = _index,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &bufferInfo
+    };
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return _index;
+}
+
+uint32_t BindlessSet::addTexture(VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    const auto _index { textures.allocate("texture") };
+    updateTexture(_index, imageView, sampler, layout);
+    return _index;
+}
+
+void BindlessSet::updateTexture(uint32_t index, VkImageView imageView, VkSampler sampler, VkImageLayout layout)
+{
+    VkDescriptorImageInfo imageInfo { sampler, imageView, layout };
+    VkWriteDescriptorSet write {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = descriptorSet,
+        .dstBinding = TEXTURE_BINDING,
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &imageInfo
+    };
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+void BindlessSet::removeBuffer(uint32_t index)
+{
+    buffers.free(index);
+}
+
+void BindlessSet::removeTexture(uint32_t index)
+{
+    textures.free(index);
+}
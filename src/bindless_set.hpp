@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "shader_module.hpp"
+
+// The one global descriptor set every pipeline binds at set 0: an array of storage buffers and an
+// array of combined image samplers, indexed from shaders with the handles returned by add*().
+// Created UPDATE_AFTER_BIND | PARTIALLY_BOUND, so new resources can be added while frames that
+// bound the set are still in flight. Slots must not be removed while the GPU may still read them.
+class BindlessSet
+{
+public:
+    static constexpr uint32_t BUFFER_BINDING    { 0 };
+    // Last binding, its size is the variable descriptor count.
+    static constexpr uint32_t TEXTURE_BINDING   { 1 };
+    // What shaders may declare in set 0, for shaderBindingsMatch().
+    static constexpr std::array<ShaderBinding, 2> SHADER_BINDINGS { {
+        { 0, BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0 },
+        { 0, TEXTURE_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0 }
+    } };
+
+    BindlessSet(VkDevice device, uint32_t maxBuffers, uint32_t maxTextures);
+    ~BindlessSet();
+
+    BindlessSet(const BindlessSet&) = delete;
+    BindlessSet& operator=(const BindlessSet&) = delete;
+
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    uint32_t addTexture(VkImageView imageView, VkSampler sampler,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // Points an existing slot at a different resource, e.g. after a resize.
+    void updateTexture(uint32_t index, VkImageView imageView, VkSampler sampler,
+        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void removeBuffer(uint32_t index);
+    void removeTexture(uint32_t index);
+
+    VkDescriptorSetLayout layout() const { return setLayout; }
+    VkDescriptorSet set() const { return descriptorSet; }
+
+private:
+    struct SlotAllocator
+    {
+        uint32_t capacity           { };
+        uint32_t next               { };
+        std::vector<uint32_t> freeSlots;
+
+        uint32_t allocate(const char* kind);
+        void free(uint32_t index);
+    };
+
+    VkDevice device                     { };
+    VkDescriptorSetLayout setLayout     { };
+    VkDescriptorPool pool               { };
+    VkDescriptorSet descriptorSet       { };
+    SlotAllocator buffers;
+    SlotAllocator textures;
+};
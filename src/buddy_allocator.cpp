@@ -0,0 +1,106 @@
+#include "buddy_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t minBlockSize)
+    : totalSize(size)
+{
+    if (!std::has_single_bit(size) || !std::has_single_bit(minBlockSize) || minBlockSize > size)
+    {
+        throw std::invalid_argument("Buddy allocator sizes must be powers of two!");
+    }
+    levelCount = static_cast<uint32_t>(std::countr_zero(size) - std::countr_zero(minBlockSize)) + 1;
+    freeLists.resize(levelCount);
+    freeLists[0].insert(0);
+}
+
+std::optional<uint32_t> BuddyAllocator::levelFor(uint64_t size, uint64_t alignment) const
+{
+    const auto _needed { std::bit_ceil(std::max({ size, alignment, blockSize(levelCount - 1) })) };
+    if (_needed > totalSize)
+    {
+        return std::nullopt;
+    }
+    return static_cast<uint32_t>(std::countr_zero(totalSize) - std::countr_zero(_needed));
+}
+
+uint64_t BuddyAllocator::blockSizeFor(uint64_t size, uint64_t alignment) const
+{
+    const auto _level { levelFor(size, alignment) };
+    return _level ? blockSize(*_level) : 0;
+}
+
+std::optional<uint64_t> BuddyAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+    const auto _targetLevel { levelFor(size, alignment) };
+    if (!_targetLevel)
+    {
+        return std::nullopt;
+    }
+
+    // Find the smallest free block that is big enough, then split it down to the target level.
+    auto _source { static_cast<int64_t>(*_targetLevel) };
+    while (_source >= 0 && freeLists[_source].empty())
+    {
+        _source--;
+    }
+    if (_source < 0)
+    {
+        return std::nullopt;
+    }
+
+    auto _splitLevel { static_cast<uint32_t>(_source) };
+    const auto _offset { *freeLists[_splitLevel].begin() };
+    freeLists[_splitLevel].erase(freeLists[_splitLevel].begin());
+    while (_splitLevel < *_targetLevel)
+    {
+        _splitLevel++;
+        freeLists[_splitLevel].insert(_offset + blockSize(_splitLevel));
+    }
+
+    allocatedLevels.emplace(_offset, *_targetLevel);
+    used += blockSize(*_targetLevel);
+    return _offset;
+}
+
+void BuddyAllocator::free(uint64_t offset)
+{
+    const auto _it { allocatedLevels.find(offset) };
+    if (_it == allocatedLevels.end())
+    {
+        throw std::invalid_argument("Freeing an offset that was never allocated!");
+    }
+    auto _level { _it->second };
+    allocatedLevels.erase(_it);
+    used -= blockSize(_level);
+
+    // Merge with the buddy for as long as it is free as well.
+    auto _offset { offset };
+    while (_level > 0)
+    {
+        const auto _buddy { _offset ^ blockSize(_level) };
+        const auto _buddyIt { freeLists[_level].find(_buddy) };
+        if (_buddyIt == freeLists[_level].end())
+        {
+            break;
+        }
+        freeLists[_level].erase(_buddyIt);
+        _offset = std::min(_offset, _buddy);
+        _level--;
+    }
+    freeLists[_level].insert(_offset);
+}
+
+uint64_t BuddyAllocator::largestFreeBlock() const
+{
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        if (!freeLists[level].empty())
+        {
+            return blockSize(level);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// Binary buddy allocator over an abstract [0, size) range, used to carve long-lived resources out
+// of large VkDeviceMemory blocks. Every allocation is a power-of-two sized block that is aligned
+// to its own size, so any alignment up to the block size is satisfied for free.
+class BuddyAllocator
+{
+public:
+    // size and minBlockSize must be powers of two, minBlockSize <= size.
+    BuddyAllocator(uint64_t size, uint64_t minBlockSize);
+
+    // Returns the offset of a block holding at least size bytes aligned to alignment.
+    std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment);
+    void free(uint64_t offset);
+
+    uint64_t size() const { return blockSize(0); }
+    uint64_t usedBytes() const { return used; }
+    uint64_t freeBytes() const { return size() - used; }
+    uint64_t largestFreeBlock() const;
+    bool empty() const { return used == 0; }
+
+    // Size of the block that an allocation of size/alignment would occupy.
+    uint64_t blockSizeFor(uint64_t size, uint64_t alignment) const;
+
+private:
+    uint64_t blockSize(uint32_t level) const { return totalSize >> level; }
+    std::optional<uint32_t> levelFor(uint64_t size, uint64_t alignment) const;
+
+    uint64_t totalSize                          { };
+    uint32_t levelCount                         { };
+    uint64_t used                               { };
+    // Ordered so allocation prefers low offsets, which keeps the tail of the block free.
+    std::vector<std::set<uint64_t>> freeLists;
+    std::unordered_map<uint64_t, uint32_t> allocatedLevels;
+};
@@ -0,0 +1,86 @@
+#include "deferred_deleter.hpp"
+
+#include <algorithm>
+
+DeferredDeleter::DeferredDeleter()
+    : head(&stub), tail(&stub)
+{
+}
+
+DeferredDeleter::~DeferredDeleter()
+{
+    while (auto* node = pop())
+    {
+        delete node;
+    }
+    for (auto* node : pending)
+    {
+        delete node;
+    }
+}
+
+void DeferredDeleter::enqueue(uint64_t lastUse, Deletion deletion)
+{
+    push(new Node { .lastUse = lastUse, .deletion = std::move(deletion) });
+}
+
+void DeferredDeleter::collect(uint64_t completed)
+{
+    while (auto* node = pop())
+    {
+        pending.push_back(node);
+    }
+    std::erase_if(pending, [&](Node* node)
+    {
+        if (node->lastUse > completed)
+        {
+            return false;
+        }
+        node->deletion();
+        delete node;
+        return true;
+    });
+}
+
+void DeferredDeleter::push(Node* node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    // Between the exchange and the store the chain is broken, pop() sees that as empty.
+    auto* _previous { head.exchange(node, std::memory_order_acq_rel) };
+    _previous->next.store(node, std::memory_order_release);
+}
+
+DeferredDeleter::Node* DeferredDeleter::pop()
+{
+    auto* _tail { tail };
+    auto* _next { _tail->next.load(std::memory_order_acquire) };
+    if (_tail == &stub)
+    {
+        if (!_next)
+        {
+            return nullptr;
+        }
+        tail = _next;
+        _tail = _next;
+        _next = _next->next.load(std::memory_order_acquire);
+    }
+    if (_next)
+    {
+        tail = _next;
+        return _tail;
+    }
+    // _tail is the last node, unless a producer is halfway through push(): then try again later.
+    if (_tail != head.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    // Re-insert the stub behind it so _tail can be handed out.
+    push(&stub);
+    _next = _tail->next.load(std::memory_order_acquire);
+    if (_next)
+    {
+        tail = _next;
+        return _tail;
+    }
+    return nullptr;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+// Destroys objects once the GPU is done with them instead of idling the device: every deletion is
+// queued with the last frame number (or timeline semaphore value, one deleter per counter) that
+// may still use the object, and collect() runs those whose value has completed.
+//
+// enqueue() is lock-free and may be called from any thread, e.g. asset loaders replacing a texture
+// or recording workers retiring per-thread resources. collect() and flush() belong to a single
+// consumer, the render loop; deletions run there in no particular order.
+class DeferredDeleter
+{
+public:
+    using Deletion = std::move_only_function<void()>;
+
+    DeferredDeleter();
+    // Drops whatever is still pending without running it, flush() before the device goes.
+    ~DeferredDeleter();
+
+    DeferredDeleter(const DeferredDeleter&) = delete;
+    DeferredDeleter& operator=(const DeferredDeleter&) = delete;
+
+    void enqueue(uint64_t lastUse, Deletion deletion);
+
+    // Runs every deletion whose lastUse is <= completed.
+    void collect(uint64_t completed);
+    // After vkDeviceWaitIdle: runs everything.
+    void flush() { collect(std::numeric_limits<uint64_t>::max()); }
+
+    // Consumer only, deletions not yet run.
+    size_t pendingCount() const { return pending.size(); }
+
+private:
+    struct Node
+    {
+        std::atomic<Node*> next     { };
+        uint64_t lastUse            { };
+        Deletion deletion;
+    };
+
+    // Intrusive MPSC queue (Vyukov): producers swap themselves in as the head with one atomic
+    // exchange, the consumer walks from the tail. stub keeps the queue non-empty.
+    void push(Node* node);
+    Node* pop();
+
+    std::atomic<Node*> head;
+    Node* tail;
+    Node stub;
+
+    // Drained from the queue but not yet completed, values arrive out of order across threads.
+    std::vector<Node*> pending;
+};
@@ -0,0 +1,343 @@
+#include "device_selector.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <stdexcept>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    uint64_t typeRank(VkPhysicalDeviceType type)
+    {
+        switch (type)
+        {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            return 4;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            return 3;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            return 2;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+
+    const char* typeName(VkPhysicalDeviceType type)
+    {
+        switch (type)
+        {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            return "discrete";
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            return "integrated";
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            return "virtual";
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            return "cpu";
+        default:
+            return "other";
+        }
+    }
+
+    // Feature structs are nothing but VkBool32 members, after sType/pNext for the chained ones.
+    constexpr size_t FEATURES12_OFFSET { offsetof(VkPhysicalDeviceVulkan12Features, samplerMirrorClampToEdge) };
+
+    template<size_t Offset, typename Features>
+    std::span<const VkBool32> featureBools(const Features& features)
+    {
+        return { reinterpret_cast<const VkBool32*>(reinterpret_cast<const std::byte*>(&features) + Offset),
+            (sizeof(Features) - Offset) / sizeof(VkBool32) };
+    }
+
+    // Adds the supported features to optionalFeatures, false when a required one is missing.
+    template<size_t Offset = 0, typename Features>
+    bool checkFeatures(const Features& required, const Features& supported, uint64_t& optionalFeatures)
+    {
+        const auto _required { featureBools<Offset>(required) };
+        const auto _supported { featureBools<Offset>(supported) };
+        for (size_t i = 0; i < _required.size(); i++)
+        {
+            if (_required[i] && !_supported[i])
+            {
+                return false;
+            }
+            optionalFeatures += _supported[i] ? 1 : 0;
+        }
+        return true;
+    }
+
+    QueueFamilyIndicies findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface,
+        std::span<const VkQueueFamilyProperties> queueFamilies)
+    {
+        QueueFamilyIndicies indicies;
+        for (uint32_t i = 0; i < queueFamilies.size(); i++)
+        {
+            const auto _flags { queueFamilies[i].queueFlags };
+            // Culling and the Hi-Z build are compute dispatches recorded alongside the draws.
+            const bool _graphics { (_flags & VK_QUEUE_GRAPHICS_BIT) && (_flags & VK_QUEUE_COMPUTE_BIT) };
+            VkBool32 presentSupport { };
+            if (surface)
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            }
+
+            // A family that does both avoids the per-frame ownership transfer, so it wins over
+            // the first graphics and first present family found separately.
+            if (_graphics && presentSupport
+                && !(indicies.graphicsFamily && indicies.graphicsFamily == indicies.presentFamily))
+            {
+                indicies.graphicsFamily = i;
+                indicies.presentFamily = i;
+            }
+            if (!indicies.graphicsFamily && _graphics)
+            {
+                indicies.graphicsFamily = i;
+            }
+            if (!indicies.presentFamily && presentSupport)
+            {
+                indicies.presentFamily = i;
+            }
+            if (!indicies.transferFamily && _flags & VK_QUEUE_TRANSFER_BIT
+                && !(_flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+            {
+                indicies.transferFamily = i;
+            }
+        }
+        return indicies;
+    }
+
+    SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
+    {
+        SwapChainSupportDetails details;
+
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
+
+        uint32_t _formatCount { };
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &_formatCount, nullptr);
+        details.formats.resize(_formatCount);
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &_formatCount, details.formats.data());
+
+        uint32_t _presentModeCount { };
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &_presentModeCount, nullptr);
+        details.presentModes.resize(_presentModeCount);
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &_presentModeCount, details.presentModes.data());
+
+        return details;
+    }
+
+    bool supportsDynamicRendering(const DeviceProbe& probe)
+    {
+        VkPhysicalDeviceVulkan13Features _features13 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+        VkPhysicalDeviceSynchronization2Features _synchronization2 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES };
+        VkPhysicalDeviceDynamicRenderingFeatures _dynamicRendering {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES,
+            .pNext = &_synchronization2
+        };
+        VkPhysicalDeviceFeatures2 features2 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        if (probe.properties.apiVersion >= VK_API_VERSION_1_3)
+        {
+            features2.pNext = &_features13;
+            vkGetPhysicalDeviceFeatures2(probe.device, &features2);
+            return _features13.dynamicRendering && _features13.synchronization2;
+        }
+        if (probe.properties.apiVersion < VK_API_VERSION_1_1 || !probe.hasExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)
+            || !probe.hasExtension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+        {
+            return false;
+        }
+        features2.pNext = &_dynamicRendering;
+        vkGetPhysicalDeviceFeatures2(probe.device, &features2);
+        return _dynamicRendering.dynamicRendering && _synchronization2.synchronization2;
+    }
+
+    DeviceProbe probeDevice(VkPhysicalDevice device, VkSurfaceKHR surface, const DeviceRequirements& requirements)
+    {
+        DeviceProbe _probe { .device = device };
+        vkGetPhysicalDeviceProperties(device, &_probe.properties);
+        if (_probe.properties.apiVersion >= VK_API_VERSION_1_2)
+        {
+            VkPhysicalDeviceFeatures2 features2 {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &_probe.features12
+            };
+            vkGetPhysicalDeviceFeatures2(device, &features2);
+            _probe.features = features2.features;
+            _probe.features12.pNext = nullptr;
+        }
+        else
+        {
+            vkGetPhysicalDeviceFeatures(device, &_probe.features);
+        }
+        vkGetPhysicalDeviceMemoryProperties(device, &_probe.memory);
+
+        uint32_t _queueFamilyCount { };
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &_queueFamilyCount, nullptr);
+        _probe.queueFamilyProperties.resize(_queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &_queueFamilyCount, _probe.queueFamilyProperties.data());
+
+        uint32_t _extensionCount { };
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &_extensionCount, nullptr);
+        _probe.extensions.resize(_extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &_extensionCount, _probe.extensions.data());
+        _probe.dynamicRendering = supportsDynamicRendering(_probe);
+
+        for (uint32_t i = 0; i < _probe.memory.memoryHeapCount; i++)
+        {
+            if (_probe.memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            {
+                _probe.deviceLocalBytes += _probe.memory.memoryHeaps[i].size;
+            }
+        }
+
+        evaluateDevice(_probe, surface, requirements);
+        return _probe;
+    }
+
+    bool containsIgnoreCase(std::string_view haystack, std::string_view needle)
+    {
+        return !std::ranges::search(haystack, needle, [](char a, char b)
+        {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        }).empty();
+    }
+}
+
+void evaluateDevice(DeviceProbe& probe, VkSurfaceKHR surface, const DeviceRequirements& requirements)
+{
+    probe.rejectReason.clear();
+    probe.score = 0;
+    probe.queueFamilies = findQueueFamilies(probe.device, surface, probe.queueFamilyProperties);
+    if (probe.properties.apiVersion < requirements.apiVersion)
+    {
+        probe.rejectReason = "Vulkan " + std::to_string(VK_API_VERSION_MAJOR(requirements.apiVersion)) + "."
+            + std::to_string(VK_API_VERSION_MINOR(requirements.apiVersion)) + " not supported";
+        return;
+    }
+    for (const auto* extension : requirements.extensions)
+    {
+        if (!probe.hasExtension(extension))
+        {
+            probe.rejectReason = std::string("missing ") + extension;
+            return;
+        }
+    }
+
+    uint64_t _optionalFeatures { };
+    if (!checkFeatures(requirements.features, probe.features, _optionalFeatures)
+        || !checkFeatures<FEATURES12_OFFSET>(requirements.features12, probe.features12, _optionalFeatures))
+    {
+        probe.rejectReason = "missing a required feature";
+        return;
+    }
+
+    if (!probe.queueFamilies.isComplete(surface != VK_NULL_HANDLE))
+    {
+        probe.rejectReason = surface ? "no graphics or present queue" : "no graphics queue";
+        return;
+    }
+    if (surface)
+    {
+        probe.swapChainSupport = querySwapChainSupport(probe.device, surface);
+        if (probe.swapChainSupport.formats.empty() || probe.swapChainSupport.presentModes.empty())
+        {
+            probe.rejectReason = "no usable surface formats or present modes";
+            return;
+        }
+    }
+
+    // Type dominates, VRAM (in MiB, at most 2^20 of them) breaks ties within a type and the
+    // number of supported optional features breaks ties between identical boards.
+    const auto _vramMiB { std::min<uint64_t>(probe.deviceLocalBytes >> 20, (1ull << 20) - 1) };
+    probe.score = typeRank(probe.properties.deviceType) << 40 | _vramMiB << 8 | _optionalFeatures;
+}
+
+bool DeviceProbe::hasExtension(std::string_view name) const
+{
+    return std::ranges::any_of(extensions, [&](const auto& extension) { return name == extension.extensionName; });
+}
+
+std::vector<DeviceProbe> probeDevices(VkInstance instance, VkSurfaceKHR surface, const DeviceRequirements& requirements)
+{
+    uint32_t deviceCount { };
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    if (!deviceCount)
+    {
+        throw std::runtime_error("Failed to find GPUs with Vulkan support!");
+    }
+    std::vector<VkPhysicalDevice> _devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, _devices.data());
+
+    std::vector<DeviceProbe> _probes;
+    _probes.reserve(_devices.size());
+    for (const auto device : _devices)
+    {
+        _probes.push_back(probeDevice(device, surface, requirements));
+    }
+    // Stable, so equal devices keep the driver's enumeration order.
+    std::ranges::stable_sort(_probes, [](const DeviceProbe& a, const DeviceProbe& b)
+    {
+        return a.suitable() != b.suitable() ? a.suitable() : a.score > b.score;
+    });
+    return _probes;
+}
+
+const DeviceProbe& selectDevice(std::span<const DeviceProbe> devices, std::string_view preference)
+{
+    if (preference.empty())
+    {
+        if (devices.empty() || !devices.front().suitable())
+        {
+            throw std::runtime_error("Failed to find a suitable GPU!");
+        }
+        return devices.front();
+    }
+
+    const DeviceProbe* _match { };
+    size_t _index { };
+    const auto [ptr, ec] = std::from_chars(preference.data(), preference.data() + preference.size(), _index);
+    if (ec == std::errc() && ptr == preference.data() + preference.size())
+    {
+        _match = _index < devices.size() ? &devices[_index] : nullptr;
+    }
+    else
+    {
+        const auto _it { std::ranges::find_if(devices, [&](const DeviceProbe& probe)
+        {
+            return containsIgnoreCase(probe.properties.deviceName, preference);
+        }) };
+        _match = _it != devices.end() ? &*_it : nullptr;
+    }
+
+    if (!_match)
+    {
+        throw std::runtime_error("No GPU matches '" + std::string(preference) + "'");
+    }
+    if (!_match->suitable())
+    {
+        throw std::runtime_error(std::string("Requested GPU ") + _match->properties.deviceName + " is unsuitable: "
+            + _match->rejectReason);
+    }
+    return *_match;
+}
+
+void reportDevices(std::ostream& out, std::span<const DeviceProbe> devices, const DeviceProbe& selected)
+{
+    out << "GPUs:\n";
+    for (size_t i = 0; i < devices.size(); i++)
+    {
+        const auto& _probe { devices[i] };
+        out << (&_probe == &selected ? "  * " : "    ") << i << ": " << _probe.properties.deviceName << " ("
+            << typeName(_probe.properties.deviceType) << ", " << (_probe.deviceLocalBytes >> 20) << " MiB device local"
+            << (_probe.dynamicRendering ? ", dynamic rendering" : "") << ")";
+        if (!_probe.suitable())
+        {
+            out << " unsuitable: " << _probe.rejectReason;
+        }
+        out << '\n';
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+struct QueueFamilyIndicies
+{
+    std::optional<uint32_t> graphicsFamily;
+    std::optional<uint32_t> presentFamily;
+    // Transfer-only family (no graphics/compute), copies there run on the DMA engines.
+    std::optional<uint32_t> transferFamily;
+
+    auto isComplete(bool requirePresent = true) const -> bool
+    {
+        return graphicsFamily.has_value() && (presentFamily.has_value() || !requirePresent);
+    }
+};
+
+struct SwapChainSupportDetails
+{
+    VkSurfaceCapabilitiesKHR capabilities { };
+    std::vector<VkSurfaceFormatKHR> formats;
+    std::vector<VkPresentModeKHR> presentModes;
+};
+
+// Everything the application needs to know about a physical device, queried once at startup.
+struct DeviceProbe
+{
+    VkPhysicalDevice device                 { };
+    VkPhysicalDeviceProperties properties   { };
+    VkPhysicalDeviceFeatures features       { };
+    // Only queried when the device supports Vulkan 1.2, all false otherwise.
+    VkPhysicalDeviceVulkan12Features features12 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    VkPhysicalDeviceMemoryProperties memory { };
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties;
+    std::vector<VkExtensionProperties> extensions;
+    QueueFamilyIndicies queueFamilies;
+    // Only filled in when probing against a surface. The capabilities change with the window
+    // size, re-query them when (re)creating the swapchain.
+    SwapChainSupportDetails swapChainSupport;
+    VkDeviceSize deviceLocalBytes           { };
+    // Dynamic rendering and synchronization2 both supported, as core 1.3 features or through
+    // VK_KHR_dynamic_rendering and VK_KHR_synchronization2.
+    bool dynamicRendering                   { };
+
+    // Why the device can't be used, empty when it can.
+    std::string rejectReason;
+    // Higher is better: device type first, then VRAM, then optional features.
+    uint64_t score                          { };
+
+    bool suitable() const { return rejectReason.empty(); }
+    bool hasExtension(std::string_view name) const;
+};
+
+// What a device must support to be usable. The same feature structs are what createLogicalDevice()
+// enables, so nothing gets enabled that was not checked.
+struct DeviceRequirements
+{
+    uint32_t apiVersion                         { VK_API_VERSION_1_0 };
+    std::span<const char* const> extensions;
+    VkPhysicalDeviceFeatures features           { };
+    VkPhysicalDeviceVulkan12Features features12 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+};
+
+// Probes every physical device once against the surface (may be VK_NULL_HANDLE when headless)
+// and the requirements. Result is sorted best first.
+std::vector<DeviceProbe> probeDevices(VkInstance instance, VkSurfaceKHR surface, const DeviceRequirements& requirements);
+
+// The part of probing that depends on the surface and requirements: queue families, swapchain
+// support, suitability and score. For probes whose capabilities were filled in elsewhere, see
+// loadDeviceSnapshot(), where it is the only per-device work left.
+void evaluateDevice(DeviceProbe& probe, VkSurfaceKHR surface, const DeviceRequirements& requirements);
+
+// Picks the best suitable device, or the one matched by preference: a device index as listed by
+// reportDevices() or a case-insensitive substring of the device name. Throws when nothing matches
+// or the preferred device is unsuitable.
+const DeviceProbe& selectDevice(std::span<const DeviceProbe> devices, std::string_view preference);
+
+void reportDevices(std::ostream& out, std::span<const DeviceProbe> devices, const DeviceProbe& selected);
@@ -0,0 +1,226 @@
+#include "device_snapshot.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    // Longer --device preferences are not worth caching for.
+    constexpr size_t MAX_PREFERENCE { 63 };
+
+    struct SnapshotHeader
+    {
+        char magic[4]                           { 'V', 'K', 'P', 'D' };
+        uint32_t version                        { DEVICE_SNAPSHOT_VERSION };
+        uint32_t vendorID                       { };
+        uint32_t deviceID                       { };
+        uint32_t driverVersion                  { };
+        uint32_t apiVersion                     { };
+        uint8_t deviceUUID[VK_UUID_SIZE]        { };
+        uint32_t deviceCount                    { };
+        uint32_t queueFamilyCount               { };
+        uint32_t extensionCount                 { };
+        uint32_t dynamicRendering               { };
+        uint64_t deviceLocalBytes               { };
+        // Zero terminated.
+        char preference[MAX_PREFERENCE + 1]     { };
+        VkPhysicalDeviceFeatures features       { };
+        // sType and pNext are rewritten on load.
+        VkPhysicalDeviceVulkan12Features features12 { };
+        VkPhysicalDeviceMemoryProperties memory { };
+    };
+    // Followed by queueFamilyCount VkQueueFamilyProperties and extensionCount zero terminated
+    // extension names.
+
+    struct DeviceIdentity
+    {
+        VkPhysicalDeviceProperties properties   { };
+        uint8_t deviceUUID[VK_UUID_SIZE]        { };
+    };
+
+    DeviceIdentity queryIdentity(VkPhysicalDevice device)
+    {
+        VkPhysicalDeviceIDProperties _id { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES };
+        VkPhysicalDeviceProperties2 properties2 {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &_id
+        };
+        vkGetPhysicalDeviceProperties2(device, &properties2);
+        DeviceIdentity _identity { .properties = properties2.properties };
+        std::memcpy(_identity.deviceUUID, _id.deviceUUID, VK_UUID_SIZE);
+        return _identity;
+    }
+
+    bool matches(const SnapshotHeader& header, const DeviceIdentity& identity)
+    {
+        const auto& _properties { identity.properties };
+        return header.vendorID == _properties.vendorID && header.deviceID == _properties.deviceID
+            && header.driverVersion == _properties.driverVersion && header.apiVersion == _properties.apiVersion
+            && std::memcmp(header.deviceUUID, identity.deviceUUID, VK_UUID_SIZE) == 0;
+    }
+
+    std::vector<char> readFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            return { };
+        }
+        // A directory or unreadable path reports -1, treat it as a miss.
+        const auto _size { file.tellg() };
+        if (_size < 0)
+        {
+            return { };
+        }
+        std::vector<char> _data(static_cast<size_t>(_size));
+        file.seekg(0);
+        if (!file.read(_data.data(), static_cast<std::streamsize>(_data.size())))
+        {
+            return { };
+        }
+        return _data;
+    }
+}
+
+std::optional<DeviceProbe> loadDeviceSnapshot(VkInstance instance, const std::filesystem::path& path,
+    std::string_view preference)
+{
+    if (path.empty() || preference.size() > MAX_PREFERENCE)
+    {
+        return std::nullopt;
+    }
+    const auto _data { readFile(path) };
+    SnapshotHeader _header { };
+    const SnapshotHeader _expected { };
+    if (_data.size() < sizeof(SnapshotHeader))
+    {
+        return std::nullopt;
+    }
+    std::memcpy(&_header, _data.data(), sizeof(SnapshotHeader));
+    _header.preference[MAX_PREFERENCE] = '\0';
+    if (std::memcmp(_header.magic, _expected.magic, sizeof(_header.magic)) != 0 || _header.version != _expected.version
+        || preference != _header.preference)
+    {
+        return std::nullopt;
+    }
+
+    // Everything is checked against the header before the tail is trusted.
+    const auto _queueFamilyBytes { static_cast<size_t>(_header.queueFamilyCount) * sizeof(VkQueueFamilyProperties) };
+    if (_queueFamilyBytes > _data.size() - sizeof(SnapshotHeader))
+    {
+        return std::nullopt;
+    }
+    std::span<const char> _names { _data.data() + sizeof(SnapshotHeader) + _queueFamilyBytes,
+        _data.size() - sizeof(SnapshotHeader) - _queueFamilyBytes };
+
+    uint32_t _deviceCount { };
+    vkEnumeratePhysicalDevices(instance, &_deviceCount, nullptr);
+    if (_deviceCount != _header.deviceCount)
+    {
+        return std::nullopt;
+    }
+    std::vector<VkPhysicalDevice> _devices(_deviceCount);
+    vkEnumeratePhysicalDevices(instance, &_deviceCount, _devices.data());
+
+    for (const auto device : _devices)
+    {
+        const auto _identity { queryIdentity(device) };
+        if (!matches(_header, _identity))
+        {
+            continue;
+        }
+        DeviceProbe _probe {
+            .device = device,
+            .properties = _identity.properties,
+            .features = _header.features,
+            .features12 = _header.features12,
+            .memory = _header.memory,
+            .deviceLocalBytes = _header.deviceLocalBytes,
+            .dynamicRendering = _header.dynamicRendering != 0
+        };
+        _probe.features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        _probe.features12.pNext = nullptr;
+        _probe.queueFamilyProperties.resize(_header.queueFamilyCount);
+        std::memcpy(_probe.queueFamilyProperties.data(), _data.data() + sizeof(SnapshotHeader), _queueFamilyBytes);
+
+        _probe.extensions.resize(_header.extensionCount);
+        for (auto& extension : _probe.extensions)
+        {
+            const auto _end { std::find(_names.begin(), _names.end(), '\0') };
+            const auto _length { static_cast<size_t>(_end - _names.begin()) };
+            if (_end == _names.end() || _length >= VK_MAX_EXTENSION_NAME_SIZE)
+            {
+                return std::nullopt;
+            }
+            std::memcpy(extension.extensionName, _names.data(), _length);
+            _names = _names.subspan(_length + 1);
+        }
+        return _probe;
+    }
+    return std::nullopt;
+}
+
+bool saveDeviceSnapshot(const std::filesystem::path& path, const DeviceProbe& probe, std::string_view preference,
+    uint32_t deviceCount)
+{
+    if (path.empty() || preference.size() > MAX_PREFERENCE)
+    {
+        return true;
+    }
+    const auto _identity { queryIdentity(probe.device) };
+    SnapshotHeader _header {
+        .vendorID = _identity.properties.vendorID,
+        .deviceID = _identity.properties.deviceID,
+        .driverVersion = _identity.properties.driverVersion,
+        .apiVersion = _identity.properties.apiVersion,
+        .deviceCount = deviceCount,
+        .queueFamilyCount = static_cast<uint32_t>(probe.queueFamilyProperties.size()),
+        .extensionCount = static_cast<uint32_t>(probe.extensions.size()),
+        .dynamicRendering = probe.dynamicRendering ? 1u : 0u,
+        .deviceLocalBytes = probe.deviceLocalBytes,
+        .features = probe.features,
+        .features12 = probe.features12,
+        .memory = probe.memory
+    };
+    std::memcpy(_header.deviceUUID, _identity.deviceUUID, VK_UUID_SIZE);
+    std::memcpy(_header.preference, preference.data(), preference.size());
+    _header.features12.pNext = nullptr;
+
+    auto _tmpPath { path };
+    _tmpPath += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream file(_tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+        file.write(reinterpret_cast<const char*>(probe.queueFamilyProperties.data()),
+            static_cast<std::streamsize>(probe.queueFamilyProperties.size() * sizeof(VkQueueFamilyProperties)));
+        for (const auto& extension : probe.extensions)
+        {
+            file.write(extension.extensionName, static_cast<std::streamsize>(std::strlen(extension.extensionName) + 1));
+        }
+        if (!file.flush())
+        {
+            std::cerr << "Failed to write device snapshot " << _tmpPath << "\n";
+            file.close();
+            std::filesystem::remove(_tmpPath, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(_tmpPath, path, ec);
+    if (ec)
+    {
+        std::cerr << "Failed to replace device snapshot " << path << ": " << ec.message() << "\n";
+        std::filesystem::remove(_tmpPath, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+#include <vulkan/vulkan.h>
+
+#include "device_selector.hpp"
+
+// Capabilities of the device picked on the previous launch, so that later ones skip probing every
+// GPU's features, extensions and queue families. The snapshot is keyed on vendor, device, driver
+// version, API version and device UUID, the number of GPUs present and the --device preference
+// that picked it; anything else is a miss and startup probes as usual. Stored in native byte
+// order, it never leaves the machine that wrote it.
+constexpr uint32_t DEVICE_SNAPSHOT_VERSION { 1 };
+
+// Returns the probe for the snapshot's device, or nullopt when there is no snapshot or it does not
+// match. Properties are always queried fresh, which is also how the device is found; run
+// evaluateDevice() on the result, the surface is not part of the snapshot.
+std::optional<DeviceProbe> loadDeviceSnapshot(VkInstance instance, const std::filesystem::path& path,
+    std::string_view preference);
+
+// Writes atomically like PipelineCache::save(). Does not throw, returns false and logs on failure.
+bool saveDeviceSnapshot(const std::filesystem::path& path, const DeviceProbe& probe, std::string_view preference,
+    uint32_t deviceCount);
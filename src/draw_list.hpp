@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// One entry of the per-frame draw list. Until there is a graphics pipeline a "draw" is a
+// vkCmdClearAttachments of a coloured rectangle, which has the same recording cost profile
+// (one command per item) without needing shaders.
+struct DrawItem
+{
+    VkRect2D rect               { };
+    VkClearColorValue color     { };
+};
+
+// Lays count items out as a grid covering extent.
+inline std::vector<DrawItem> buildDrawGrid(uint32_t count, VkExtent2D extent)
+{
+    std::vector<DrawItem> items;
+    if (!count || !extent.width || !extent.height)
+    {
+        return items;
+    }
+    items.reserve(count);
+
+    const auto _columns { static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count)))) };
+    const auto _rows { (count + _columns - 1) / _columns };
+    const auto _cellWidth { std::max(1u, extent.width / _columns) };
+    const auto _cellHeight { std::max(1u, extent.height / _rows) };
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const auto _column { i % _columns };
+        const auto _row { i / _columns };
+        const VkOffset2D _offset {
+            static_cast<int32_t>(std::min(_column * _cellWidth, extent.width - 1)),
+            static_cast<int32_t>(std::min(_row * _cellHeight, extent.height - 1))
+        };
+        DrawItem item {
+            .rect = {
+                _offset,
+                {
+                    std::max(1u, std::min(_cellWidth - (_cellWidth > 2 ? 1 : 0), extent.width - static_cast<uint32_t>(_offset.x))),
+                    std::max(1u, std::min(_cellHeight - (_cellHeight > 2 ? 1 : 0), extent.height - static_cast<uint32_t>(_offset.y)))
+                }
+            }
+        };
+        item.color.float32[0] = static_cast<float>(_column) / static_cast<float>(_columns);
+        item.color.float32[1] = static_cast<float>(_row) / static_cast<float>(_rows);
+        item.color.float32[2] = 0.5f;
+        item.color.float32[3] = 1.0f;
+        items.push_back(item);
+    }
+    return items;
+}
@@ -0,0 +1,71 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <bit>
+
+FrameArena::FrameArena(size_t capacity)
+    : buffer(std::make_unique_for_overwrite<std::byte[]>(capacity)), bufferSize(capacity)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    releaseOverflows();
+}
+
+void FrameArena::reset()
+{
+    counters.resets++;
+    if (!overflows.empty())
+    {
+        releaseOverflows();
+        // Room for the whole frame, the next one through here is likely no smaller.
+        bufferSize = std::max(bufferSize * 2, std::bit_ceil(usedBytes));
+        buffer = std::make_unique_for_overwrite<std::byte[]>(bufferSize);
+    }
+    offset = 0;
+    usedBytes = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    counters.allocations++;
+    counters.allocatedBytes += bytes;
+
+    const auto _base { reinterpret_cast<uintptr_t>(buffer.get()) };
+    const auto _aligned { (_base + offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1) };
+    const auto _end { _aligned - _base + bytes };
+    if (_end <= bufferSize)
+    {
+        usedBytes += _end - offset;
+        offset = _end;
+        counters.peakBytes = std::max(counters.peakBytes, usedBytes);
+        return reinterpret_cast<void*>(_aligned);
+    }
+
+    counters.overflowAllocations++;
+    auto* _pointer { std::pmr::new_delete_resource()->allocate(bytes, alignment) };
+    overflows.push_back({ _pointer, bytes, alignment });
+    usedBytes += bytes + alignment;
+    counters.peakBytes = std::max(counters.peakBytes, usedBytes);
+    return _pointer;
+}
+
+void FrameArena::do_deallocate(void*, size_t, size_t)
+{
+    // Everything goes at once in reset().
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void FrameArena::releaseOverflows()
+{
+    for (const auto& overflow : overflows)
+    {
+        std::pmr::new_delete_resource()->deallocate(overflow.pointer, overflow.bytes, overflow.alignment);
+    }
+    overflows.clear();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+struct FrameArenaStats
+{
+    uint64_t allocations            { };    // since creation
+    uint64_t allocatedBytes         { };
+    uint64_t overflowAllocations    { };    // served by the heap because the buffer was full
+    uint64_t resets                 { };
+    size_t peakBytes                { };    // most used between two resets, overflow included
+};
+
+// Bump allocator for CPU data that only lives for one frame, one per frame in flight. Allocating
+// bumps an offset into a buffer allocated up front, deallocating does nothing, and reset() takes
+// everything back at once after the frame's fence signalled. Use it through std::pmr containers,
+// e.g. std::pmr::vector<T> scratch(&arena).
+//
+// Requests that don't fit go to the heap and are counted; the next reset() grows the buffer to
+// that frame's peak, so overflows stop after the first frames. Not thread safe, it belongs to the
+// thread recording the frame.
+class FrameArena final : public std::pmr::memory_resource
+{
+public:
+    explicit FrameArena(size_t capacity);
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Invalidates everything allocated since the previous reset.
+    void reset();
+
+    size_t capacity() const { return bufferSize; }
+    const FrameArenaStats& stats() const { return counters; }
+
+private:
+    struct Overflow
+    {
+        void* pointer       { };
+        size_t bytes        { };
+        size_t alignment    { };
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void releaseOverflows();
+
+    std::unique_ptr<std::byte[]> buffer;
+    size_t bufferSize               { };
+    size_t offset                   { };
+    // Buffer bytes plus overflow bytes of the current frame.
+    size_t usedBytes                { };
+    std::vector<Overflow> overflows;
+    FrameArenaStats counters;
+};
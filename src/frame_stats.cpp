@@ -0,0 +1,60 @@
+#include "frame_stats.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+FrameStats::Samples::Samples(size_t capacity)
+    : values(capacity)
+{
+}
+
+void FrameStats::Samples::push(double ms)
+{
+    values[next] = ms;
+    next = (next + 1) % values.size();
+    filled = std::min(filled + 1, values.size());
+}
+
+void FrameStats::Samples::report(std::ostream& out, std::string_view label) const
+{
+    if (!filled)
+    {
+        return;
+    }
+    std::vector<double> _sorted(values.begin(), values.begin() + filled);
+    std::ranges::sort(_sorted);
+    const auto _percentile = [&](double p)
+    {
+        const auto _rank { static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(_sorted.size()))) };
+        return _sorted[std::clamp<size_t>(_rank, 1, _sorted.size()) - 1];
+    };
+    out << '\t' << label << ": p50 " << _percentile(50) << " ms, p95 " << _percentile(95) << " ms, p99 "
+        << _percentile(99) << " ms, max " << _sorted.back() << " ms (" << filled << " samples)\n";
+}
+
+FrameStats::FrameStats(size_t windowSize)
+    : frameTimes(windowSize), acquireToPresent(windowSize)
+{
+}
+
+void FrameStats::beginFrame(Clock::time_point now)
+{
+    if (hasLastFrame)
+    {
+        frameTimes.push(std::chrono::duration<double, std::milli>(now - lastFrame).count());
+    }
+    lastFrame = now;
+    hasLastFrame = true;
+}
+
+void FrameStats::recordAcquireToPresent(Clock::time_point acquired, Clock::time_point presented)
+{
+    acquireToPresent.push(std::chrono::duration<double, std::milli>(presented - acquired).count());
+}
+
+void FrameStats::report(std::ostream& out) const
+{
+    out << "Frame pacing:\n";
+    frameTimes.report(out, "frame time");
+    acquireToPresent.report(out, "acquire to present");
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+// Rolling window of per-frame CPU timings for frame pacing analysis. Storage is allocated up front,
+// once the window is full the oldest samples are overwritten.
+class FrameStats
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FrameStats(size_t windowSize = 16384);
+
+    // Call once per frame at the same point of the loop, the interval between calls is the frame time.
+    void beginFrame(Clock::time_point now = Clock::now());
+    // Time from vkAcquireNextImageKHR returning to vkQueuePresentKHR returning for one image.
+    void recordAcquireToPresent(Clock::time_point acquired, Clock::time_point presented);
+
+    void report(std::ostream& out) const;
+
+private:
+    class Samples
+    {
+    public:
+        explicit Samples(size_t capacity);
+        void push(double ms);
+        size_t count() const { return filled; }
+        // Prints nearest-rank p50/p95/p99 and the maximum.
+        void report(std::ostream& out, std::string_view label) const;
+
+    private:
+        std::vector<double> values;
+        size_t next     { };
+        size_t filled   { };
+    };
+
+    Samples frameTimes;
+    Samples acquireToPresent;
+    Clock::time_point lastFrame { };
+    bool hasLastFrame           { };
+};
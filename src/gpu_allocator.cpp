@@ -0,0 +1,368 @@
+#include "gpu_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <stdexcept>
+
+#include "buddy_allocator.hpp"
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    constexpr VkDeviceSize DEFAULT_BLOCK_SIZE   { 64ull << 20 };
+    constexpr VkDeviceSize MIN_BLOCK_SIZE       { 4ull << 20 };
+    constexpr VkDeviceSize MIN_SUBALLOCATION    { 256 };
+    // Small heaps (integrated GPUs, BAR memory) get blocks of at most 1/8th of the heap.
+    constexpr VkDeviceSize SMALL_HEAP_DIVISOR   { 8 };
+
+    VkMemoryPropertyFlags requiredFlags(MemoryUsage usage)
+    {
+        switch (usage)
+        {
+            case MemoryUsage::GpuOnly: return 0;
+            case MemoryUsage::Upload: return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            case MemoryUsage::Readback: return VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        }
+        return 0;
+    }
+
+    VkMemoryPropertyFlags preferredFlags(MemoryUsage usage)
+    {
+        switch (usage)
+        {
+            case MemoryUsage::GpuOnly: return VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            case MemoryUsage::Upload: return 0;
+            case MemoryUsage::Readback: return VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        }
+        return 0;
+    }
+}
+
+struct GpuMemoryBlock
+{
+    VkDeviceMemory memory       { };
+    void* mapped                { };
+    uint32_t memoryTypeIndex    { };
+    ResourceKind kind           { };
+    BuddyAllocator allocator;
+};
+
+double GpuAllocatorStats::fragmentation() const
+{
+    const auto _free { reservedBytes - usedBytes };
+    if (!_free)
+    {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(largestFreeBlock) / static_cast<double>(_free);
+}
+
+GpuAllocator::GpuAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize transientRingSize)
+    : device(device), transientRing(transientRingSize)
+{
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    VkPhysicalDeviceProperties _properties { };
+    vkGetPhysicalDeviceProperties(physicalDevice, &_properties);
+    bufferImageGranularity = _properties.limits.bufferImageGranularity;
+    maxMemoryAllocationCount = _properties.limits.maxMemoryAllocationCount;
+    transientAlignment = std::max({ _properties.limits.minUniformBufferOffsetAlignment,
+        _properties.limits.minStorageBufferOffsetAlignment, _properties.limits.nonCoherentAtomSize, VkDeviceSize { 16 } });
+
+    if (transientRingSize)
+    {
+        transientBuffer = createBuffer(transientRingSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            MemoryUsage::Upload);
+    }
+}
+
+GpuAllocator::~GpuAllocator()
+{
+    if (transientBuffer.buffer)
+    {
+        destroyBuffer(transientBuffer);
+    }
+    for (auto& pool : pools)
+    {
+        for (auto& block : pool.blocks)
+        {
+            if (!block->allocator.empty())
+            {
+                std::cerr << "GpuAllocator destroyed with " << block->allocator.usedBytes() << " bytes still allocated!\n";
+            }
+            freeDeviceMemory(block->memory, block->allocator.size(), block->mapped != nullptr);
+        }
+    }
+}
+
+uint32_t GpuAllocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const
+{
+    for (const auto _flags : { required | preferred, required })
+    {
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+        {
+            if ((typeBits & (1u << i)) && (memProperties.memoryTypes[i].propertyFlags & _flags) == _flags)
+            {
+                return i;
+            }
+        }
+    }
+    throw std::runtime_error("Failed to find a suitable memory type!");
+}
+
+VkDeviceSize GpuAllocator::blockSizeFor(uint32_t memoryTypeIndex) const
+{
+    const auto _heapSize { memProperties.memoryHeaps[memProperties.memoryTypes[memoryTypeIndex].heapIndex].size };
+    const auto _smallHeapBlock { std::bit_floor(std::max(_heapSize / SMALL_HEAP_DIVISOR, MIN_BLOCK_SIZE)) };
+    return std::min(DEFAULT_BLOCK_SIZE, _smallHeapBlock);
+}
+
+GpuAllocator::Pool& GpuAllocator::pool(uint32_t memoryTypeIndex, ResourceKind kind)
+{
+    // With a granularity of 1 linear and optimal resources can share pages, so share blocks too.
+    const bool _separate { bufferImageGranularity > 1 && kind == ResourceKind::Optimal };
+    return pools[memoryTypeIndex * 2 + (_separate ? 1 : 0)];
+}
+
+VkDeviceMemory GpuAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mapped)
+{
+    if (counters.deviceMemoryAllocations >= maxMemoryAllocationCount)
+    {
+        throw std::runtime_error("maxMemoryAllocationCount exhausted!");
+    }
+    VkMemoryAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memoryTypeIndex
+    };
+    VkDeviceMemory _memory { };
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &_memory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate device memory!");
+    }
+
+    *mapped = nullptr;
+    if (memProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (vkMapMemory(device, _memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+        {
+            vkFreeMemory(device, _memory, nullptr);
+            throw std::runtime_error("Failed to map device memory!");
+        }
+    }
+    counters.deviceMemoryAllocations++;
+    counters.reservedBytes += size;
+    return _memory;
+}
+
+void GpuAllocator::freeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, bool mapped)
+{
+    if (mapped)
+    {
+        vkUnmapMemory(device, memory);
+    }
+    vkFreeMemory(device, memory, nullptr);
+    counters.deviceMemoryAllocations--;
+    counters.reservedBytes -= size;
+}
+
+GpuAllocation GpuAllocator::allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, ResourceKind kind)
+{
+    const auto _typeIndex { findMemoryType(requirements.memoryTypeBits, requiredFlags(usage), preferredFlags(usage)) };
+    const auto _blockSize { blockSizeFor(_typeIndex) };
+
+    std::lock_guard lock(mutex);
+    counters.totalAllocations++;
+
+    GpuAllocation _allocation { };
+    if (requirements.size > _blockSize / 2)
+    {
+        // Would waste at least half a block, give it its own memory.
+        _allocation.memory = allocateDeviceMemory(requirements.size, _typeIndex, &_allocation.mapped);
+        _allocation.size = requirements.size;
+        counters.liveAllocations++;
+        counters.requestedBytes += requirements.size;
+        counters.usedBytes += requirements.size;
+        return _allocation;
+    }
+
+    auto& _pool { pool(_typeIndex, kind) };
+    GpuMemoryBlock* _block { };
+    std::optional<uint64_t> _offset;
+    for (auto& block : _pool.blocks)
+    {
+        _offset = block->allocator.allocate(requirements.size, requirements.alignment);
+        if (_offset)
+        {
+            _block = block.get();
+            break;
+        }
+    }
+    if (!_block)
+    {
+        auto _newBlock { std::make_unique<GpuMemoryBlock>(GpuMemoryBlock {
+            .memoryTypeIndex = _typeIndex,
+            .kind = kind,
+            .allocator = BuddyAllocator(_blockSize, MIN_SUBALLOCATION)
+        }) };
+        _newBlock->memory = allocateDeviceMemory(_blockSize, _typeIndex, &_newBlock->mapped);
+        _offset = _newBlock->allocator.allocate(requirements.size, requirements.alignment);
+        _block = _newBlock.get();
+        _pool.blocks.push_back(std::move(_newBlock));
+    }
+
+    _allocation.memory = _block->memory;
+    _allocation.offset = *_offset;
+    _allocation.size = requirements.size;
+    _allocation.block = _block;
+    if (_block->mapped)
+    {
+        _allocation.mapped = static_cast<char*>(_block->mapped) + *_offset;
+    }
+    counters.liveAllocations++;
+    counters.requestedBytes += requirements.size;
+    counters.usedBytes += _block->allocator.blockSizeFor(requirements.size, requirements.alignment);
+    return _allocation;
+}
+
+void GpuAllocator::free(const GpuAllocation& allocation)
+{
+    if (!allocation.memory)
+    {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    counters.liveAllocations--;
+    counters.requestedBytes -= allocation.size;
+
+    if (!allocation.block)
+    {
+        counters.usedBytes -= allocation.size;
+        freeDeviceMemory(allocation.memory, allocation.size, allocation.mapped != nullptr);
+        return;
+    }
+
+    auto* _block { allocation.block };
+    const auto _usedBefore { _block->allocator.usedBytes() };
+    _block->allocator.free(allocation.offset);
+    counters.usedBytes -= _usedBefore - _block->allocator.usedBytes();
+
+    if (_block->allocator.empty())
+    {
+        // Keep one empty block around per pool so alloc/free churn doesn't hit vkAllocateMemory.
+        auto& _pool { pool(_block->memoryTypeIndex, _block->kind) };
+        const auto _emptyBlocks { std::count_if(_pool.blocks.begin(), _pool.blocks.end(),
+            [](const auto& block) { return block->allocator.empty(); }) };
+        if (_emptyBlocks > 1)
+        {
+            freeDeviceMemory(_block->memory, _block->allocator.size(), _block->mapped != nullptr);
+            std::erase_if(_pool.blocks, [_block](const auto& block) { return block.get() == _block; });
+        }
+    }
+}
+
+GpuBuffer GpuAllocator::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, MemoryUsage memoryUsage)
+{
+    GpuBuffer _buffer { };
+    VkBufferCreateInfo bufferInfo {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size = size,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE
+    };
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &_buffer.buffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create buffer!");
+    }
+    VkMemoryRequirements _requirements { };
+    vkGetBufferMemoryRequirements(device, _buffer.buffer, &_requirements);
+    _buffer.allocation = allocate(_requirements, memoryUsage, ResourceKind::Linear);
+    vkBindBufferMemory(device, _buffer.buffer, _buffer.allocation.memory, _buffer.allocation.offset);
+    return _buffer;
+}
+
+void GpuAllocator::destroyBuffer(GpuBuffer& buffer)
+{
+    vkDestroyBuffer(device, buffer.buffer, nullptr);
+    free(buffer.allocation);
+    buffer = { };
+}
+
+GpuImage GpuAllocator::createImage(const VkImageCreateInfo& createInfo, MemoryUsage memoryUsage)
+{
+    GpuImage _image { };
+    if (vkCreateImage(device, &createInfo, nullptr, &_image.image) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create image!");
+    }
+    VkMemoryRequirements _requirements { };
+    vkGetImageMemoryRequirements(device, _image.image, &_requirements);
+    const auto _kind { createInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? ResourceKind::Optimal : ResourceKind::Linear };
+    _image.allocation = allocate(_requirements, memoryUsage, _kind);
+    vkBindImageMemory(device, _image.image, _image.allocation.memory, _image.allocation.offset);
+    return _image;
+}
+
+void GpuAllocator::destroyImage(GpuImage& image)
+{
+    vkDestroyImage(device, image.image, nullptr);
+    free(image.allocation);
+    image = { };
+}
+
+TransientBuffer GpuAllocator::allocateTransient(VkDeviceSize size, VkDeviceSize alignment)
+{
+    std::lock_guard lock(mutex);
+    const auto _offset { transientRing.allocate(size, std::max(alignment, transientAlignment)) };
+    if (!_offset)
+    {
+        throw std::runtime_error("Transient ring buffer exhausted!");
+    }
+    return TransientBuffer {
+        .buffer = transientBuffer.buffer,
+        .offset = *_offset,
+        .size = size,
+        .mapped = static_cast<char*>(transientBuffer.allocation.mapped) + *_offset
+    };
+}
+
+void GpuAllocator::endFrame(uint64_t frame)
+{
+    std::lock_guard lock(mutex);
+    transientRing.endFrame(frame);
+}
+
+void GpuAllocator::releaseFrames(uint64_t completedFrame)
+{
+    std::lock_guard lock(mutex);
+    transientRing.release(completedFrame);
+}
+
+GpuAllocatorStats GpuAllocator::stats() const
+{
+    std::lock_guard lock(mutex);
+    auto _stats { counters };
+    for (const auto& pool : pools)
+    {
+        for (const auto& block : pool.blocks)
+        {
+            _stats.largestFreeBlock = std::max(_stats.largestFreeBlock, block->allocator.largestFreeBlock());
+        }
+    }
+    _stats.transientCapacity = transientRing.size();
+    _stats.transientPeakBytes = transientRing.peakBytes();
+    return _stats;
+}
+
+void GpuAllocator::reportStats(std::ostream& out) const
+{
+    const auto _stats { stats() };
+    constexpr double MIB { 1024.0 * 1024.0 };
+    out << "GPU memory: " << _stats.liveAllocations << " live allocations (" << _stats.totalAllocations << " total) in "
+        << _stats.deviceMemoryAllocations << " device memory allocations\n"
+        << "\treserved " << _stats.reservedBytes / MIB << " MiB, requested " << _stats.requestedBytes / MIB
+        << " MiB, wasted " << _stats.wastedBytes() / MIB << " MiB, fragmentation " << _stats.fragmentation() * 100.0 << "%\n"
+        << "\ttransient ring peak " << _stats.transientPeakBytes / MIB << " of " << _stats.transientCapacity / MIB << " MiB\n";
+}
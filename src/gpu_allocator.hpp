@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "ring_allocator.hpp"
+
+struct GpuMemoryBlock;
+
+// How the memory is going to be accessed, decides the memory type.
+enum class MemoryUsage
+{
+    GpuOnly,    // DEVICE_LOCAL
+    Upload,     // HOST_VISIBLE | HOST_COHERENT, persistently mapped, written by the CPU
+    Readback,   // HOST_VISIBLE | HOST_CACHED preferred, persistently mapped, read by the CPU
+};
+
+// Linear resources (buffers, linear images) and optimal-tiling images are carved out of separate
+// blocks, so bufferImageGranularity can never put the two kinds on the same page.
+enum class ResourceKind
+{
+    Linear,
+    Optimal,
+};
+
+struct GpuAllocation
+{
+    VkDeviceMemory memory           { };
+    VkDeviceSize offset             { };
+    VkDeviceSize size               { };
+    // Host pointer to offset when the memory is host visible.
+    void* mapped                    { };
+    // Null for dedicated allocations that own their VkDeviceMemory.
+    GpuMemoryBlock* block           { };
+};
+
+struct GpuBuffer
+{
+    VkBuffer buffer                 { };
+    GpuAllocation allocation;
+};
+
+struct GpuImage
+{
+    VkImage image                   { };
+    GpuAllocation allocation;
+};
+
+// Sub-range of the per-frame ring buffer, valid until the frame it was allocated in retires.
+struct TransientBuffer
+{
+    VkBuffer buffer                 { };
+    VkDeviceSize offset             { };
+    VkDeviceSize size               { };
+    void* mapped                    { };
+};
+
+struct GpuAllocatorStats
+{
+    uint64_t deviceMemoryAllocations    { };    // live vkAllocateMemory calls
+    uint64_t liveAllocations            { };
+    uint64_t totalAllocations           { };    // allocate() calls since creation
+    VkDeviceSize reservedBytes          { };    // sum of all VkDeviceMemory sizes
+    VkDeviceSize requestedBytes         { };    // what live resources asked for
+    VkDeviceSize usedBytes              { };    // what live resources occupy after rounding
+    VkDeviceSize largestFreeBlock       { };
+    VkDeviceSize transientCapacity      { };
+    VkDeviceSize transientPeakBytes     { };
+
+    // Internal fragmentation: bytes lost to power-of-two rounding and alignment.
+    VkDeviceSize wastedBytes() const { return usedBytes - requestedBytes; }
+    // External fragmentation of the free space, 0 when it is one contiguous range.
+    double fragmentation() const;
+};
+
+// Sub-allocating device memory allocator. Long-lived resources are placed in large per memory
+// type blocks managed by a buddy allocator, resources bigger than a block get a dedicated
+// allocation, and small per-frame data comes from a persistently mapped ring buffer.
+// allocate/free and the create/destroy helpers are thread safe.
+class GpuAllocator
+{
+public:
+    GpuAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize transientRingSize);
+    ~GpuAllocator();
+
+    GpuAllocator(const GpuAllocator&) = delete;
+    GpuAllocator& operator=(const GpuAllocator&) = delete;
+
+    GpuAllocation allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, ResourceKind kind);
+    void free(const GpuAllocation& allocation);
+
+    GpuBuffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, MemoryUsage memoryUsage);
+    void destroyBuffer(GpuBuffer& buffer);
+    GpuImage createImage(const VkImageCreateInfo& createInfo, MemoryUsage memoryUsage);
+    void destroyImage(GpuImage& image);
+
+    // Per-frame data, throws when the ring is exhausted.
+    TransientBuffer allocateTransient(VkDeviceSize size, VkDeviceSize alignment);
+    // The buffer every TransientBuffer is a range of, null without a ring. Never changes, so it can
+    // be bound once and addressed by offset.
+    VkBuffer transientRingBuffer() const { return transientBuffer.buffer; }
+    // Closes the transient allocations of frame and reclaims those of frames <= completedFrame.
+    void endFrame(uint64_t frame);
+    void releaseFrames(uint64_t completedFrame);
+
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const;
+    const VkPhysicalDeviceMemoryProperties& memoryProperties() const { return memProperties; }
+
+    GpuAllocatorStats stats() const;
+    void reportStats(std::ostream& out) const;
+
+private:
+    struct Pool
+    {
+        std::vector<std::unique_ptr<GpuMemoryBlock>> blocks;
+    };
+
+    VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mapped);
+    void freeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, bool mapped);
+    Pool& pool(uint32_t memoryTypeIndex, ResourceKind kind);
+    VkDeviceSize blockSizeFor(uint32_t memoryTypeIndex) const;
+
+    VkDevice device                                 { };
+    VkPhysicalDeviceMemoryProperties memProperties  { };
+    VkDeviceSize bufferImageGranularity             { };
+    uint32_t maxMemoryAllocationCount               { };
+
+    mutable std::mutex mutex;
+    std::array<Pool, VK_MAX_MEMORY_TYPES * 2> pools;
+    GpuAllocatorStats counters;
+
+    GpuBuffer transientBuffer;
+    VkDeviceSize transientAlignment                 { };
+    RingAllocator transientRing;
+};
@@ -0,0 +1,81 @@
+#include "heap_counter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+// Only the single-object forms are replaced, the array and nothrow forms are specified to call
+// them. A relaxed increment is all this adds to an allocation.
+namespace
+{
+    std::atomic<uint64_t> allocationCount { };
+
+    void* allocate(std::size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+
+    void* allocateAligned(std::size_t size, std::size_t alignment)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+        return _aligned_malloc(size ? size : 1, alignment);
+#else
+        // aligned_alloc wants a multiple of the alignment.
+        return std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) & ~(alignment - 1));
+#endif
+    }
+}
+
+uint64_t heapAllocationCount()
+{
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+    if (auto* _pointer = allocate(size))
+    {
+        return _pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* _pointer = allocateAligned(size, static_cast<std::size_t>(alignment)))
+    {
+        return _pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
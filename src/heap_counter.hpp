@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of global operator new calls since startup, from any thread. heap_counter.cpp replaces
+// the global operator new and delete to count them, so this covers every C++ allocation in the
+// program but not malloc() from C libraries and most drivers.
+uint64_t heapAllocationCount();
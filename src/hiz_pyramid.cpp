@@ -0,0 +1,260 @@
+#include "hiz_pyramid.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "embedded_shaders.hpp"
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    constexpr std::array<const EmbeddedShader*, 1> HIZ_SHADERS { &SHADER_HIZ_COMP };
+    constexpr auto HIZ_PUSH_CONSTANTS { shaderPushConstants(HIZ_SHADERS) };
+
+    // Mirrors pc in shaders/hiz.comp.
+    struct HiZPushConstants
+    {
+        int32_t sourceSize[2]       { };
+        int32_t destinationSize[2]  { };
+    };
+    static_assert(HIZ_PUSH_CONSTANTS.size == sizeof(HiZPushConstants));
+
+    VkExtent2D halfExtent(VkExtent2D extent)
+    {
+        return { std::max((extent.width + 1) / 2, 1u), std::max((extent.height + 1) / 2, 1u) };
+    }
+}
+
+HiZPyramid::HiZPyramid(VkDevice device, GpuAllocator& allocator, BindlessSet& bindless, DeferredDeleter& deleter,
+    VkPipelineCache pipelineCache)
+    : device(device)
+    , allocator(allocator)
+    , bindless(bindless)
+    , deleter(deleter)
+{
+    // Only ever read with texelFetch, the sampler is there because the bindless array holds
+    // combined image samplers.
+    VkSamplerCreateInfo samplerInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .maxLod = VK_LOD_CLAMP_NONE
+    };
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Hi-Z sampler!");
+    }
+
+    setLayout = createShaderSetLayout(device, HIZ_SHADERS, 0);
+    pipelineLayout = createShaderPipelineLayout(device, HIZ_SHADERS, std::span(&setLayout, 1));
+
+    const auto _shader { createShaderModule(device, SHADER_HIZ_COMP) };
+    VkComputePipelineCreateInfo pipelineInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = _shader,
+            .pName = "main"
+        },
+        .layout = pipelineLayout
+    };
+    const auto _result { vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) };
+    vkDestroyShaderModule(device, _shader, nullptr);
+    if (_result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Hi-Z pipeline!");
+    }
+}
+
+HiZPyramid::~HiZPyramid()
+{
+    if (current)
+    {
+        destroyChain(*current);
+    }
+    vkDestroyPipeline(device, pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    vkDestroySampler(device, sampler, nullptr);
+}
+
+void HiZPyramid::resize(VkImageView depthView, VkExtent2D depthExtent, uint64_t retireFrame)
+{
+    if (current)
+    {
+        deleter.enqueue(retireFrame, [this, chain = std::move(current)] { destroyChain(*chain); });
+    }
+    auto _chain { std::make_unique<Chain>() };
+    _chain->depthExtent = depthExtent;
+
+    // Full chain down to 1x1, so the coarsest level always covers the whole screen.
+    for (auto _extent { halfExtent(depthExtent) };; _extent = halfExtent(_extent))
+    {
+        _chain->levels.push_back({ .extent = _extent });
+        if (_extent.width == 1 && _extent.height == 1)
+        {
+            break;
+        }
+    }
+    const auto _levelCount { static_cast<uint32_t>(_chain->levels.size()) };
+
+    VkImageCreateInfo imageInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .extent = { _chain->levels[0].extent.width, _chain->levels[0].extent.height, 1 },
+        .mipLevels = _levelCount,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    _chain->image = allocator.createImage(imageInfo, MemoryUsage::GpuOnly);
+
+    VkImageViewCreateInfo viewInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = _chain->image.image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, _levelCount, 0, 1 }
+    };
+    if (vkCreateImageView(device, &viewInfo, nullptr, &_chain->view) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Hi-Z image view!");
+    }
+    for (uint32_t i = 0; i < _levelCount; i++)
+    {
+        viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+        if (vkCreateImageView(device, &viewInfo, nullptr, &_chain->levels[i].view) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create Hi-Z level view!");
+        }
+    }
+
+    const std::array<VkDescriptorPoolSize, 2> _poolSizes { {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, _levelCount },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, _levelCount }
+    } };
+    VkDescriptorPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = _levelCount,
+        .poolSizeCount = static_cast<uint32_t>(_poolSizes.size()),
+        .pPoolSizes = _poolSizes.data()
+    };
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &_chain->descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create Hi-Z descriptor pool!");
+    }
+    const std::vector<VkDescriptorSetLayout> _setLayouts(_levelCount, setLayout);
+    std::vector<VkDescriptorSet> _sets(_levelCount);
+    VkDescriptorSetAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = _chain->descriptorPool,
+        .descriptorSetCount = _levelCount,
+        .pSetLayouts = _setLayouts.data()
+    };
+    if (vkAllocateDescriptorSets(device, &allocInfo, _sets.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate Hi-Z descriptor sets!");
+    }
+
+    // Level i reads level i - 1, level 0 reads the depth buffer.
+    for (uint32_t i = 0; i < _levelCount; i++)
+    {
+        auto& _level { _chain->levels[i] };
+        _level.descriptorSet = _sets[i];
+        const VkDescriptorImageInfo _source { i == 0
+            ? VkDescriptorImageInfo { sampler, depthView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL }
+            : VkDescriptorImageInfo { sampler, _chain->levels[i - 1].view, VK_IMAGE_LAYOUT_GENERAL } };
+        const VkDescriptorImageInfo _destination { VK_NULL_HANDLE, _level.view, VK_IMAGE_LAYOUT_GENERAL };
+        const std::array<VkWriteDescriptorSet, 2> _writes { {
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = _level.descriptorSet,
+                .dstBinding = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &_source
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = _level.descriptorSet,
+                .dstBinding = 1,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo = &_destination
+            }
+        } };
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(_writes.size()), _writes.data(), 0, nullptr);
+    }
+
+    _chain->textureSlot = bindless.addTexture(_chain->view, sampler, VK_IMAGE_LAYOUT_GENERAL);
+    current = std::move(_chain);
+}
+
+void HiZPyramid::record(VkCommandBuffer commandBuffer)
+{
+    auto& _chain { *current };
+    const auto _levelCount { static_cast<uint32_t>(_chain.levels.size()) };
+
+    // Only the levels depend on each other, the caller orders the whole chain against the cull
+    // passes reading it.
+    VkImageMemoryBarrier barrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = _chain.image.image
+    };
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    auto _sourceExtent { _chain.depthExtent };
+    for (uint32_t i = 0; i < _levelCount; i++)
+    {
+        const auto& _level { _chain.levels[i] };
+        const HiZPushConstants _pushConstants {
+            .sourceSize = { static_cast<int32_t>(_sourceExtent.width), static_cast<int32_t>(_sourceExtent.height) },
+            .destinationSize = { static_cast<int32_t>(_level.extent.width), static_cast<int32_t>(_level.extent.height) }
+        };
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &_level.descriptorSet,
+            0, nullptr);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, HIZ_PUSH_CONSTANTS.stageFlags, 0, sizeof(_pushConstants),
+            &_pushConstants);
+        const auto& _groupSize { SHADER_HIZ_COMP.localSize };
+        vkCmdDispatch(commandBuffer, (_level.extent.width + _groupSize[0] - 1) / _groupSize[0],
+            (_level.extent.height + _groupSize[1] - 1) / _groupSize[1], 1);
+
+        // Makes the level readable by the next dispatch.
+        if (i + 1 < _levelCount)
+        {
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                0, nullptr, 0, nullptr, 1, &barrier);
+        }
+        _sourceExtent = _level.extent;
+    }
+    _chain.built = true;
+}
+
+void HiZPyramid::destroyChain(Chain& chain)
+{
+    bindless.removeTexture(chain.textureSlot);
+    for (auto& level : chain.levels)
+    {
+        vkDestroyImageView(device, level.view, nullptr);
+    }
+    vkDestroyImageView(device, chain.view, nullptr);
+    vkDestroyDescriptorPool(device, chain.descriptorPool, nullptr);
+    allocator.destroyImage(chain.image);
+}
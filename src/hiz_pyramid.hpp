@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "bindless_set.hpp"
+#include "deferred_deleter.hpp"
+#include "gpu_allocator.hpp"
+
+// Hierarchical depth buffer for occlusion culling: a R32_SFLOAT mip chain where every texel holds
+// the farthest depth of the area it covers, level 0 being half the depth buffer's resolution.
+// Built with one compute dispatch per level at the end of a frame and sampled through the
+// bindless set by the next frame's cull pass.
+class HiZPyramid
+{
+public:
+    HiZPyramid(VkDevice device, GpuAllocator& allocator, BindlessSet& bindless, DeferredDeleter& deleter,
+        VkPipelineCache pipelineCache);
+    ~HiZPyramid();
+
+    HiZPyramid(const HiZPyramid&) = delete;
+    HiZPyramid& operator=(const HiZPyramid&) = delete;
+
+    // (Re)creates the mip chain for a depth buffer, which must be in SHADER_READ_ONLY_OPTIMAL
+    // whenever record() runs. Resources of the previous size go to the deleter, to be destroyed
+    // once retireFrame has completed.
+    void resize(VkImageView depthView, VkExtent2D depthExtent, uint64_t retireFrame);
+
+    // Rebuilds every level from the depth buffer. The whole chain must be in GENERAL, with
+    // earlier reads of it finished, e.g. through a render graph ComputeWrite.
+    void record(VkCommandBuffer commandBuffer);
+
+    // False until record() ran for the current size, the pyramid holds garbage before.
+    bool valid() const { return current && current->built; }
+    uint32_t textureSlot() const { return current->textureSlot; }
+    uint32_t levelCount() const { return static_cast<uint32_t>(current->levels.size()); }
+    VkExtent2D depthExtent() const { return current->depthExtent; }
+    VkImage image() const { return current->image.image; }
+
+private:
+    struct Level
+    {
+        VkImageView view                { };
+        VkDescriptorSet descriptorSet   { };
+        VkExtent2D extent               { };
+    };
+
+    // Everything that depends on the depth buffer size.
+    struct Chain
+    {
+        GpuImage image;
+        VkImageView view                { };
+        VkDescriptorPool descriptorPool { };
+        std::vector<Level> levels;
+        VkExtent2D depthExtent          { };
+        uint32_t textureSlot            { };
+        bool built                      { };
+    };
+
+    void destroyChain(Chain& chain);
+
+    VkDevice device                         { };
+    GpuAllocator& allocator;
+    BindlessSet& bindless;
+    DeferredDeleter& deleter;
+
+    VkSampler sampler                       { };
+    VkDescriptorSetLayout setLayout         { };
+    VkPipelineLayout pipelineLayout         { };
+    VkPipeline pipeline                     { };
+
+    std::unique_ptr<Chain> current;
+};
@@ -0,0 +1,486 @@
+#include "indirect_renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "embedded_shaders.hpp"
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    // The cull and draw pipelines share one layout: the bindless set and ScenePushConstants.
+    constexpr std::array<const EmbeddedShader*, 3> SCENE_SHADERS { &SHADER_CULL_COMP, &SHADER_SCENE_VERT, &SHADER_SCENE_FRAG };
+    constexpr auto SCENE_PUSH_CONSTANTS { shaderPushConstants(SCENE_SHADERS) };
+    static_assert(SCENE_PUSH_CONSTANTS.size == sizeof(ScenePushConstants));
+    static_assert(std::ranges::all_of(SCENE_SHADERS,
+        [](const EmbeddedShader* shader) { return shaderBindingsMatch(*shader, BindlessSet::SHADER_BINDINGS); }));
+
+    constexpr float ORBIT_SPEED             { 0.2f };   // radians per second
+    constexpr float FIELD_OF_VIEW           { 60.0f };
+    constexpr float NEAR_PLANE              { 0.1f };
+
+    // std430 layout of FrameUniforms in shaders/common.glsl.
+    struct FrameUniforms
+    {
+        glm::mat4 viewProjection;
+        glm::mat4 previousViewProjection;
+        // left, right, bottom, top, near, far; xyz inward normal, w distance.
+        glm::vec4 frustumPlanes[6];
+        glm::vec4 cameraPosition;
+        // Hi-Z texture slot, level count (0 disables occlusion culling), depth width and height.
+        glm::uvec4 pyramid;
+    };
+    static_assert(sizeof(FrameUniforms) == 256);
+
+    glm::vec4 matrixRow(const glm::mat4& matrix, int row)
+    {
+        return { matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row] };
+    }
+
+    glm::vec4 normalizePlane(const glm::vec4& plane)
+    {
+        return plane / glm::length(glm::vec3(plane.x, plane.y, plane.z));
+    }
+
+    template<typename T>
+    std::span<const std::byte> asBytes(const std::vector<T>& data)
+    {
+        return std::as_bytes(std::span(data));
+    }
+}
+
+IndirectRenderer::IndirectRenderer(VkDevice device, GpuAllocator& allocator, StagingUploader& uploader, BindlessSet& bindless,
+    VkPipelineCache pipelineCache, const RenderTargetFormats& target, uint32_t framesInFlight, const SceneData& scene,
+    GpuSceneAssets assets)
+    : device(device)
+    , allocator(allocator)
+    , uploader(uploader)
+    , bindless(bindless)
+    , nodes(static_cast<uint32_t>(scene.instances.size()))
+    , instances(static_cast<uint32_t>(std::ranges::count_if(scene.instances,
+        [](const GpuInstance& instance) { return instance.mesh != NO_MESH; })))
+    , halfExtent(scene.halfExtent)
+    , uploadSerial(assets.uploadSerial)
+    , assets(std::move(assets))
+{
+    if (!allocator.transientRingBuffer())
+    {
+        destroySceneAssets(device, allocator, this->assets);
+        throw std::runtime_error("Failed to create indirect renderer, the allocator has no transient ring!");
+    }
+    createTextureSlots();
+    for (const auto& instance : scene.instances)
+    {
+        if (instance.mesh != NO_MESH)
+        {
+            const auto _meshlets { scene.meshes.at(instance.mesh).meshletCount };
+            meshlets += _meshlets;
+            drawCapacity += (_meshlets + 1) / 2;
+        }
+    }
+
+    // Instances reference scene textures, the shaders index the bindless array directly.
+    auto _instances { scene.instances };
+    for (auto& instance : _instances)
+    {
+        if (instance.mesh != NO_MESH)
+        {
+            instance.texture = textureSlots.at(instance.texture);
+        }
+    }
+    instanceBuffer = createSceneBuffer(allocator, _instances.size() * sizeof(GpuInstance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    if (!_instances.empty())
+    {
+        uploadSerial = std::max(uploadSerial, uploader.uploadBuffer(instanceBuffer.buffer, 0, asBytes(_instances)));
+    }
+    uploader.flush();
+
+    const ScenePushConstants _scene {
+        .vertices = bindless.addBuffer(this->assets.vertices.buffer),
+        .instances = bindless.addBuffer(instanceBuffer.buffer),
+        .meshes = bindless.addBuffer(this->assets.meshes.buffer),
+        .instanceCount = nodes,
+        .meshlets = bindless.addBuffer(this->assets.meshlets.buffer),
+        .frameRing = bindless.addBuffer(allocator.transientRingBuffer())
+    };
+    frames.resize(framesInFlight);
+    for (auto& frame : frames)
+    {
+        frame.draws = allocator.createBuffer(VkDeviceSize { std::max(drawCapacity, 1u) } * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, MemoryUsage::GpuOnly);
+        frame.count = allocator.createBuffer(sizeof(CullCounters), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+            | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            MemoryUsage::GpuOnly);
+        frame.transforms = allocator.createBuffer(VkDeviceSize { std::max(nodes, 1u) } * sizeof(GpuTransform),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, MemoryUsage::Upload);
+        frame.pushConstants = _scene;
+        frame.pushConstants.draws = bindless.addBuffer(frame.draws.buffer);
+        frame.pushConstants.count = bindless.addBuffer(frame.count.buffer);
+        frame.pushConstants.transforms = bindless.addBuffer(frame.transforms.buffer);
+    }
+
+    createPipelines(pipelineCache, target);
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+    vkDestroyPipeline(device, drawPipeline, nullptr);
+    vkDestroyPipeline(device, cullPipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+
+    for (auto& frame : frames)
+    {
+        bindless.removeBuffer(frame.pushConstants.draws);
+        bindless.removeBuffer(frame.pushConstants.count);
+        bindless.removeBuffer(frame.pushConstants.transforms);
+        allocator.destroyBuffer(frame.draws);
+        allocator.destroyBuffer(frame.count);
+        allocator.destroyBuffer(frame.transforms);
+    }
+    if (!frames.empty())
+    {
+        bindless.removeBuffer(frames.front().pushConstants.vertices);
+        bindless.removeBuffer(frames.front().pushConstants.instances);
+        bindless.removeBuffer(frames.front().pushConstants.meshes);
+        bindless.removeBuffer(frames.front().pushConstants.meshlets);
+        bindless.removeBuffer(frames.front().pushConstants.frameRing);
+    }
+    for (const auto slot : textureSlots)
+    {
+        bindless.removeTexture(slot);
+    }
+    vkDestroySampler(device, sampler, nullptr);
+    destroySceneAssets(device, allocator, assets);
+    allocator.destroyBuffer(instanceBuffer);
+}
+
+bool IndirectRenderer::ready() const
+{
+    return uploader.acquiredSerial() >= uploadSerial;
+}
+
+void IndirectRenderer::createTextureSlots()
+{
+    VkSamplerCreateInfo samplerInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .maxLod = VK_LOD_CLAMP_NONE
+    };
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create texture sampler!");
+    }
+    for (const auto& texture : assets.textures)
+    {
+        textureSlots.push_back(bindless.addTexture(texture.view, sampler));
+    }
+}
+
+void IndirectRenderer::createPipelines(VkPipelineCache pipelineCache, const RenderTargetFormats& target)
+{
+    const auto _setLayout { bindless.layout() };
+    pipelineLayout = createShaderPipelineLayout(device, SCENE_SHADERS, std::span(&_setLayout, 1));
+
+    const auto _cullShader { createShaderModule(device, SHADER_CULL_COMP) };
+    VkComputePipelineCreateInfo computeInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = _cullShader,
+            .pName = "main"
+        },
+        .layout = pipelineLayout
+    };
+    const auto _computeResult { vkCreateComputePipelines(device, pipelineCache, 1, &computeInfo, nullptr, &cullPipeline) };
+    vkDestroyShaderModule(device, _cullShader, nullptr);
+    if (_computeResult != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create cull pipeline!");
+    }
+
+    const auto _vertexShader { createShaderModule(device, SHADER_SCENE_VERT) };
+    const auto _fragmentShader { createShaderModule(device, SHADER_SCENE_FRAG) };
+    const std::array<VkPipelineShaderStageCreateInfo, 2> _stages { {
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = _vertexShader,
+            .pName = "main"
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = _fragmentShader,
+            .pName = "main"
+        }
+    } };
+    // Vertices are pulled from the bindless vertex buffer, so there is no vertex input state.
+    VkPipelineVertexInputStateCreateInfo vertexInput { .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST
+    };
+    VkPipelineViewportStateCreateInfo viewportState {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1,
+        .scissorCount = 1
+    };
+    // The projection flips Y, which keeps counter-clockwise triangles front facing.
+    VkPipelineRasterizationStateCreateInfo rasterization {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .polygonMode = VK_POLYGON_MODE_FILL,
+        .cullMode = VK_CULL_MODE_BACK_BIT,
+        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .lineWidth = 1.0f
+    };
+    VkPipelineMultisampleStateCreateInfo multisample {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
+    };
+    VkPipelineDepthStencilStateCreateInfo depthStencil {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = VK_TRUE,
+        .depthWriteEnable = VK_TRUE,
+        .depthCompareOp = VK_COMPARE_OP_LESS
+    };
+    VkPipelineColorBlendAttachmentState colorBlendAttachment {
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+    };
+    VkPipelineColorBlendStateCreateInfo colorBlend {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .attachmentCount = 1,
+        .pAttachments = &colorBlendAttachment
+    };
+    // Viewport and scissor follow the swapchain, so resizes never rebuild the pipeline.
+    const std::array<VkDynamicState, 2> _dynamicStates { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<uint32_t>(_dynamicStates.size()),
+        .pDynamicStates = _dynamicStates.data()
+    };
+    // Ignored when there is a render pass.
+    const VkPipelineRenderingCreateInfo renderingInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &target.colorFormat,
+        .depthAttachmentFormat = target.depthFormat
+    };
+    VkGraphicsPipelineCreateInfo pipelineInfo {
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = target.renderPass ? nullptr : &renderingInfo,
+        .stageCount = static_cast<uint32_t>(_stages.size()),
+        .pStages = _stages.data(),
+        .pVertexInputState = &vertexInput,
+        .pInputAssemblyState = &inputAssembly,
+        .pViewportState = &viewportState,
+        .pRasterizationState = &rasterization,
+        .pMultisampleState = &multisample,
+        .pDepthStencilState = &depthStencil,
+        .pColorBlendState = &colorBlend,
+        .pDynamicState = &dynamicState,
+        .layout = pipelineLayout,
+        .renderPass = target.renderPass,
+        .subpass = 0
+    };
+    const auto _graphicsResult { vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &drawPipeline) };
+    vkDestroyShaderModule(device, _fragmentShader, nullptr);
+    vkDestroyShaderModule(device, _vertexShader, nullptr);
+    if (_graphicsResult != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create scene pipeline!");
+    }
+}
+
+void IndirectRenderer::updateFrame(uint32_t frameIndex, VkExtent2D extent, float time, const SceneGraph& graph,
+    const HiZPyramid* occluders)
+{
+    updateTransforms(frameIndex, graph);
+
+    // Close enough that part of the scene is always behind or beside the camera, so the cull
+    // pass has something to do.
+    const float _distance { halfExtent * 1.5f };
+    const float _angle { time * ORBIT_SPEED };
+    const glm::vec3 _eye { std::cos(_angle) * _distance, halfExtent * 0.5f, std::sin(_angle) * _distance };
+    const auto _view { glm::lookAt(_eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)) };
+    const float _aspect { static_cast<float>(extent.width) / static_cast<float>(std::max(extent.height, 1u)) };
+    auto _projection { glm::perspectiveRH_ZO(glm::radians(FIELD_OF_VIEW), _aspect, NEAR_PLANE, _distance + halfExtent * 2.0f) };
+    // Vulkan clip space has Y pointing down.
+    _projection[1][1] *= -1.0f;
+
+    FrameUniforms _uniforms {
+        .viewProjection = _projection * _view,
+        .previousViewProjection = previousViewProjection,
+        .cameraPosition = glm::vec4(_eye, 1.0f)
+    };
+    auto& _frame { frames[frameIndex] };
+    _frame.occlusionTested = occluders && occluders->valid();
+    if (_frame.occlusionTested)
+    {
+        const auto _depthExtent { occluders->depthExtent() };
+        _uniforms.pyramid = { occluders->textureSlot(), occluders->levelCount(), _depthExtent.width, _depthExtent.height };
+    }
+    previousViewProjection = _uniforms.viewProjection;
+    // Gribb-Hartmann plane extraction, for a [0, 1] depth range the near plane is row 2 alone.
+    const auto& _m { _uniforms.viewProjection };
+    const auto _r0 { matrixRow(_m, 0) };
+    const auto _r1 { matrixRow(_m, 1) };
+    const auto _r2 { matrixRow(_m, 2) };
+    const auto _r3 { matrixRow(_m, 3) };
+    const std::array<glm::vec4, 6> _planes { _r3 + _r0, _r3 - _r0, _r3 + _r1, _r3 - _r1, _r2, _r3 - _r2 };
+    for (size_t i = 0; i < _planes.size(); i++)
+    {
+        _uniforms.frustumPlanes[i] = normalizePlane(_planes[i]);
+    }
+    // Aligned to its own size, so the offset is an index into the ring viewed as FrameUniforms[].
+    const auto _allocation { allocator.allocateTransient(sizeof(FrameUniforms), sizeof(FrameUniforms)) };
+    std::memcpy(_allocation.mapped, &_uniforms, sizeof(_uniforms));
+    _frame.pushConstants.frame = static_cast<uint32_t>(_allocation.offset / sizeof(FrameUniforms));
+}
+
+void IndirectRenderer::updateTransforms(uint32_t frameIndex, const SceneGraph& graph)
+{
+    // Every frame in flight has its own copy, so a change is queued for all of them and each copy
+    // catches up when its frame comes around. Copies that fall far behind are rewritten whole.
+    const auto _changed { graph.changedNodes() };
+    for (auto& frame : frames)
+    {
+        if (frame.rewriteTransforms)
+        {
+            continue;
+        }
+        if (frame.pendingTransforms.size() + _changed.size() > nodes / 2)
+        {
+            frame.rewriteTransforms = true;
+            frame.pendingTransforms.clear();
+            continue;
+        }
+        frame.pendingTransforms.insert(frame.pendingTransforms.end(), _changed.begin(), _changed.end());
+    }
+
+    auto& _frame { frames[frameIndex] };
+    const std::span _transforms { static_cast<GpuTransform*>(_frame.transforms.allocation.mapped), nodes };
+    if (_frame.rewriteTransforms)
+    {
+        graph.writeTransforms(_transforms);
+    }
+    else
+    {
+        graph.writeTransforms(_transforms, _frame.pendingTransforms);
+    }
+    _frame.pendingTransforms.clear();
+    _frame.rewriteTransforms = false;
+}
+
+void IndirectRenderer::recordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    auto& _frame { frames[frameIndex] };
+    vkCmdFillBuffer(commandBuffer, _frame.count.buffer, 0, sizeof(CullCounters), 0);
+    VkBufferMemoryBarrier clearBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = _frame.count.buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        0, nullptr, 1, &clearBarrier, 0, nullptr);
+
+    const auto _set { bindless.set() };
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &_set, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, SCENE_PUSH_CONSTANTS.stageFlags, 0, sizeof(ScenePushConstants), &_frame.pushConstants);
+    const auto _groupSize { SHADER_CULL_COMP.localSize[0] };
+    vkCmdDispatch(commandBuffer, (nodes + _groupSize - 1) / _groupSize, 1, 1);
+
+    // Only for the readback, the draw's indirect reads are the caller's to synchronise.
+    VkMemoryBarrier cullBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+        1, &cullBarrier, 0, nullptr, 0, nullptr);
+
+    _frame.readback = allocator.allocateTransient(sizeof(CullCounters), alignof(CullCounters));
+    const VkBufferCopy _copy { 0, _frame.readback.offset, sizeof(CullCounters) };
+    vkCmdCopyBuffer(commandBuffer, _frame.count.buffer, _frame.readback.buffer, 1, &_copy);
+    VkMemoryBarrier readbackBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+        1, &readbackBarrier, 0, nullptr, 0, nullptr);
+    _frame.statsPending = true;
+}
+
+void IndirectRenderer::collectStats(uint32_t frameIndex)
+{
+    auto& _frame { frames[frameIndex] };
+    if (!_frame.statsPending)
+    {
+        return;
+    }
+    CullCounters _counters { };
+    std::memcpy(&_counters, _frame.readback.mapped, sizeof(_counters));
+    stats.frames++;
+    stats.draws += _counters.drawCount;
+    stats.frustumCulled += _counters.frustumCulled;
+    stats.occlusionCulled += _counters.occlusionCulled;
+    stats.clusterCulled += _counters.clusterCulled;
+    stats.occlusionFrames += _frame.occlusionTested ? 1 : 0;
+    _frame.statsPending = false;
+}
+
+void IndirectRenderer::reportStats(std::ostream& out) const
+{
+    if (!stats.frames)
+    {
+        return;
+    }
+    const auto _perFrame = [&](uint64_t total) { return static_cast<double>(total) / static_cast<double>(stats.frames); };
+    const auto _percent = [&](uint64_t total) { return 100.0 * _perFrame(total) / std::max(instances, 1u); };
+    // Every instance with a mesh is either culled or drawn, in one draw per run of visible meshlets.
+    const auto _visible { stats.frames * instances - stats.frustumCulled - stats.occlusionCulled };
+    out << std::fixed << std::setprecision(1)
+        << "Culling " << instances << " instances, average over " << stats.frames << " frames ("
+        << stats.occlusionFrames << " with Hi-Z occlusion):\n"
+        << "\tvisible          " << _perFrame(_visible) << " (" << _percent(_visible) << "%)\n"
+        << "\tfrustum culled   " << _perFrame(stats.frustumCulled) << " (" << _percent(stats.frustumCulled) << "%)\n"
+        << "\tocclusion culled " << _perFrame(stats.occlusionCulled) << " (" << _percent(stats.occlusionCulled) << "%)\n"
+        << "\tmeshlets culled  " << _perFrame(stats.clusterCulled) << " of " << meshlets << " by their own frustum and cone tests\n"
+        << "\tdraws            " << _perFrame(stats.draws) << "\n"
+        << std::defaultfloat;
+}
+
+void IndirectRenderer::recordDraw(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkExtent2D extent)
+{
+    const auto& _frame { frames[frameIndex] };
+    const VkViewport _viewport { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+    const VkRect2D _scissor { { 0, 0 }, extent };
+    const auto _set { bindless.set() };
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline);
+    vkCmdSetViewport(commandBuffer, 0, 1, &_viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &_scissor);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &_set, 0, nullptr);
+    vkCmdBindIndexBuffer(commandBuffer, assets.indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, SCENE_PUSH_CONSTANTS.stageFlags, 0, sizeof(ScenePushConstants), &_frame.pushConstants);
+    vkCmdDrawIndexedIndirectCount(commandBuffer, _frame.draws.buffer, 0, _frame.count.buffer, 0, drawCapacity,
+        sizeof(VkDrawIndexedIndirectCommand));
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+#include "bindless_set.hpp"
+#include "gpu_allocator.hpp"
+#include "hiz_pyramid.hpp"
+#include "scene.hpp"
+#include "scene_assets.hpp"
+#include "staging_uploader.hpp"
+
+// Bindless indices of the buffers a pass reads, mirrors pc in shaders/common.glsl.
+struct ScenePushConstants
+{
+    uint32_t frame          { };
+    uint32_t vertices       { };
+    uint32_t instances      { };
+    uint32_t meshes         { };
+    uint32_t draws          { };
+    uint32_t count          { };
+    uint32_t instanceCount  { };
+    uint32_t transforms     { };
+    uint32_t meshlets       { };
+    // The allocator's transient ring, frame indexes the FrameUniforms array it is viewed as.
+    uint32_t frameRing      { };
+};
+static_assert(sizeof(ScenePushConstants) == 40);
+
+// Written by the cull pass, mirrors CountBuffer in shaders/common.glsl. drawCount doubles as the
+// count of vkCmdDrawIndexedIndirectCount.
+struct CullCounters
+{
+    uint32_t drawCount          { };
+    uint32_t frustumCulled      { };
+    uint32_t occlusionCulled    { };
+    uint32_t clusterCulled      { };
+};
+
+// What the scene pipeline draws into: subpass 0 of renderPass or, when renderPass is null, one
+// color and one depth attachment of these formats with dynamic rendering.
+struct RenderTargetFormats
+{
+    VkRenderPass renderPass     { };
+    VkFormat colorFormat        { };
+    VkFormat depthFormat        { };
+};
+
+// GPU-driven renderer for a SceneData: all geometry lives in a handful of buffers reached through
+// the bindless set, a compute pass frustum-culls every instance, then the meshlets of the survivors
+// against the frustum and their normal cones, and appends one VkDrawIndexedIndirectCommand per run
+// of surviving meshlets. The whole scene is then drawn with a single vkCmdDrawIndexedIndirectCount.
+// CPU cost per frame is independent of the instance count.
+// Instances hidden behind the previous frame's depth are rejected too when a HiZPyramid is passed
+// to updateFrame(). World transforms live in one persistently mapped buffer per frame in flight,
+// updateFrame() only rewrites the nodes the SceneGraph reports as changed. The camera uniforms and
+// the culling counters' readback are small per-frame data and come from the allocator's transient
+// ring instead.
+// Geometry and textures arrive already uploaded (or still uploading) as GpuSceneAssets, from
+// uploadSceneAssets() or an asset archive loader, and are owned by the renderer from then on.
+class IndirectRenderer
+{
+public:
+    IndirectRenderer(VkDevice device, GpuAllocator& allocator, StagingUploader& uploader, BindlessSet& bindless,
+        VkPipelineCache pipelineCache, const RenderTargetFormats& target, uint32_t framesInFlight, const SceneData& scene,
+        GpuSceneAssets assets);
+    ~IndirectRenderer();
+
+    IndirectRenderer(const IndirectRenderer&) = delete;
+    IndirectRenderer& operator=(const IndirectRenderer&) = delete;
+
+    // False until the scene uploads have been acquired on the graphics queue, nothing is drawn before.
+    bool ready() const;
+
+    // Writes the camera of frameIndex, an orbit around the scene at time seconds, and the
+    // transforms. graph is the scene's graph after exactly one update() since the previous call.
+    // occluders must have been built by the previous frame, nullptr or an invalid pyramid skips
+    // occlusion culling.
+    void updateFrame(uint32_t frameIndex, VkExtent2D extent, float time, const SceneGraph& graph,
+        const HiZPyramid* occluders);
+
+    // Outside the render pass: resets the counters, runs the culling dispatch and queues the
+    // counters for readback. The draws and counts have to be made visible to the indirect stage
+    // before recordDraw(), and the occluders' last build must be visible to compute.
+    void recordCull(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    // Accumulates the counters of frameIndex's last cull, call once its fence has signalled and
+    // before the allocator releases that frame's transient memory.
+    void collectStats(uint32_t frameIndex);
+    // Inside the render pass: draws whatever recordCull() let through.
+    void recordDraw(VkCommandBuffer commandBuffer, uint32_t frameIndex, VkExtent2D extent);
+
+    uint32_t instanceCount() const { return instances; }
+    void reportStats(std::ostream& out) const;
+
+private:
+    struct FrameResources
+    {
+        GpuBuffer draws;
+        // Device local, atomics and vkCmdDrawIndexedIndirectCount want it there. Copied to
+        // readback, a transient allocation of the frame recordCull() ran in.
+        GpuBuffer count;
+        TransientBuffer readback;
+        GpuBuffer transforms;
+        // Nodes changed since this frame's transforms were last written.
+        std::vector<SceneGraph::NodeId> pendingTransforms;
+        bool rewriteTransforms      { true };
+        ScenePushConstants pushConstants;
+        bool statsPending           { };
+        bool occlusionTested        { };
+    };
+
+    struct CullStats
+    {
+        uint64_t frames             { };
+        uint64_t draws              { };
+        uint64_t frustumCulled      { };
+        uint64_t occlusionCulled    { };
+        uint64_t clusterCulled      { };
+        uint64_t occlusionFrames    { };
+    };
+
+    void createTextureSlots();
+    void createPipelines(VkPipelineCache pipelineCache, const RenderTargetFormats& target);
+    void updateTransforms(uint32_t frameIndex, const SceneGraph& graph);
+
+    VkDevice device                     { };
+    GpuAllocator& allocator;
+    StagingUploader& uploader;
+    BindlessSet& bindless;
+
+    // Graph nodes, one cull invocation each, and the ones among them with a mesh.
+    uint32_t nodes                      { };
+    uint32_t instances                  { };
+    // Meshlets of all instances, and the most draws the cull pass can emit: every other one culled.
+    uint32_t meshlets                   { };
+    uint32_t drawCapacity               { };
+    float halfExtent                    { };
+    uint64_t uploadSerial               { };
+    // Camera of the last updateFrame(), the one the next Hi-Z pyramid is built from.
+    glm::mat4 previousViewProjection    { 1.0f };
+    CullStats stats;
+
+    GpuSceneAssets assets;
+    GpuBuffer instanceBuffer;
+    // Bindless slot of every assets.textures entry.
+    std::vector<uint32_t> textureSlots;
+    VkSampler sampler                   { };
+    std::vector<FrameResources> frames;
+
+    VkPipelineLayout pipelineLayout     { };
+    VkPipeline cullPipeline             { };
+    VkPipeline drawPipeline             { };
+};
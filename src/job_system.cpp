@@ -0,0 +1,106 @@
+#include "job_system.hpp"
+
+#include <algorithm>
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::parallelFor(uint32_t jobCount, const Job& job)
+{
+    if (!jobCount)
+    {
+        return;
+    }
+    if (workers.empty())
+    {
+        for (uint32_t i = 0; i < jobCount; i++)
+        {
+            job(0, i);
+        }
+        return;
+    }
+
+    std::unique_lock lock(mutex);
+    currentJob = &job;
+    currentJobCount = jobCount;
+    nextJob.store(0, std::memory_order_relaxed);
+    activeWorkers = workerCount();
+    firstError = nullptr;
+    generation++;
+    wake.notify_all();
+
+    // Every worker checks in once per batch, so the next batch can never overlap this one.
+    done.wait(lock, [&] { return activeWorkers == 0; });
+    currentJob = nullptr;
+    if (firstError)
+    {
+        std::rethrow_exception(firstError);
+    }
+}
+
+uint32_t JobSystem::defaultWorkerCount()
+{
+    const auto _cores { std::thread::hardware_concurrency() };
+    return std::max(1u, _cores > 1 ? _cores - 1 : 1u);
+}
+
+void JobSystem::workerLoop(uint32_t workerIndex)
+{
+    uint64_t _seenGeneration { };
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [&] { return stopping || generation != _seenGeneration; });
+        if (stopping)
+        {
+            return;
+        }
+        _seenGeneration = generation;
+        const Job* _job { currentJob };
+        const uint32_t _jobCount { currentJobCount };
+        lock.unlock();
+
+        std::exception_ptr _error;
+        for (uint32_t i = nextJob.fetch_add(1, std::memory_order_relaxed); i < _jobCount;
+            i = nextJob.fetch_add(1, std::memory_order_relaxed))
+        {
+            try
+            {
+                (*_job)(workerIndex, i);
+            }
+            catch (...)
+            {
+                _error = std::current_exception();
+            }
+        }
+
+        lock.lock();
+        if (_error && !firstError)
+        {
+            firstError = _error;
+        }
+        if (--activeWorkers == 0)
+        {
+            done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads that run batches of indexed jobs. Each job is told which worker
+// runs it, so callers can keep per-thread resources (command pools, scratch memory) without locking.
+class JobSystem
+{
+public:
+    using Job = std::function<void(uint32_t workerIndex, uint32_t jobIndex)>;
+
+    explicit JobSystem(uint32_t workerCount);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t workerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+    // Runs job(worker, i) for every i in [0, jobCount) and blocks until all of them finished.
+    // The first exception thrown by a job is rethrown here.
+    void parallelFor(uint32_t jobCount, const Job& job);
+
+    // Worker count used when the caller has no preference: leave one core for the main thread.
+    static uint32_t defaultWorkerCount();
+
+private:
+    void workerLoop(uint32_t workerIndex);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const Job* currentJob           { };
+    uint32_t currentJobCount        { };
+    std::atomic<uint32_t> nextJob   { };
+    uint32_t activeWorkers          { };
+    uint64_t generation             { };
+    bool stopping                   { };
+    std::exception_ptr firstError;
+};
@@ -0,0 +1,486 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+
+namespace
+{
+    // Tom Forsyth's scoring constants, the cache size only shapes the curve and need not match
+    // the hardware.
+    constexpr uint32_t SCORING_CACHE_SIZE   { 32 };
+    constexpr float CACHE_DECAY_POWER       { 1.5f };
+    constexpr float LAST_TRIANGLE_SCORE     { 0.75f };
+    constexpr float VALENCE_BOOST_SCALE     { 2.0f };
+    constexpr float VALENCE_BOOST_POWER     { 0.5f };
+    constexpr uint32_t NO_TRIANGLE          { ~0u };
+    constexpr uint32_t NO_VERTEX            { ~0u };
+    // Normal cones wider than this (cos of the half angle) can't cull anything worth the test.
+    constexpr float MIN_CONE_DOT            { 0.1f };
+
+    float vertexScore(int cachePosition, uint32_t liveTriangles)
+    {
+        if (!liveTriangles)
+        {
+            return -1.0f;
+        }
+        float _score { };
+        if (cachePosition >= 0)
+        {
+            // The triangle just emitted gets a fixed score, or the next one would always reuse
+            // its vertices in the same order.
+            _score = cachePosition < 3 ? LAST_TRIANGLE_SCORE : std::pow(1.0f
+                - static_cast<float>(cachePosition - 3) / static_cast<float>(SCORING_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+        }
+        // Vertices with few triangles left go first, so no lone triangles are left behind.
+        return _score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(liveTriangles), -VALENCE_BOOST_POWER);
+    }
+
+    uint16_t floatToHalf(float value)
+    {
+        const auto _bits { std::bit_cast<uint32_t>(value) };
+        const auto _sign { static_cast<uint16_t>((_bits >> 16) & 0x8000) };
+        const int _exponent { static_cast<int>((_bits >> 23) & 0xff) - 127 + 15 };
+        uint32_t _mantissa { _bits & 0x7fffff };
+        if (((_bits >> 23) & 0xff) == 0xff)
+        {
+            return static_cast<uint16_t>(_sign | 0x7c00 | (_mantissa ? 0x200 : 0));
+        }
+        if (_exponent >= 31)
+        {
+            // Largest finite half rather than infinity, a position is still a position.
+            return static_cast<uint16_t>(_sign | 0x7bff);
+        }
+        // Round to nearest even, a carry out of the mantissa correctly bumps the exponent.
+        const auto _round = [](uint32_t half, uint32_t remainder, uint32_t halfway) {
+            return remainder > halfway || (remainder == halfway && (half & 1)) ? half + 1 : half;
+        };
+        if (_exponent <= 0)
+        {
+            if (_exponent < -10)
+            {
+                return _sign;
+            }
+            _mantissa |= 0x800000;
+            const auto _shift { static_cast<uint32_t>(14 - _exponent) };
+            return _sign | static_cast<uint16_t>(_round(_mantissa >> _shift, _mantissa & ((1u << _shift) - 1), 1u << (_shift - 1)));
+        }
+        return _sign | static_cast<uint16_t>(_round((static_cast<uint32_t>(_exponent) << 10) | (_mantissa >> 13),
+            _mantissa & 0x1fff, 0x1000));
+    }
+
+    float halfToFloat(uint16_t half)
+    {
+        const uint32_t _sign { (half & 0x8000u) << 16 };
+        const uint32_t _exponent { (half >> 10) & 0x1fu };
+        const uint32_t _mantissa { half & 0x3ffu };
+        if (_exponent == 0)
+        {
+            const float _value { std::ldexp(static_cast<float>(_mantissa), -24) };
+            return _sign ? -_value : _value;
+        }
+        if (_exponent == 31)
+        {
+            return std::bit_cast<float>(_sign | 0x7f800000 | (_mantissa << 13));
+        }
+        return std::bit_cast<float>(_sign | ((_exponent + 127 - 15) << 23) | (_mantissa << 13));
+    }
+
+    int16_t floatToSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    uint16_t floatToUnorm16(float value)
+    {
+        return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    // Folds the unit sphere onto the [-1, 1] square: the upper hemisphere is the inner diamond,
+    // the lower one the corners. Same as decodeOctahedral() in shaders/common.glsl.
+    glm::vec2 encodeOctahedral(glm::vec3 normal)
+    {
+        const float _length { std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z) };
+        if (_length <= 0.0f)
+        {
+            return { 0.0f, 0.0f };
+        }
+        normal /= _length;
+        if (normal.z >= 0.0f)
+        {
+            return { normal.x, normal.y };
+        }
+        return {
+            (1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f),
+            (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f)
+        };
+    }
+
+    glm::vec3 decodeOctahedral(glm::vec2 encoded)
+    {
+        glm::vec3 _normal { encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+        const float _fold { std::max(-_normal.z, 0.0f) };
+        _normal.x += _normal.x >= 0.0f ? -_fold : _fold;
+        _normal.y += _normal.y >= 0.0f ? -_fold : _fold;
+        return glm::normalize(_normal);
+    }
+
+    GpuMeshlet finishMeshlet(std::span<const uint32_t> indices, uint32_t firstIndex, uint32_t indexCount,
+        std::span<const MeshVertex> vertices)
+    {
+        GpuMeshlet _meshlet { .firstIndex = firstIndex, .indexCount = indexCount };
+        const auto _triangles { indices.subspan(firstIndex, indexCount) };
+
+        glm::vec3 _minimum { std::numeric_limits<float>::max() };
+        glm::vec3 _maximum { std::numeric_limits<float>::lowest() };
+        for (const auto index : _triangles)
+        {
+            _minimum = glm::min(_minimum, vertices[index].position);
+            _maximum = glm::max(_maximum, vertices[index].position);
+        }
+        const glm::vec3 _center { (_minimum + _maximum) * 0.5f };
+        float _radius { };
+        for (const auto index : _triangles)
+        {
+            _radius = std::max(_radius, glm::length(vertices[index].position - _center));
+        }
+
+        // Cone around the average face normal, degenerate triangles face nowhere and are skipped.
+        std::vector<glm::vec3> _normals;
+        glm::vec3 _sum { 0.0f };
+        for (size_t i = 0; i + 2 < _triangles.size(); i += 3)
+        {
+            const auto& _a { vertices[_triangles[i]].position };
+            const auto _normal { glm::cross(vertices[_triangles[i + 1]].position - _a, vertices[_triangles[i + 2]].position - _a) };
+            const float _length { glm::length(_normal) };
+            if (_length > 0.0f)
+            {
+                _normals.push_back(_normal / _length);
+                _sum += _normals.back();
+            }
+        }
+        float _minimumDot { -1.0f };
+        glm::vec3 _axis { 0.0f };
+        if (glm::length(_sum) > 0.0f)
+        {
+            _axis = glm::normalize(_sum);
+            _minimumDot = 1.0f;
+            for (const auto& normal : _normals)
+            {
+                _minimumDot = std::min(_minimumDot, glm::dot(normal, _axis));
+            }
+        }
+
+        _meshlet.bounds[0] = _center.x;
+        _meshlet.bounds[1] = _center.y;
+        _meshlet.bounds[2] = _center.z;
+        _meshlet.bounds[3] = _radius;
+        if (_minimumDot > MIN_CONE_DOT)
+        {
+            _meshlet.cone[0] = _axis.x;
+            _meshlet.cone[1] = _axis.y;
+            _meshlet.cone[2] = _axis.z;
+            // Every face is back facing once the view direction is within 90 degrees minus the
+            // cone's half angle of the axis, i.e. the cosine of that is the sine of the half angle.
+            _meshlet.cone[3] = std::sqrt(1.0f - _minimumDot * _minimumDot);
+        }
+        else
+        {
+            _meshlet.cone[3] = 1.0f;
+        }
+        return _meshlet;
+    }
+}
+
+GeometryStats& GeometryStats::operator+=(const GeometryStats& other)
+{
+    vertices += other.vertices;
+    triangles += other.triangles;
+    cacheMisses += other.cacheMisses;
+    vertexBytes += other.vertexBytes;
+    meshlets += other.meshlets;
+    return *this;
+}
+
+OptimizedMesh optimizeMesh(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices)
+{
+    if (indices.size() % 3)
+    {
+        throw std::runtime_error("Failed to optimize mesh, the index count is not a multiple of 3!");
+    }
+    if (std::ranges::any_of(indices, [&](uint32_t index) { return index >= vertices.size(); }))
+    {
+        throw std::runtime_error("Failed to optimize mesh, an index is out of range!");
+    }
+
+    OptimizedMesh _mesh { };
+    _mesh.before = {
+        .vertices = vertices.size(),
+        .triangles = indices.size() / 3,
+        .cacheMisses = simulateVertexCache(indices, vertices.size()),
+        .vertexBytes = vertices.size() * sizeof(MeshVertex)
+    };
+
+    _mesh.indices = optimizeVertexCache(indices, vertices.size());
+    const auto _order { optimizeVertexFetch(_mesh.indices, vertices.size()) };
+    // Bounds, meshlets and cones all come from what the GPU will actually see.
+    std::vector<MeshVertex> _decoded;
+    _decoded.reserve(_order.size());
+    _mesh.vertices.reserve(_order.size());
+    glm::vec3 _minimum { std::numeric_limits<float>::max() };
+    glm::vec3 _maximum { std::numeric_limits<float>::lowest() };
+    for (const auto source : _order)
+    {
+        _mesh.vertices.push_back(quantizeVertex(vertices[source]));
+        _decoded.push_back(dequantizeVertex(_mesh.vertices.back()));
+        const auto& _position { _decoded.back().position };
+        _minimum = glm::min(_minimum, _position);
+        _maximum = glm::max(_maximum, _position);
+        _mesh.radius = std::max(_mesh.radius, glm::length(_position));
+    }
+    if (!_decoded.empty())
+    {
+        _mesh.bounds = { (_minimum + _maximum) * 0.5f, (_maximum - _minimum) * 0.5f };
+    }
+    _mesh.meshlets = buildMeshlets(_mesh.indices, _decoded);
+
+    _mesh.after = {
+        .vertices = _mesh.vertices.size(),
+        .triangles = _mesh.indices.size() / 3,
+        .cacheMisses = simulateVertexCache(_mesh.indices, _mesh.vertices.size()),
+        .vertexBytes = _mesh.vertices.size() * sizeof(GpuVertex),
+        .meshlets = _mesh.meshlets.size()
+    };
+    return _mesh;
+}
+
+std::vector<uint32_t> optimizeVertexCache(std::span<const uint32_t> indices, size_t vertexCount)
+{
+    const size_t _triangleCount { indices.size() / 3 };
+    // Triangles of every vertex, the first liveTriangles[v] of its range are the ones not emitted yet.
+    std::vector<uint32_t> _firstTriangle(vertexCount + 1);
+    for (size_t i = 0; i < _triangleCount * 3; i++)
+    {
+        _firstTriangle[indices[i] + 1]++;
+    }
+    std::partial_sum(_firstTriangle.begin(), _firstTriangle.end(), _firstTriangle.begin());
+    std::vector<uint32_t> _liveTriangles(vertexCount);
+    std::vector<uint32_t> _adjacency(_triangleCount * 3);
+    for (size_t i = 0; i < _triangleCount * 3; i++)
+    {
+        const auto _vertex { indices[i] };
+        _adjacency[_firstTriangle[_vertex] + _liveTriangles[_vertex]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<float> _vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        _vertexScores[v] = vertexScore(-1, _liveTriangles[v]);
+    }
+    std::vector<float> _triangleScores(_triangleCount);
+    std::vector<bool> _emitted(_triangleCount);
+    uint32_t _best { NO_TRIANGLE };
+    float _bestScore { -std::numeric_limits<float>::max() };
+    for (size_t t = 0; t < _triangleCount; t++)
+    {
+        _triangleScores[t] = _vertexScores[indices[t * 3]] + _vertexScores[indices[t * 3 + 1]] + _vertexScores[indices[t * 3 + 2]];
+        if (_triangleScores[t] > _bestScore)
+        {
+            _best = static_cast<uint32_t>(t);
+            _bestScore = _triangleScores[t];
+        }
+    }
+
+    std::vector<uint32_t> _result;
+    _result.reserve(_triangleCount * 3);
+    std::vector<uint32_t> _cache;
+    std::vector<uint32_t> _nextCache;
+    _cache.reserve(SCORING_CACHE_SIZE + 3);
+    _nextCache.reserve(SCORING_CACHE_SIZE + 3);
+    size_t _scan { };
+    for (size_t emitted = 0; emitted < _triangleCount; emitted++)
+    {
+        if (_best == NO_TRIANGLE)
+        {
+            // Nothing in the cache has triangles left, carry on with the next one in input order.
+            while (_emitted[_scan])
+            {
+                _scan++;
+            }
+            _best = static_cast<uint32_t>(_scan);
+        }
+        const auto _triangle { indices.subspan(size_t { _best } * 3, 3) };
+        _result.insert(_result.end(), _triangle.begin(), _triangle.end());
+        _emitted[_best] = true;
+
+        // The triangle's vertices move to the front of the cache, the rest shift back.
+        _nextCache.clear();
+        for (const auto vertex : _triangle)
+        {
+            auto* _live { &_adjacency[_firstTriangle[vertex]] };
+            std::iter_swap(std::find(_live, _live + _liveTriangles[vertex], _best), _live + _liveTriangles[vertex] - 1);
+            _liveTriangles[vertex]--;
+            if (std::ranges::find(_nextCache, vertex) == _nextCache.end())
+            {
+                _nextCache.push_back(vertex);
+            }
+        }
+        for (const auto vertex : _cache)
+        {
+            if (std::ranges::find(_nextCache, vertex) == _nextCache.end())
+            {
+                _nextCache.push_back(vertex);
+            }
+        }
+        std::swap(_cache, _nextCache);
+
+        // Rescore everything whose cache position changed, including the vertices that just fell
+        // out, and pick the next triangle among the live ones of the cached vertices.
+        for (size_t i = 0; i < _cache.size(); i++)
+        {
+            const auto _vertex { _cache[i] };
+            const float _score { vertexScore(i < SCORING_CACHE_SIZE ? static_cast<int>(i) : -1, _liveTriangles[_vertex]) };
+            const float _delta { _score - _vertexScores[_vertex] };
+            _vertexScores[_vertex] = _score;
+            for (uint32_t j = 0; j < _liveTriangles[_vertex]; j++)
+            {
+                _triangleScores[_adjacency[_firstTriangle[_vertex] + j]] += _delta;
+            }
+        }
+        _cache.resize(std::min<size_t>(_cache.size(), SCORING_CACHE_SIZE));
+        _best = NO_TRIANGLE;
+        _bestScore = -std::numeric_limits<float>::max();
+        for (const auto vertex : _cache)
+        {
+            for (uint32_t j = 0; j < _liveTriangles[vertex]; j++)
+            {
+                const auto _candidate { _adjacency[_firstTriangle[vertex] + j] };
+                if (_triangleScores[_candidate] > _bestScore)
+                {
+                    _best = _candidate;
+                    _bestScore = _triangleScores[_candidate];
+                }
+            }
+        }
+    }
+    return _result;
+}
+
+std::vector<uint32_t> optimizeVertexFetch(std::span<uint32_t> indices, size_t vertexCount)
+{
+    std::vector<uint32_t> _remap(vertexCount, NO_VERTEX);
+    std::vector<uint32_t> _order;
+    for (auto& index : indices)
+    {
+        if (_remap[index] == NO_VERTEX)
+        {
+            _remap[index] = static_cast<uint32_t>(_order.size());
+            _order.push_back(index);
+        }
+        index = _remap[index];
+    }
+    return _order;
+}
+
+std::vector<GpuMeshlet> buildMeshlets(std::span<const uint32_t> indices, std::span<const MeshVertex> vertices)
+{
+    std::vector<GpuMeshlet> _meshlets;
+    // Meshlet that last used every vertex, to count each one once per meshlet.
+    std::vector<uint32_t> _lastMeshlet(vertices.size(), NO_VERTEX);
+    uint32_t _firstIndex { };
+    uint32_t _vertexCount { };
+    const auto _newVertices = [&](size_t first) {
+        uint32_t _count { };
+        for (size_t k = first; k < first + 3; k++)
+        {
+            const auto _vertex { indices[k] };
+            const bool _repeated { (k > first && indices[k - 1] == _vertex) || (k == first + 2 && indices[first] == _vertex) };
+            _count += _lastMeshlet[_vertex] != _meshlets.size() && !_repeated ? 1 : 0;
+        }
+        return _count;
+    };
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const auto _triangles { (static_cast<uint32_t>(i) - _firstIndex) / 3 };
+        if (_vertexCount + _newVertices(i) > MESHLET_MAX_VERTICES || _triangles == MESHLET_MAX_TRIANGLES)
+        {
+            _meshlets.push_back(finishMeshlet(indices, _firstIndex, static_cast<uint32_t>(i) - _firstIndex, vertices));
+            _firstIndex = static_cast<uint32_t>(i);
+            _vertexCount = 0;
+        }
+        _vertexCount += _newVertices(i);
+        for (size_t k = i; k < i + 3; k++)
+        {
+            _lastMeshlet[indices[k]] = static_cast<uint32_t>(_meshlets.size());
+        }
+    }
+    if (_firstIndex + 2 < indices.size())
+    {
+        _meshlets.push_back(finishMeshlet(indices, _firstIndex, static_cast<uint32_t>(indices.size()) - _firstIndex, vertices));
+    }
+    return _meshlets;
+}
+
+uint64_t simulateVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+    // Miss count when each vertex last entered the cache, it is still there until cacheSize more
+    // misses pushed it out. 0 for never.
+    std::vector<uint64_t> _insertedAt(vertexCount);
+    uint64_t _misses { };
+    for (const auto index : indices)
+    {
+        if (!_insertedAt[index] || _misses - _insertedAt[index] >= cacheSize)
+        {
+            _insertedAt[index] = ++_misses;
+        }
+    }
+    return _misses;
+}
+
+GpuVertex quantizeVertex(const MeshVertex& vertex)
+{
+    const auto _normal { encodeOctahedral(vertex.normal) };
+    return {
+        .position = { floatToHalf(vertex.position.x), floatToHalf(vertex.position.y), floatToHalf(vertex.position.z), 0 },
+        .normal = { floatToSnorm16(_normal.x), floatToSnorm16(_normal.y) },
+        .uv = { floatToUnorm16(vertex.uv.x), floatToUnorm16(vertex.uv.y) }
+    };
+}
+
+MeshVertex dequantizeVertex(const GpuVertex& vertex)
+{
+    const glm::vec2 _normal {
+        std::max(static_cast<float>(vertex.normal[0]) / 32767.0f, -1.0f),
+        std::max(static_cast<float>(vertex.normal[1]) / 32767.0f, -1.0f)
+    };
+    return {
+        .position = { halfToFloat(vertex.position[0]), halfToFloat(vertex.position[1]), halfToFloat(vertex.position[2]) },
+        .normal = decodeOctahedral(_normal),
+        .uv = { static_cast<float>(vertex.uv[0]) / 65535.0f, static_cast<float>(vertex.uv[1]) / 65535.0f }
+    };
+}
+
+void reportGeometry(std::ostream& out, const GeometryStats& before, const GeometryStats& after)
+{
+    const auto _acmr = [](const GeometryStats& stats) {
+        return stats.triangles ? static_cast<double>(stats.cacheMisses) / static_cast<double>(stats.triangles) : 0.0;
+    };
+    const auto _bytesPerVertex = [](const GeometryStats& stats) {
+        return stats.vertices ? static_cast<double>(stats.vertexBytes) / static_cast<double>(stats.vertices) : 0.0;
+    };
+    out << std::fixed << std::setprecision(2)
+        << "Mesh optimization, " << after.triangles << " triangles:\n"
+        << "\tvertices         " << before.vertices << " -> " << after.vertices << "\n"
+        << "\tACMR (FIFO " << MEASURED_CACHE_SIZE << ")     " << _acmr(before) << " -> " << _acmr(after) << "\n"
+        << "\tbytes per vertex " << _bytesPerVertex(before) << " -> " << _bytesPerVertex(after) << "\n"
+        << "\tvertex data      " << before.vertexBytes / 1024.0 << " KiB -> " << after.vertexBytes / 1024.0 << " KiB\n"
+        << "\tmeshlets         " << after.meshlets << " (at most " << MESHLET_MAX_VERTICES << " vertices, "
+        << MESHLET_MAX_TRIANGLES << " triangles)\n"
+        << std::defaultfloat;
+}
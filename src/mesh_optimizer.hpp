@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "scene.hpp"
+#include "scene_graph.hpp"
+
+// Full precision vertex as generators and importers produce it, optimizeMesh() turns it into a
+// GpuVertex.
+struct MeshVertex
+{
+    glm::vec3 position      { };
+    glm::vec3 normal        { };
+    glm::vec2 uv            { };
+};
+
+// Meshlet limits of the common mesh shader layouts, so the clusters carry over if the cull and
+// draw ever move to task and mesh shaders.
+constexpr uint32_t MESHLET_MAX_VERTICES     { 64 };
+constexpr uint32_t MESHLET_MAX_TRIANGLES    { 124 };
+// FIFO post-transform cache the ACMR is measured with, about what current GPUs reuse within a batch.
+constexpr uint32_t MEASURED_CACHE_SIZE      { 16 };
+
+// One mesh ready for SceneData. Indices are relative to the first vertex and meshlet index ranges
+// relative to the first index, the caller offsets them when appending.
+struct OptimizedMesh
+{
+    std::vector<GpuVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<GpuMeshlet> meshlets;
+    // Of the quantized positions, so culling stays conservative.
+    SceneGraph::Aabb bounds;
+    float radius            { };
+    GeometryStats before;
+    GeometryStats after;
+};
+
+// Reorders the triangles for the post-transform cache, splits them into meshlets in that order,
+// reorders the vertices by first use for fetch locality, drops unused ones and quantizes the rest.
+// Triangles keep their winding. Throws std::runtime_error for an index out of range.
+OptimizedMesh optimizeMesh(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices);
+
+// The steps of optimizeMesh(), usable on their own.
+// Triangle order for a vertex cache of unknown size, Tom Forsyth's linear-speed greedy scoring.
+std::vector<uint32_t> optimizeVertexCache(std::span<const uint32_t> indices, size_t vertexCount);
+// Renumbers vertices in order of first use, returns the old index of every new vertex.
+std::vector<uint32_t> optimizeVertexFetch(std::span<uint32_t> indices, size_t vertexCount);
+// Greedy split of a triangle list in its given order, firstIndex is relative to indices.
+std::vector<GpuMeshlet> buildMeshlets(std::span<const uint32_t> indices, std::span<const MeshVertex> vertices);
+// Vertex shader runs of a FIFO cache of cacheSize entries.
+uint64_t simulateVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = MEASURED_CACHE_SIZE);
+
+GpuVertex quantizeVertex(const MeshVertex& vertex);
+MeshVertex dequantizeVertex(const GpuVertex& vertex);
+
+// Before and after table: vertices, ACMR, bytes per vertex, vertex buffer size and meshlets.
+void reportGeometry(std::ostream& out, const GeometryStats& before, const GeometryStats& after);
@@ -0,0 +1,145 @@
+#include "parallel_recorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    // More chunks than workers so a slow chunk doesn't leave the other threads idle.
+    constexpr uint32_t CHUNKS_PER_WORKER { 4 };
+    constexpr uint32_t MIN_DRAWS_PER_CHUNK { 64 };
+}
+
+ParallelRecorder::ParallelRecorder(VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t workerCount)
+    : device(device), jobs(workerCount)
+{
+    const auto _workers { std::max(1u, workerCount) };
+    workerFrames.resize(static_cast<size_t>(framesInFlight) * _workers);
+    workerStats.resize(_workers);
+
+    for (auto& workerFrame : workerFrames)
+    {
+        VkCommandPoolCreateInfo poolInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = queueFamily
+        };
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &workerFrame.pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create worker command pool!");
+        }
+    }
+}
+
+ParallelRecorder::~ParallelRecorder()
+{
+    for (auto& workerFrame : workerFrames)
+    {
+        vkDestroyCommandPool(device, workerFrame.pool, nullptr);
+    }
+}
+
+void ParallelRecorder::beginFrame(uint32_t frameIndex)
+{
+    for (uint32_t worker = 0; worker < workerStats.size(); worker++)
+    {
+        auto& _workerFrame { workerFrame(frameIndex, worker) };
+        vkResetCommandPool(device, _workerFrame.pool, 0);
+        _workerFrame.usedCommandBuffers = 0;
+    }
+}
+
+std::span<const VkCommandBuffer> ParallelRecorder::record(uint32_t frameIndex, const VkCommandBufferInheritanceInfo& inheritance,
+    uint32_t drawCount, const RecordChunkFn& recordChunk)
+{
+    const auto _workers { static_cast<uint32_t>(workerStats.size()) };
+    const auto _chunkCount { std::clamp(drawCount / MIN_DRAWS_PER_CHUNK, 1u, _workers * CHUNKS_PER_WORKER) };
+    const auto _drawsPerChunk { (drawCount + _chunkCount - 1) / _chunkCount };
+    chunkCommandBuffers.assign(_chunkCount, VK_NULL_HANDLE);
+
+    const auto _wallStart { std::chrono::steady_clock::now() };
+    // Passed by reference: a JobSystem::Job holding the whole closure would be a heap allocation per frame.
+    const auto _recordJob = [&](uint32_t worker, uint32_t chunk)
+    {
+        const auto _start { std::chrono::steady_clock::now() };
+        const auto _firstDraw { chunk * _drawsPerChunk };
+        const auto _count { std::min(_drawsPerChunk, drawCount - std::min(drawCount, _firstDraw)) };
+
+        auto _commandBuffer { nextCommandBuffer(workerFrame(frameIndex, worker)) };
+        VkCommandBufferBeginInfo beginInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+            .pInheritanceInfo = &inheritance
+        };
+        if (vkBeginCommandBuffer(_commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to begin secondary command buffer!");
+        }
+        if (_count)
+        {
+            recordChunk(_commandBuffer, _firstDraw, _count);
+        }
+        if (vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to record secondary command buffer!");
+        }
+        chunkCommandBuffers[chunk] = _commandBuffer;
+
+        auto& _stats { workerStats[worker] };
+        _stats.recordMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count();
+        _stats.chunks++;
+        _stats.draws += _count;
+    };
+    jobs.parallelFor(_chunkCount, std::ref(_recordJob));
+    wallRecordMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _wallStart).count();
+    recordedFrames++;
+
+    return chunkCommandBuffers;
+}
+
+void ParallelRecorder::reportStats(std::ostream& out) const
+{
+    if (!recordedFrames)
+    {
+        return;
+    }
+    const auto _frames { static_cast<double>(recordedFrames) };
+    out << "Parallel recording on " << workerStats.size() << " threads: "
+        << wallRecordMs / _frames << " ms/frame wall clock\n";
+    for (size_t i = 0; i < workerStats.size(); i++)
+    {
+        const auto& _stats { workerStats[i] };
+        out << "\tthread " << i << ": " << _stats.recordMs / _frames << " ms/frame, "
+            << _stats.chunks / _frames << " chunks/frame, " << _stats.draws / _frames << " draws/frame\n";
+    }
+}
+
+ParallelRecorder::WorkerFrame& ParallelRecorder::workerFrame(uint32_t frameIndex, uint32_t workerIndex)
+{
+    return workerFrames[static_cast<size_t>(frameIndex) * workerStats.size() + workerIndex];
+}
+
+VkCommandBuffer ParallelRecorder::nextCommandBuffer(WorkerFrame& workerFrame)
+{
+    if (workerFrame.usedCommandBuffers == workerFrame.commandBuffers.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = workerFrame.pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+            .commandBufferCount = 1
+        };
+        VkCommandBuffer _commandBuffer { };
+        if (vkAllocateCommandBuffers(device, &allocInfo, &_commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate secondary command buffer!");
+        }
+        workerFrame.commandBuffers.push_back(_commandBuffer);
+    }
+    return workerFrame.commandBuffers[workerFrame.usedCommandBuffers++];
+}
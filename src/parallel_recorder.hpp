@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "job_system.hpp"
+
+// Records a frame's draw list into secondary command buffers on the JobSystem workers. Every
+// worker owns one VkCommandPool per frame in flight, so recording never contends on a pool and a
+// frame's pools can be reset wholesale once its fence signalled.
+class ParallelRecorder
+{
+public:
+    // Records draws [firstDraw, firstDraw + drawCount) into commandBuffer.
+    using RecordChunkFn = std::function<void(VkCommandBuffer commandBuffer, uint32_t firstDraw, uint32_t drawCount)>;
+
+    ParallelRecorder(VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t workerCount);
+    ~ParallelRecorder();
+
+    ParallelRecorder(const ParallelRecorder&) = delete;
+    ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+    // Resets the frame's pools, only call once the GPU is done with frameIndex's previous submission.
+    void beginFrame(uint32_t frameIndex);
+
+    // Splits drawCount draws into chunks, records them in parallel and returns the secondary
+    // command buffers in draw order, ready for vkCmdExecuteCommands.
+    std::span<const VkCommandBuffer> record(uint32_t frameIndex, const VkCommandBufferInheritanceInfo& inheritance,
+        uint32_t drawCount, const RecordChunkFn& recordChunk);
+
+    uint32_t workerCount() const { return jobs.workerCount(); }
+
+    // Per-thread record times averaged over all recorded frames.
+    void reportStats(std::ostream& out) const;
+
+private:
+    struct WorkerFrame
+    {
+        VkCommandPool pool                          { };
+        std::vector<VkCommandBuffer> commandBuffers;
+        uint32_t usedCommandBuffers                 { };
+    };
+
+    struct WorkerStats
+    {
+        double recordMs                             { };
+        uint64_t chunks                             { };
+        uint64_t draws                              { };
+    };
+
+    WorkerFrame& workerFrame(uint32_t frameIndex, uint32_t workerIndex);
+    VkCommandBuffer nextCommandBuffer(WorkerFrame& workerFrame);
+
+    VkDevice device                                 { };
+    JobSystem jobs;
+    std::vector<WorkerFrame> workerFrames;
+    std::vector<WorkerStats> workerStats;
+    std::vector<VkCommandBuffer> chunkCommandBuffers;
+    uint64_t recordedFrames                         { };
+    double wallRecordMs                             { };
+};
@@ -0,0 +1,166 @@
+#include "pipeline_cache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    // The cache header is defined as a little-endian byte stream regardless of host endianness.
+    uint32_t readLE32(std::span<const uint8_t> bytes, size_t offset)
+    {
+        return static_cast<uint32_t>(bytes[offset])
+            | static_cast<uint32_t>(bytes[offset + 1]) << 8
+            | static_cast<uint32_t>(bytes[offset + 2]) << 16
+            | static_cast<uint32_t>(bytes[offset + 3]) << 24;
+    }
+
+    constexpr size_t HEADER_SIZE_OFFSET     { 0 };
+    constexpr size_t HEADER_VERSION_OFFSET  { 4 };
+    constexpr size_t VENDOR_ID_OFFSET       { 8 };
+    constexpr size_t DEVICE_ID_OFFSET       { 12 };
+    constexpr size_t UUID_OFFSET            { 16 };
+    constexpr size_t MIN_HEADER_SIZE        { UUID_OFFSET + VK_UUID_SIZE };
+}
+
+PipelineCache::PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& deviceProperties, std::filesystem::path path)
+    : device(device), path(std::move(path))
+{
+    expectedHeader.headerSize = MIN_HEADER_SIZE;
+    expectedHeader.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+    expectedHeader.vendorID = deviceProperties.vendorID;
+    expectedHeader.deviceID = deviceProperties.deviceID;
+    std::memcpy(expectedHeader.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    auto _blob { loadBlob() };
+    if (!_blob.empty() && !isCompatible(_blob, expectedHeader))
+    {
+        std::cout << "Discarding pipeline cache " << this->path << ", it was created for another device or driver.\n";
+        _blob.clear();
+    }
+
+    VkPipelineCacheCreateInfo createInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = _blob.size(),
+        .pInitialData = _blob.empty() ? nullptr : _blob.data()
+    };
+    if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS)
+    {
+        // The blob passed validation but the driver still refused it, fall back to an empty cache.
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        _blob.clear();
+        if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create pipeline cache!");
+        }
+    }
+    warm = !_blob.empty();
+    loadedBlob = std::move(_blob);
+}
+
+PipelineCache::~PipelineCache()
+{
+    vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+bool PipelineCache::save()
+{
+    if (path.empty())
+    {
+        return true;
+    }
+
+    size_t _size { };
+    if (vkGetPipelineCacheData(device, cache, &_size, nullptr) != VK_SUCCESS)
+    {
+        std::cerr << "Failed to query pipeline cache size.\n";
+        return false;
+    }
+    std::vector<uint8_t> _data(_size);
+    if (vkGetPipelineCacheData(device, cache, &_size, _data.data()) != VK_SUCCESS)
+    {
+        std::cerr << "Failed to read pipeline cache data.\n";
+        return false;
+    }
+    _data.resize(_size);
+    if (warm && _data == loadedBlob)
+    {
+        // Nothing new was compiled this run.
+        return true;
+    }
+
+    auto _tmpPath { path };
+    _tmpPath += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream file(_tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(_data.data()), static_cast<std::streamsize>(_data.size()));
+        if (!file.flush())
+        {
+            std::cerr << "Failed to write pipeline cache " << _tmpPath << "\n";
+            file.close();
+            std::filesystem::remove(_tmpPath, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(_tmpPath, path, ec);
+    if (ec)
+    {
+        std::cerr << "Failed to replace pipeline cache " << path << ": " << ec.message() << "\n";
+        std::filesystem::remove(_tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool PipelineCache::isCompatible(std::span<const uint8_t> blob, const VkPipelineCacheHeaderVersionOne& expected)
+{
+    if (blob.size() < MIN_HEADER_SIZE)
+    {
+        return false;
+    }
+    const auto _headerSize { readLE32(blob, HEADER_SIZE_OFFSET) };
+    if (_headerSize < MIN_HEADER_SIZE || _headerSize > blob.size())
+    {
+        return false;
+    }
+    return readLE32(blob, HEADER_VERSION_OFFSET) == static_cast<uint32_t>(VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+        && readLE32(blob, VENDOR_ID_OFFSET) == expected.vendorID
+        && readLE32(blob, DEVICE_ID_OFFSET) == expected.deviceID
+        && std::memcmp(blob.data() + UUID_OFFSET, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+std::vector<uint8_t> PipelineCache::loadBlob() const
+{
+    if (path.empty())
+    {
+        return { };
+    }
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return { };
+    }
+    // A directory or unreadable path reports -1, treat it as no cache.
+    const auto _end { file.tellg() };
+    if (_end < 0)
+    {
+        return { };
+    }
+    const auto _size { static_cast<size_t>(_end) };
+    std::vector<uint8_t> _blob(_size);
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(_blob.data()), static_cast<std::streamsize>(_size));
+    if (!file)
+    {
+        return { };
+    }
+    return _blob;
+}
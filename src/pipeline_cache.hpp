@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Owns the application's VkPipelineCache and its on-disk copy. The blob is only reused when its
+// header matches the physical device it was created on, anything else is silently discarded so a
+// driver update or a different GPU simply results in a cold start.
+class PipelineCache
+{
+public:
+    PipelineCache(VkDevice device, const VkPhysicalDeviceProperties& deviceProperties, std::filesystem::path path);
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    VkPipelineCache handle() const { return cache; }
+
+    // True when a valid blob was loaded from disk.
+    bool isWarm() const { return warm; }
+
+    // Writes the cache to a temporary file next to the target and renames it over the old blob,
+    // so a crash mid-write never leaves a truncated cache behind. Does not throw, returns false
+    // and logs on failure.
+    bool save();
+
+    static bool isCompatible(std::span<const uint8_t> blob, const VkPipelineCacheHeaderVersionOne& expected);
+
+private:
+    std::vector<uint8_t> loadBlob() const;
+
+    VkDevice device                                 { };
+    VkPipelineCache cache                           { };
+    VkPipelineCacheHeaderVersionOne expectedHeader  { };
+    std::filesystem::path path;
+    // What was handed to the driver, save() skips the write when the cache still matches it.
+    std::vector<uint8_t> loadedBlob;
+    bool warm                                       { };
+};
@@ -0,0 +1,81 @@
+#include "present_policy.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    // Preference order per policy, FIFO is appended implicitly.
+    std::span<const VkPresentModeKHR> preferredModes(PresentPolicy policy)
+    {
+        // No tearing, and the newest frame replaces a queued one instead of waiting behind it.
+        static constexpr std::array LOW_LATENCY { VK_PRESENT_MODE_MAILBOX_KHR };
+        // Strict vsync: the GPU idles once the queue is full.
+        static constexpr std::array<VkPresentModeKHR, 0> POWER_SAVING { };
+        // Never block on the display, tearing is acceptable for benchmarks.
+        static constexpr std::array UNCAPPED {
+            VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR
+        };
+
+        switch (policy)
+        {
+        case PresentPolicy::LowLatency:
+            return LOW_LATENCY;
+        case PresentPolicy::PowerSaving:
+            return POWER_SAVING;
+        case PresentPolicy::Uncapped:
+            return UNCAPPED;
+        }
+        return { };
+    }
+}
+
+PresentConfig choosePresentConfig(PresentPolicy policy, std::span<const VkPresentModeKHR> availableModes,
+    const VkSurfaceCapabilitiesKHR& capabilities)
+{
+    PresentConfig _config { };
+    for (const auto mode : preferredModes(policy))
+    {
+        if (std::ranges::find(availableModes, mode) != availableModes.end())
+        {
+            _config.presentMode = mode;
+            break;
+        }
+    }
+
+    // Mailbox and immediate need a spare image to render into while one is queued and one is
+    // scanned out. FIFO under low latency keeps the queue as short as the surface allows, every
+    // extra image is another frame of latency; power saving accepts that for fewer wake-ups.
+    switch (_config.presentMode)
+    {
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        _config.imageCount = std::max(capabilities.minImageCount + 1, 3u);
+        break;
+    default:
+        _config.imageCount = policy == PresentPolicy::LowLatency ? capabilities.minImageCount : capabilities.minImageCount + 1;
+        break;
+    }
+    if (capabilities.maxImageCount > 0)
+    {
+        _config.imageCount = std::min(_config.imageCount, capabilities.maxImageCount);
+    }
+    return _config;
+}
+
+const char* presentModeName(VkPresentModeKHR presentMode)
+{
+    switch (presentMode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        return "IMMEDIATE";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        return "MAILBOX";
+    case VK_PRESENT_MODE_FIFO_KHR:
+        return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+        return "FIFO_RELAXED";
+    default:
+        return "other";
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <vulkan/vulkan.h>
+
+#include "app_config.hpp"
+
+struct PresentConfig
+{
+    VkPresentModeKHR presentMode    { VK_PRESENT_MODE_FIFO_KHR };
+    uint32_t imageCount             { };
+};
+
+// Picks the present mode and swapchain image count for policy out of what the surface supports.
+// FIFO is the only mode every surface has, so it is the fallback for all policies.
+PresentConfig choosePresentConfig(PresentPolicy policy, std::span<const VkPresentModeKHR> availableModes,
+    const VkSurfaceCapabilitiesKHR& capabilities);
+
+const char* presentModeName(VkPresentModeKHR presentMode);
@@ -0,0 +1,258 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    constexpr uint32_t MAX_GPU_SCOPES_PER_FRAME { 64 };
+    // About a minute of a busy frame at 144 Hz, after that new events are counted but not kept.
+    constexpr size_t MAX_EVENTS                 { 1u << 20 };
+
+    void writeJsonString(std::ostream& out, std::string_view value)
+    {
+        out << '"';
+        for (const char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+}
+
+Profiler::Profiler(VkDevice device, float timestampPeriod, uint32_t timestampValidBits, uint32_t framesInFlight)
+    : device(device), nsPerTick(timestampPeriod), origin(Clock::now())
+{
+    events.reserve(MAX_EVENTS);
+    if (!timestampValidBits)
+    {
+        return;
+    }
+    timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+
+    frameQueries.resize(framesInFlight);
+    for (auto& frame : frameQueries)
+    {
+        VkQueryPoolCreateInfo poolInfo {
+            .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount = MAX_GPU_SCOPES_PER_FRAME * 2
+        };
+        if (vkCreateQueryPool(device, &poolInfo, nullptr, &frame.pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create timestamp query pool!");
+        }
+        frame.scopes.reserve(MAX_GPU_SCOPES_PER_FRAME);
+    }
+}
+
+Profiler::~Profiler()
+{
+    for (auto& frame : frameQueries)
+    {
+        vkDestroyQueryPool(device, frame.pool, nullptr);
+    }
+}
+
+Profiler::CpuScope::CpuScope(Profiler& profiler, const char* name)
+    : profiler(profiler), name(name), start(Clock::now())
+{
+}
+
+Profiler::CpuScope::~CpuScope()
+{
+    const auto _end { Clock::now() };
+    profiler.addEvent({
+        .name = name,
+        .gpu = false,
+        .thread = threadIndex(),
+        .startUs = profiler.toUs(start),
+        .durationUs = std::chrono::duration<double, std::micro>(_end - start).count()
+    });
+}
+
+void Profiler::beginFrame(uint32_t frameIndex, std::pmr::memory_resource& scratch)
+{
+    if (!gpuTimingEnabled())
+    {
+        return;
+    }
+    auto& _frame { frameQueries[frameIndex] };
+    if (!_frame.pending || _frame.scopes.empty())
+    {
+        _frame.pending = false;
+        _frame.scopes.clear();
+        return;
+    }
+    _frame.pending = false;
+
+    const auto _queryCount { static_cast<uint32_t>(_frame.scopes.size() * 2) };
+    std::pmr::vector<uint64_t> _ticks(_queryCount, &scratch);
+    if (vkGetQueryPoolResults(device, _frame.pool, 0, _queryCount, _ticks.size() * sizeof(uint64_t), _ticks.data(),
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        _frame.scopes.clear();
+        return;
+    }
+
+    const auto _toUs = [&](uint64_t ticks) { return static_cast<double>(ticks & timestampMask) * nsPerTick / 1000.0; };
+    // Without calibrated timestamps the GPU clock is only known relative to itself. Anchor it so
+    // the frame's first GPU scope starts no earlier than its submission; the offset only grows,
+    // so the GPU track stays monotonic and drift towards "GPU work started late" is corrected.
+    const auto _firstUs { _toUs(_ticks[0]) };
+    if (!gpuOffsetValid || _firstUs + gpuOffsetUs < _frame.submitUs)
+    {
+        gpuOffsetUs = _frame.submitUs - _firstUs;
+        gpuOffsetValid = true;
+    }
+    for (size_t i = 0; i < _frame.scopes.size(); i++)
+    {
+        const auto _begin { _toUs(_ticks[i * 2]) };
+        const auto _end { _toUs(_ticks[i * 2 + 1]) };
+        addEvent({
+            .name = _frame.scopes[i],
+            .gpu = true,
+            .startUs = _begin + gpuOffsetUs,
+            .durationUs = std::max(0.0, _end - _begin)
+        });
+    }
+    _frame.scopes.clear();
+}
+
+void Profiler::resetQueries(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    if (!gpuTimingEnabled())
+    {
+        return;
+    }
+    vkCmdResetQueryPool(commandBuffer, frameQueries[frameIndex].pool, 0, MAX_GPU_SCOPES_PER_FRAME * 2);
+}
+
+uint32_t Profiler::beginGpuScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, const char* name)
+{
+    if (!gpuTimingEnabled() || frameQueries[frameIndex].scopes.size() == MAX_GPU_SCOPES_PER_FRAME)
+    {
+        return MAX_GPU_SCOPES_PER_FRAME;
+    }
+    auto& _frame { frameQueries[frameIndex] };
+    const auto _scope { static_cast<uint32_t>(_frame.scopes.size()) };
+    _frame.scopes.push_back(name);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _frame.pool, _scope * 2);
+    return _scope;
+}
+
+void Profiler::endGpuScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scope)
+{
+    if (scope >= MAX_GPU_SCOPES_PER_FRAME)
+    {
+        return;
+    }
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frameQueries[frameIndex].pool, scope * 2 + 1);
+}
+
+void Profiler::markSubmitted(uint32_t frameIndex)
+{
+    if (!gpuTimingEnabled())
+    {
+        return;
+    }
+    auto& _frame { frameQueries[frameIndex] };
+    _frame.submitUs = toUs(Clock::now());
+    _frame.pending = true;
+}
+
+void Profiler::addEvent(const Event& event)
+{
+    std::lock_guard _lock { mutex };
+    if (events.size() == MAX_EVENTS)
+    {
+        droppedEvents++;
+        return;
+    }
+    events.push_back(event);
+}
+
+double Profiler::toUs(Clock::time_point time) const
+{
+    return std::chrono::duration<double, std::micro>(time - origin).count();
+}
+
+uint32_t Profiler::threadIndex()
+{
+    static std::atomic<uint32_t> nextIndex { };
+    thread_local const uint32_t index { nextIndex++ };
+    return index;
+}
+
+void Profiler::report(std::ostream& out) const
+{
+    struct Total
+    {
+        double us       { };
+        uint64_t count  { };
+    };
+    std::map<std::pair<bool, std::string_view>, Total> _totals;
+    {
+        std::lock_guard _lock { mutex };
+        for (const auto& event : events)
+        {
+            auto& _total { _totals[{ event.gpu, event.name }] };
+            _total.us += event.durationUs;
+            _total.count++;
+        }
+    }
+    if (_totals.empty())
+    {
+        return;
+    }
+
+    out << "Profile (average per scope" << (gpuTimingEnabled() ? "" : ", no GPU timestamps on this queue") << "):\n";
+    for (const auto& [key, total] : _totals)
+    {
+        out << '\t' << (key.first ? "gpu " : "cpu ") << key.second << ": " << total.us / 1000.0 / total.count
+            << " ms x " << total.count << '\n';
+    }
+    if (droppedEvents)
+    {
+        out << '\t' << droppedEvents << " events dropped, trace buffer full\n";
+    }
+}
+
+bool Profiler::writeChromeTrace(const std::filesystem::path& path) const
+{
+    std::ofstream _file { path, std::ios::binary | std::ios::trunc };
+    if (!_file)
+    {
+        return false;
+    }
+
+    // GPU events go on their own track, after every CPU thread.
+    constexpr uint32_t GPU_TRACK { 1000 };
+    _file << std::fixed << std::setprecision(3);
+    _file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    _file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << GPU_TRACK << ",\"args\":{\"name\":\"GPU\"}}";
+    {
+        std::lock_guard _lock { mutex };
+        for (const auto& event : events)
+        {
+            _file << ",\n{\"name\":";
+            writeJsonString(_file, event.name);
+            _file << ",\"cat\":\"" << (event.gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+                << (event.gpu ? GPU_TRACK : event.thread) << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << '}';
+        }
+    }
+    _file << "\n]}\n";
+    return static_cast<bool>(_file);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// Frame profiler combining CPU scope timers with GPU timestamp queries. Every frame in flight owns
+// a VkQueryPool; its results are read back once the frame's fence has signalled, converted with
+// timestampPeriod and placed on the CPU timeline so both can be exported as one Chrome trace
+// (chrome://tracing or ui.perfetto.dev).
+//
+// Scope names must be string literals or otherwise outlive the profiler.
+class Profiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // timestampValidBits of the queue family the GPU scopes are recorded on, 0 disables GPU timing.
+    Profiler(VkDevice device, float timestampPeriod, uint32_t timestampValidBits, uint32_t framesInFlight);
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // RAII CPU timer, safe to use from any thread.
+    class CpuScope
+    {
+    public:
+        CpuScope(Profiler& profiler, const char* name);
+        ~CpuScope();
+
+        CpuScope(const CpuScope&) = delete;
+        CpuScope& operator=(const CpuScope&) = delete;
+
+    private:
+        Profiler& profiler;
+        const char* name;
+        Clock::time_point start;
+    };
+
+    CpuScope cpuScope(const char* name) { return CpuScope(*this, name); }
+
+    // Collects the GPU results of frameIndex's previous submission, call after its fence signalled.
+    // scratch only has to last for the call, e.g. the frame's FrameArena.
+    void beginFrame(uint32_t frameIndex, std::pmr::memory_resource& scratch);
+    // Must be recorded first into the frame's command buffer, outside any render pass.
+    void resetQueries(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    // Returns a handle for endGpuScope(), scopes beyond the per-frame budget are silently dropped.
+    uint32_t beginGpuScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, const char* name);
+    void endGpuScope(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t scope);
+    // Marks the CPU time of the frame's queue submission, the earliest its GPU work can start.
+    void markSubmitted(uint32_t frameIndex);
+
+    bool gpuTimingEnabled() const { return !frameQueries.empty(); }
+
+    // Average duration per scope name, CPU and GPU separately.
+    void report(std::ostream& out) const;
+    // Writes all recorded events in the Chrome trace event format, returns false on I/O errors.
+    bool writeChromeTrace(const std::filesystem::path& path) const;
+
+private:
+    struct Event
+    {
+        const char* name    { };
+        bool gpu            { };
+        uint32_t thread     { };
+        double startUs      { };
+        double durationUs   { };
+    };
+
+    struct FrameQueries
+    {
+        VkQueryPool pool                    { };
+        std::vector<const char*> scopes;
+        double submitUs                     { };
+        bool pending                        { };
+    };
+
+    void addEvent(const Event& event);
+    double toUs(Clock::time_point time) const;
+    static uint32_t threadIndex();
+
+    VkDevice device                         { };
+    double nsPerTick                        { };
+    uint64_t timestampMask                  { };
+    std::vector<FrameQueries> frameQueries;
+    // GPU ticks to CPU microseconds, only ever moves forward, see beginFrame().
+    double gpuOffsetUs                      { };
+    bool gpuOffsetValid                     { };
+    Clock::time_point origin;
+
+    mutable std::mutex mutex;
+    std::vector<Event> events;
+    uint64_t droppedEvents                  { };
+};
@@ -0,0 +1,505 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    struct AccessInfo
+    {
+        VkPipelineStageFlags stages { };
+        VkAccessFlags access        { };
+        VkImageLayout layout        { };
+    };
+
+    constexpr VkAccessFlags WRITE_ACCESS {
+        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+            | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+    };
+
+    constexpr AccessInfo accessInfo(GraphAccess access)
+    {
+        switch (access)
+        {
+        case GraphAccess::Acquired:
+            // The wait stage of the acquire semaphore, so the first transition can't happen before it.
+            return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+        case GraphAccess::IndirectRead:
+            return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+        case GraphAccess::ComputeRead:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL };
+        case GraphAccess::ComputeSampledRead:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        case GraphAccess::ComputeWrite:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+        case GraphAccess::ColorAttachmentWrite:
+            return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        case GraphAccess::DepthAttachmentWrite:
+            return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        case GraphAccess::TransferRead:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL };
+        case GraphAccess::Present:
+            return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+        }
+        return { };
+    }
+
+    constexpr bool isWrite(GraphAccess access)
+    {
+        return accessInfo(access).access & WRITE_ACCESS;
+    }
+
+    VkImageAspectFlags aspectOf(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+}
+
+RenderGraph::RenderGraph(VkDevice device, GpuAllocator& allocator, bool synchronization2)
+    : device(device), allocator(allocator), synchronization2(synchronization2)
+{
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+}
+
+RenderGraph::~RenderGraph()
+{
+    for (auto& resource : resources)
+    {
+        if (resource.transient)
+        {
+            vkDestroyImageView(device, resource.view, nullptr);
+            vkDestroyImage(device, resource.handle, nullptr);
+        }
+    }
+    for (auto& slot : slots)
+    {
+        allocator.free(slot.allocation);
+    }
+}
+
+GraphResource RenderGraph::importImage(const char* name, VkImageAspectFlags aspect, std::optional<GraphAccess> initial,
+    std::optional<GraphAccess> finalAccess)
+{
+    if (compiled)
+    {
+        throw std::runtime_error("Failed to import image into a compiled render graph!");
+    }
+    resources.push_back({ .name = name, .image = true, .aspect = aspect, .initial = initial, .finalAccess = finalAccess });
+    return static_cast<GraphResource>(resources.size() - 1);
+}
+
+GraphResource RenderGraph::importBuffer(const char* name)
+{
+    if (compiled)
+    {
+        throw std::runtime_error("Failed to import buffer into a compiled render graph!");
+    }
+    resources.push_back({ .name = name });
+    return static_cast<GraphResource>(resources.size() - 1);
+}
+
+GraphResource RenderGraph::createImage(const char* name, const TransientImageDesc& desc)
+{
+    if (compiled)
+    {
+        throw std::runtime_error("Failed to add transient image to a compiled render graph!");
+    }
+    resources.push_back({ .name = name, .image = true, .transient = true, .aspect = aspectOf(desc.format), .desc = desc });
+    return static_cast<GraphResource>(resources.size() - 1);
+}
+
+void RenderGraph::addPass(const char* name, std::initializer_list<GraphUse> uses, PassCallback record, bool sideEffect)
+{
+    if (compiled)
+    {
+        throw std::runtime_error(std::string("Failed to add pass ") + name + " to a compiled render graph!");
+    }
+    for (auto use = uses.begin(); use != uses.end(); use++)
+    {
+        if (use->resource >= resources.size()
+            || std::any_of(uses.begin(), use, [&](const GraphUse& other) { return other.resource == use->resource; }))
+        {
+            throw std::runtime_error(std::string("Pass ") + name + " uses an unknown resource or one twice!");
+        }
+    }
+    passes.push_back({ .name = name, .uses = uses, .record = std::move(record), .sideEffect = sideEffect });
+}
+
+void RenderGraph::compile()
+{
+    if (compiled)
+    {
+        throw std::runtime_error("Render graph is already compiled!");
+    }
+    cullPasses();
+    createTransients();
+    compiled = true;
+}
+
+void RenderGraph::cullPasses()
+{
+    // Walking backwards, a pass is needed when it writes something that outlives the frame or
+    // that a needed pass reads.
+    std::vector<bool> _read(resources.size());
+    for (auto pass = passes.rbegin(); pass != passes.rend(); pass++)
+    {
+        pass->culled = !pass->sideEffect && std::none_of(pass->uses.begin(), pass->uses.end(), [&](const GraphUse& use) {
+            return isWrite(use.access) && (!resources[use.resource].transient || _read[use.resource]);
+        });
+        if (pass->culled)
+        {
+            counters.culledPasses++;
+            continue;
+        }
+        for (const auto& use : pass->uses)
+        {
+            _read[use.resource] = _read[use.resource] || !isWrite(use.access);
+        }
+    }
+    counters.passes = static_cast<uint32_t>(passes.size());
+}
+
+void RenderGraph::createTransients()
+{
+    for (uint32_t i = 0; i < passes.size(); i++)
+    {
+        if (passes[i].culled)
+        {
+            continue;
+        }
+        for (const auto& use : passes[i].uses)
+        {
+            auto& _resource { resources[use.resource] };
+            if (!_resource.firstPass)
+            {
+                _resource.firstPass = i;
+            }
+            _resource.lastPass = i;
+        }
+    }
+
+    std::vector<GraphResource> _transients;
+    std::vector<VkMemoryRequirements> _requirements(resources.size());
+    for (GraphResource i = 0; i < resources.size(); i++)
+    {
+        auto& _resource { resources[i] };
+        // Only used by culled passes, never created.
+        if (!_resource.transient || !_resource.firstPass)
+        {
+            continue;
+        }
+        VkImageCreateInfo imageInfo {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = _resource.desc.format,
+            .extent = { _resource.desc.extent.width, _resource.desc.extent.height, 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = VK_SAMPLE_COUNT_1_BIT,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = _resource.desc.usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+        };
+        if (vkCreateImage(device, &imageInfo, nullptr, &_resource.handle) != VK_SUCCESS)
+        {
+            throw std::runtime_error(std::string("Failed to create transient image ") + _resource.name + "!");
+        }
+        vkGetImageMemoryRequirements(device, _resource.handle, &_requirements[i]);
+        counters.transientBytes += _requirements[i].size;
+        _transients.push_back(i);
+    }
+
+    // Largest first, each into the first slot it shares a memory type with and whose images are
+    // all dead before it starts or born after it ends.
+    std::sort(_transients.begin(), _transients.end(),
+        [&](GraphResource a, GraphResource b) { return _requirements[a].size > _requirements[b].size; });
+    for (const auto index : _transients)
+    {
+        auto& _resource { resources[index] };
+        const auto& _needs { _requirements[index] };
+        const auto _fits = [&](const MemorySlot& slot) {
+            return (slot.requirements.memoryTypeBits & _needs.memoryTypeBits)
+                && std::all_of(slot.resources.begin(), slot.resources.end(), [&](GraphResource other) {
+                    return resources[other].lastPass < *_resource.firstPass || *resources[other].firstPass > _resource.lastPass;
+                });
+        };
+        auto _slot { std::find_if(slots.begin(), slots.end(), _fits) };
+        if (_slot == slots.end())
+        {
+            _slot = slots.insert(slots.end(), MemorySlot { .requirements = _needs });
+        }
+        _slot->requirements.size = std::max(_slot->requirements.size, _needs.size);
+        _slot->requirements.alignment = std::max(_slot->requirements.alignment, _needs.alignment);
+        _slot->requirements.memoryTypeBits &= _needs.memoryTypeBits;
+        _slot->resources.push_back(index);
+        _resource.slot = static_cast<uint32_t>(_slot - slots.begin());
+    }
+
+    for (auto& slot : slots)
+    {
+        slot.allocation = allocator.allocate(slot.requirements, MemoryUsage::GpuOnly, ResourceKind::Optimal);
+        counters.allocatedBytes += slot.requirements.size;
+        for (const auto index : slot.resources)
+        {
+            auto& _resource { resources[index] };
+            vkBindImageMemory(device, _resource.handle, slot.allocation.memory, slot.allocation.offset);
+
+            // Depth-stencil images are only ever sampled for depth.
+            const VkImageAspectFlags _viewAspect {
+                _resource.aspect & VK_IMAGE_ASPECT_DEPTH_BIT ? static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_DEPTH_BIT) : _resource.aspect
+            };
+            VkImageViewCreateInfo viewInfo {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                .image = _resource.handle,
+                .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                .format = _resource.desc.format,
+                .subresourceRange = { _viewAspect, 0, 1, 0, 1 }
+            };
+            if (vkCreateImageView(device, &viewInfo, nullptr, &_resource.view) != VK_SUCCESS)
+            {
+                throw std::runtime_error(std::string("Failed to create transient image view ") + _resource.name + "!");
+            }
+        }
+    }
+    counters.transientImages = static_cast<uint32_t>(_transients.size());
+    counters.transientAllocations = static_cast<uint32_t>(slots.size());
+}
+
+void RenderGraph::setImage(GraphResource resource, VkImage image)
+{
+    auto& _resource { resources[resource] };
+    if (_resource.handle != image)
+    {
+        // A different image has no history, whatever the previous one was doing doesn't matter.
+        _resource.handle = image;
+        _resource.state = { };
+    }
+}
+
+VkImageView RenderGraph::imageView(GraphResource resource) const
+{
+    return resources[resource].view;
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer)
+{
+    for (auto& resource : resources)
+    {
+        if (resource.initial)
+        {
+            const auto _info { accessInfo(*resource.initial) };
+            resource.state = { .layout = _info.layout, .stages = _info.stages, .access = _info.access & WRITE_ACCESS };
+        }
+    }
+
+    for (uint32_t i = 0; i < passes.size(); i++)
+    {
+        const auto& _pass { passes[i] };
+        if (_pass.culled)
+        {
+            continue;
+        }
+        for (const auto& use : _pass.uses)
+        {
+            auto& _resource { resources[use.resource] };
+            if (_resource.transient && *_resource.firstPass == i)
+            {
+                // Contents are discarded, but the last user of the memory, an alias or this image
+                // in the previous frame, has to be done with it.
+                const auto& _previous { slots[_resource.slot].state };
+                _resource.state = { .stages = _previous.stages | _previous.readStages, .access = _previous.access };
+            }
+            require(use.resource, use.access);
+            if (_resource.transient)
+            {
+                slots[_resource.slot].state = _resource.state;
+            }
+        }
+        flushBarriers(commandBuffer);
+        _pass.record(commandBuffer);
+    }
+
+    for (GraphResource i = 0; i < resources.size(); i++)
+    {
+        if (resources[i].finalAccess)
+        {
+            require(i, *resources[i].finalAccess);
+        }
+    }
+    flushBarriers(commandBuffer);
+    counters.frames++;
+}
+
+void RenderGraph::require(GraphResource resource, GraphAccess access)
+{
+    auto& _resource { resources[resource] };
+    auto& _state { _resource.state };
+    const auto _info { accessInfo(access) };
+    const bool _write { (_info.access & WRITE_ACCESS) != 0 };
+    const bool _transition { _resource.image && _info.layout != _state.layout };
+    if (_resource.image && !_resource.handle)
+    {
+        throw std::runtime_error(std::string("Render graph image ") + _resource.name + " was never set!");
+    }
+
+    if (!_write && !_transition)
+    {
+        // Reads of data that is already visible to them, or that nothing in the graph wrote, need no barrier.
+        const bool _visible { (_state.readStages & _info.stages) == _info.stages
+            && (_state.readAccess & _info.access) == _info.access };
+        if (_state.stages && !_visible)
+        {
+            srcStages |= _state.stages;
+            dstStages |= _info.stages;
+            memoryBarrier.srcStageMask |= _state.stages;
+            memoryBarrier.dstStageMask |= _info.stages;
+            memoryBarrier.srcAccessMask |= _state.access;
+            memoryBarrier.dstAccessMask |= _info.access;
+            batchDependencies++;
+        }
+        _state.readStages |= _info.stages;
+        _state.readAccess |= _info.access;
+        return;
+    }
+
+    // Writes and layout transitions wait for the last write and every read since.
+    VkPipelineStageFlags _waitStages { _state.stages | _state.readStages };
+    if (!_waitStages)
+    {
+        _waitStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    }
+    srcStages |= _waitStages;
+    dstStages |= _info.stages;
+    if (_transition)
+    {
+        imageBarriers.push_back({
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask = _waitStages,
+            .srcAccessMask = _state.access,
+            .dstStageMask = _info.stages,
+            .dstAccessMask = _info.access,
+            .oldLayout = _state.layout,
+            .newLayout = _info.layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = _resource.handle,
+            .subresourceRange = { _resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS }
+        });
+        counters.layoutTransitions++;
+    }
+    else
+    {
+        memoryBarrier.srcStageMask |= _waitStages;
+        memoryBarrier.dstStageMask |= _info.stages;
+        memoryBarrier.srcAccessMask |= _state.access;
+        memoryBarrier.dstAccessMask |= _info.access;
+    }
+    batchDependencies++;
+    _state = {
+        .layout = _info.layout,
+        .stages = _info.stages,
+        .access = _info.access & WRITE_ACCESS,
+        .readStages = _write ? 0 : _info.stages,
+        .readAccess = _write ? 0 : _info.access
+    };
+}
+
+void RenderGraph::flushBarriers(VkCommandBuffer commandBuffer)
+{
+    if (!batchDependencies)
+    {
+        return;
+    }
+    if (synchronization2)
+    {
+        // Execution-only dependencies (write after read) still need the stages of a memory barrier.
+        const bool _memory { memoryBarrier.srcStageMask || memoryBarrier.dstStageMask };
+        const VkDependencyInfo _dependency {
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .memoryBarrierCount = _memory ? 1u : 0u,
+            .pMemoryBarriers = &memoryBarrier,
+            .imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size()),
+            .pImageMemoryBarriers = imageBarriers.data()
+        };
+        vkCmdPipelineBarrier2(commandBuffer, &_dependency);
+    }
+    else
+    {
+        // Execution-only dependencies need no memory barrier at all, srcStages and dstStages cover them.
+        const bool _memory { memoryBarrier.srcAccessMask || memoryBarrier.dstAccessMask };
+        const VkMemoryBarrier _legacyMemory {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = static_cast<VkAccessFlags>(memoryBarrier.srcAccessMask),
+            .dstAccessMask = static_cast<VkAccessFlags>(memoryBarrier.dstAccessMask)
+        };
+        legacyImageBarriers.clear();
+        for (const auto& barrier : imageBarriers)
+        {
+            legacyImageBarriers.push_back({
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask),
+                .dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask),
+                .oldLayout = barrier.oldLayout,
+                .newLayout = barrier.newLayout,
+                .srcQueueFamilyIndex = barrier.srcQueueFamilyIndex,
+                .dstQueueFamilyIndex = barrier.dstQueueFamilyIndex,
+                .image = barrier.image,
+                .subresourceRange = barrier.subresourceRange
+            });
+        }
+        vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, _memory ? 1 : 0, &_legacyMemory, 0, nullptr,
+            static_cast<uint32_t>(legacyImageBarriers.size()), legacyImageBarriers.data());
+    }
+    counters.dependencies += batchDependencies;
+    counters.barrierCalls++;
+
+    srcStages = 0;
+    dstStages = 0;
+    memoryBarrier.srcStageMask = 0;
+    memoryBarrier.dstStageMask = 0;
+    memoryBarrier.srcAccessMask = 0;
+    memoryBarrier.dstAccessMask = 0;
+    imageBarriers.clear();
+    batchDependencies = 0;
+}
+
+void RenderGraph::reportStats(std::ostream& out) const
+{
+    if (!counters.frames)
+    {
+        return;
+    }
+    const auto _perFrame = [&](uint64_t total) { return static_cast<double>(total) / static_cast<double>(counters.frames); };
+    const auto _mb = [](VkDeviceSize bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+    out << std::fixed << std::setprecision(1)
+        << "Render graph, " << counters.passes - counters.culledPasses << " of " << counters.passes << " passes ("
+        << counters.culledPasses << " culled), average over " << counters.frames << " frames:\n"
+        << "\ttransient images " << counters.transientImages << " in " << counters.transientAllocations << " allocations, "
+        << _mb(counters.allocatedBytes) << " MiB (" << _mb(counters.transientBytes) << " MiB without aliasing, "
+        << _mb(counters.transientBytes - counters.allocatedBytes) << " MiB saved)\n"
+        << "\tbarriers         " << _perFrame(counters.barrierCalls)
+        << (synchronization2 ? " vkCmdPipelineBarrier2" : " vkCmdPipelineBarrier") << " calls ("
+        << _perFrame(counters.dependencies) << " unbatched), " << _perFrame(counters.layoutTransitions) << " layout transitions\n"
+        << std::defaultfloat;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iosfwd>
+#include <optional>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "gpu_allocator.hpp"
+
+// How a pass touches a resource, decides the stages, access mask and image layout the graph
+// synchronises it with.
+enum class GraphAccess
+{
+    Acquired,               // swapchain image after acquire, contents undefined
+    IndirectRead,           // indirect draw arguments and counts
+    ComputeRead,            // buffer, or image in GENERAL, read by a compute shader
+    ComputeSampledRead,     // image sampled in SHADER_READ_ONLY_OPTIMAL by a compute shader
+    ComputeWrite,           // buffer, or storage image in GENERAL, written by a compute shader
+    ColorAttachmentWrite,
+    DepthAttachmentWrite,
+    TransferRead,
+    Present,
+};
+
+using GraphResource = uint32_t;
+
+struct GraphUse
+{
+    GraphResource resource  { };
+    GraphAccess access      { };
+};
+
+// Image the graph creates and owns, alive only between its first and last use in a frame.
+struct TransientImageDesc
+{
+    VkFormat format         { };
+    VkExtent2D extent       { };
+    VkImageUsageFlags usage { };
+};
+
+struct RenderGraphStats
+{
+    uint32_t passes                 { };
+    uint32_t culledPasses           { };
+    uint32_t transientImages        { };
+    uint32_t transientAllocations   { };
+    VkDeviceSize transientBytes     { };    // sum of the transient images' sizes
+    VkDeviceSize allocatedBytes     { };    // what they occupy once aliased
+    uint64_t frames                 { };
+    uint64_t dependencies           { };    // one barrier call each without batching
+    uint64_t barrierCalls           { };
+    uint64_t layoutTransitions      { };
+};
+
+// Frame graph: passes declare the resources they read and write and run in declaration order,
+// compile() works out everything in between once:
+//  - passes none of whose writes reach an imported resource or a later kept pass are culled,
+//  - transient images get one allocation per group of images whose lifetimes don't overlap,
+//  - execute() tracks the state of every resource and records, before each pass, one
+//    vkCmdPipelineBarrier with every dependency it needs. Reads of already visible data need none,
+//    and only layout changes become image barriers, the rest is folded into one VkMemoryBarrier.
+//    With synchronization2 it is one vkCmdPipelineBarrier2 instead, where every image barrier
+//    keeps its own stages rather than waiting on the union of the whole batch.
+// Buffers are purely logical, the graph never needs their handles. Imported images are bound with
+// setImage() before every execute(); their state carries over between frames unless they are
+// imported with an initial access, or setImage() hands over a different image.
+// Barriers inside a pass, such as between the mip levels of a downsample, stay with the pass.
+class RenderGraph
+{
+public:
+    using PassCallback = std::function<void(VkCommandBuffer)>;
+
+    // synchronization2 needs the feature enabled and vkCmdPipelineBarrier2 loaded.
+    RenderGraph(VkDevice device, GpuAllocator& allocator, bool synchronization2);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // initial is the state every execute() starts from, finalAccess the one it must leave the image in.
+    // Names must be string literals or otherwise outlive the graph, as for Profiler scopes.
+    GraphResource importImage(const char* name, VkImageAspectFlags aspect, std::optional<GraphAccess> initial = std::nullopt,
+        std::optional<GraphAccess> finalAccess = std::nullopt);
+    GraphResource importBuffer(const char* name);
+    GraphResource createImage(const char* name, const TransientImageDesc& desc);
+    // Every resource at most once per pass. Passes with sideEffect are never culled.
+    void addPass(const char* name, std::initializer_list<GraphUse> uses, PassCallback record, bool sideEffect = false);
+    void compile();
+
+    void setImage(GraphResource resource, VkImage image);
+    // Transient images only, valid after compile().
+    VkImageView imageView(GraphResource resource) const;
+
+    void execute(VkCommandBuffer commandBuffer);
+
+    const RenderGraphStats& stats() const { return counters; }
+    void reportStats(std::ostream& out) const;
+
+private:
+    struct ResourceState
+    {
+        VkImageLayout layout            { VK_IMAGE_LAYOUT_UNDEFINED };
+        // Last write or layout transition, and the reads that already waited for it.
+        VkPipelineStageFlags stages     { };
+        VkAccessFlags access            { };
+        VkPipelineStageFlags readStages { };
+        VkAccessFlags readAccess        { };
+    };
+
+    struct Resource
+    {
+        const char* name                { };
+        bool image                      { };
+        bool transient                  { };
+        VkImageAspectFlags aspect       { };
+        std::optional<GraphAccess> initial;
+        std::optional<GraphAccess> finalAccess;
+        TransientImageDesc desc;
+        VkImage handle                  { };
+        VkImageView view                { };
+        // Transient only: memory slot, and first and last kept pass using it.
+        uint32_t slot                   { };
+        std::optional<uint32_t> firstPass;
+        uint32_t lastPass               { };
+        ResourceState state;
+    };
+
+    struct Pass
+    {
+        const char* name                { };
+        std::vector<GraphUse> uses;
+        PassCallback record;
+        bool sideEffect                 { };
+        bool culled                     { };
+    };
+
+    // Memory shared by transient images with disjoint lifetimes.
+    struct MemorySlot
+    {
+        VkMemoryRequirements requirements { };
+        std::vector<GraphResource> resources;
+        GpuAllocation allocation;
+        // State of whichever image used the memory last, what the next one has to wait for.
+        ResourceState state;
+    };
+
+    void cullPasses();
+    void createTransients();
+    void require(GraphResource resource, GraphAccess access);
+    void flushBarriers(VkCommandBuffer commandBuffer);
+
+    VkDevice device                         { };
+    GpuAllocator& allocator;
+    bool synchronization2                   { };
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<MemorySlot> slots;
+    bool compiled                           { };
+
+    // Barrier batch being collected for the next pass, in synchronization2 form. Without it the
+    // image barriers lose their stages and everything waits on srcStages and dstStages.
+    VkPipelineStageFlags srcStages          { };
+    VkPipelineStageFlags dstStages          { };
+    VkMemoryBarrier2 memoryBarrier          { };
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+    std::vector<VkImageMemoryBarrier> legacyImageBarriers;
+    uint32_t batchDependencies              { };
+
+    RenderGraphStats counters;
+};
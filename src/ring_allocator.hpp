@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Linear allocator over a circular [0, capacity) range for data that only lives for a frame.
+// Allocations are never freed individually: the frame that made them is closed with endFrame()
+// and everything up to it is reclaimed at once by release() when the GPU is done with it.
+class RingAllocator
+{
+public:
+    explicit RingAllocator(uint64_t capacity)
+        : capacity(capacity)
+    {
+    }
+
+    // alignment must be a power of two.
+    std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment)
+    {
+        if (!used)
+        {
+            head = tail = 0;
+        }
+        if (size > capacity || (used && head == tail))
+        {
+            return std::nullopt;
+        }
+
+        auto _offset { alignUp(head, alignment) };
+        uint64_t _consumed { };
+        if (head >= tail)
+        {
+            // Free space is [head, capacity) followed by [0, tail).
+            if (_offset + size <= capacity)
+            {
+                _consumed = _offset + size - head;
+            }
+            else if (size <= tail)
+            {
+                // Wrap around, the remainder up to capacity is wasted until the frame retires.
+                _consumed = capacity - head + size;
+                _offset = 0;
+            }
+            else
+            {
+                return std::nullopt;
+            }
+        }
+        else if (_offset + size <= tail)
+        {
+            _consumed = _offset + size - head;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+
+        head = _offset + size;
+        used += _consumed;
+        peak = used > peak ? used : peak;
+        return _offset;
+    }
+
+    // Closes the allocations made since the previous call under frame.
+    void endFrame(uint64_t frame)
+    {
+        if (frameCount == frames.size())
+        {
+            growFrames();
+        }
+        frames[(firstFrame + frameCount) % frames.size()] = { frame, head, used - closedBytes };
+        frameCount++;
+        closedBytes = used;
+    }
+
+    // Reclaims everything allocated in frames <= completedFrame.
+    void release(uint64_t completedFrame)
+    {
+        while (frameCount && frames[firstFrame].frame <= completedFrame)
+        {
+            const auto& _oldest { frames[firstFrame] };
+            // Empty frames carry no position, the ring may have been rewound since they closed.
+            if (_oldest.bytes)
+            {
+                tail = _oldest.end;
+            }
+            used -= _oldest.bytes;
+            closedBytes -= _oldest.bytes;
+            firstFrame = (firstFrame + 1) % frames.size();
+            frameCount--;
+        }
+    }
+
+    uint64_t size() const { return capacity; }
+    uint64_t usedBytes() const { return used; }
+    uint64_t peakBytes() const { return peak; }
+
+private:
+    static uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    struct FrameMarker
+    {
+        uint64_t frame  { };
+        uint64_t end    { };
+        uint64_t bytes  { };
+    };
+
+    // Markers live in a circular buffer that only grows, a deque would allocate and free a node
+    // every few frames.
+    void growFrames()
+    {
+        std::vector<FrameMarker> _grown(frames.empty() ? 4 : frames.size() * 2);
+        for (size_t i = 0; i < frameCount; i++)
+        {
+            _grown[i] = frames[(firstFrame + i) % frames.size()];
+        }
+        frames = std::move(_grown);
+        firstFrame = 0;
+    }
+
+    uint64_t capacity       { };
+    uint64_t head           { };
+    uint64_t tail           { };
+    uint64_t used           { };
+    uint64_t closedBytes    { };
+    uint64_t peak           { };
+    std::vector<FrameMarker> frames;
+    size_t firstFrame       { };
+    size_t frameCount       { };
+};
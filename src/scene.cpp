@@ -0,0 +1,270 @@
+#include "scene.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+
+#include "mesh_optimizer.hpp"
+
+namespace
+{
+    constexpr uint32_t TEXTURE_COUNT        { 8 };
+    constexpr uint32_t SPHERE_SEGMENTS      { 24 };
+    constexpr uint32_t SPHERE_RINGS         { 12 };
+    // Average distance between neighbouring instances.
+    constexpr float INSTANCE_SPACING        { 3.0f };
+    // Instances per cluster node, every SPIN_INTERVAL-th cluster spins at SPIN_SPEED radians per second.
+    constexpr uint32_t CLUSTER_SIZE         { 16 };
+    constexpr uint32_t SPIN_INTERVAL        { 8 };
+    constexpr float SPIN_SPEED              { 0.5f };
+
+    // Collects one mesh in full precision, finish() optimizes it and appends it to the scene.
+    struct MeshBuilder
+    {
+        SceneData& scene;
+        std::vector<MeshVertex> vertices;
+        std::vector<uint32_t> indices;
+
+        MeshBuilder(SceneData& scene)
+            : scene(scene)
+        {
+        }
+
+        uint32_t vertex(std::array<float, 3> position, std::array<float, 3> normal, float u, float v)
+        {
+            vertices.push_back({
+                .position = { position[0], position[1], position[2] },
+                .normal = { normal[0], normal[1], normal[2] },
+                .uv = { u, v }
+            });
+            return static_cast<uint32_t>(vertices.size()) - 1;
+        }
+
+        // Counter-clockwise seen from the front, matching the pipeline's front face.
+        void triangle(uint32_t a, uint32_t b, uint32_t c)
+        {
+            indices.insert(indices.end(), { a, b, c });
+        }
+
+        void finish()
+        {
+            auto _optimized { optimizeMesh(vertices, indices) };
+            const GpuMeshInfo _mesh {
+                .indexCount = static_cast<uint32_t>(_optimized.indices.size()),
+                .firstIndex = static_cast<uint32_t>(scene.indices.size()),
+                .vertexOffset = static_cast<int32_t>(scene.vertices.size()),
+                .radius = _optimized.radius,
+                .firstMeshlet = static_cast<uint32_t>(scene.meshlets.size()),
+                .meshletCount = static_cast<uint32_t>(_optimized.meshlets.size())
+            };
+            for (auto& meshlet : _optimized.meshlets)
+            {
+                meshlet.firstIndex += _mesh.firstIndex;
+            }
+            scene.vertices.insert(scene.vertices.end(), _optimized.vertices.begin(), _optimized.vertices.end());
+            scene.indices.insert(scene.indices.end(), _optimized.indices.begin(), _optimized.indices.end());
+            scene.meshlets.insert(scene.meshlets.end(), _optimized.meshlets.begin(), _optimized.meshlets.end());
+            scene.meshes.push_back(_mesh);
+            scene.meshBounds.push_back(_optimized.bounds);
+            scene.sourceGeometry += _optimized.before;
+            scene.geometry += _optimized.after;
+        }
+    };
+
+    void addCube(SceneData& scene)
+    {
+        MeshBuilder _builder { scene };
+        // Per face: normal, then two tangents with u x v == normal.
+        constexpr std::array<std::array<std::array<float, 3>, 3>, 6> FACES { {
+            { { { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } } },
+            { { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } } },
+            { { { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } } },
+            { { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } } },
+            { { { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } } },
+            { { { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1, 0 } } },
+        } };
+        for (const auto& [n, u, v] : FACES)
+        {
+            std::array<uint32_t, 4> _corners { };
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                const float _su { i == 1 || i == 2 ? 0.5f : -0.5f };
+                const float _sv { i >= 2 ? 0.5f : -0.5f };
+                _corners[i] = _builder.vertex({
+                    n[0] * 0.5f + u[0] * _su + v[0] * _sv,
+                    n[1] * 0.5f + u[1] * _su + v[1] * _sv,
+                    n[2] * 0.5f + u[2] * _su + v[2] * _sv
+                }, n, _su + 0.5f, _sv + 0.5f);
+            }
+            _builder.triangle(_corners[0], _corners[1], _corners[2]);
+            _builder.triangle(_corners[0], _corners[2], _corners[3]);
+        }
+        _builder.finish();
+    }
+
+    void addSphere(SceneData& scene)
+    {
+        MeshBuilder _builder { scene };
+        constexpr float PI { std::numbers::pi_v<float> };
+        for (uint32_t ring = 0; ring <= SPHERE_RINGS; ring++)
+        {
+            const float _theta { PI * static_cast<float>(ring) / SPHERE_RINGS };
+            for (uint32_t segment = 0; segment <= SPHERE_SEGMENTS; segment++)
+            {
+                const float _phi { 2.0f * PI * static_cast<float>(segment) / SPHERE_SEGMENTS };
+                const std::array<float, 3> _normal {
+                    std::sin(_theta) * std::cos(_phi), std::cos(_theta), -std::sin(_theta) * std::sin(_phi)
+                };
+                _builder.vertex({ _normal[0] * 0.5f, _normal[1] * 0.5f, _normal[2] * 0.5f }, _normal,
+                    static_cast<float>(segment) / SPHERE_SEGMENTS, static_cast<float>(ring) / SPHERE_RINGS);
+            }
+        }
+        constexpr uint32_t STRIDE { SPHERE_SEGMENTS + 1 };
+        for (uint32_t ring = 0; ring < SPHERE_RINGS; ring++)
+        {
+            for (uint32_t segment = 0; segment < SPHERE_SEGMENTS; segment++)
+            {
+                const uint32_t _a { ring * STRIDE + segment };
+                const uint32_t _b { _a + STRIDE };
+                _builder.triangle(_a, _b, _b + 1);
+                _builder.triangle(_a, _b + 1, _a + 1);
+            }
+        }
+        _builder.finish();
+    }
+
+    void addOctahedron(SceneData& scene)
+    {
+        MeshBuilder _builder { scene };
+        constexpr std::array<std::array<float, 3>, 6> CORNERS { {
+            { 0.5f, 0, 0 }, { -0.5f, 0, 0 }, { 0, 0.5f, 0 }, { 0, -0.5f, 0 }, { 0, 0, 0.5f }, { 0, 0, -0.5f }
+        } };
+        // Faces as (x, y, z) corner indices, flipped to keep the winding outward where the octant
+        // has an odd number of negative axes.
+        for (uint32_t octant = 0; octant < 8; octant++)
+        {
+            const uint32_t _x { octant & 1 ? 1u : 0u };
+            const uint32_t _y { octant & 2 ? 3u : 2u };
+            const uint32_t _z { octant & 4 ? 5u : 4u };
+            const float _sx { octant & 1 ? -1.0f : 1.0f };
+            const float _sy { octant & 2 ? -1.0f : 1.0f };
+            const float _sz { octant & 4 ? -1.0f : 1.0f };
+            const float _n { 1.0f / std::sqrt(3.0f) };
+            const std::array<float, 3> _normal { _sx * _n, _sy * _n, _sz * _n };
+            const auto _a { _builder.vertex(CORNERS[_x], _normal, 0.0f, 0.0f) };
+            const auto _b { _builder.vertex(CORNERS[_y], _normal, 1.0f, 0.0f) };
+            const auto _c { _builder.vertex(CORNERS[_z], _normal, 0.5f, 1.0f) };
+            if (_sx * _sy * _sz > 0)
+            {
+                _builder.triangle(_a, _b, _c);
+            }
+            else
+            {
+                _builder.triangle(_a, _c, _b);
+            }
+        }
+        _builder.finish();
+    }
+
+    SceneTexture makeCheckerTexture(uint32_t index, uint32_t size)
+    {
+        SceneTexture _texture { size, size, std::vector<std::byte>(size_t { size } * size * 4) };
+        const uint32_t _cells { 2u << (index % 4) };
+        const std::array<uint8_t, 3> _tint {
+            static_cast<uint8_t>(index & 1 ? 255 : 96),
+            static_cast<uint8_t>(index & 2 ? 255 : 96),
+            static_cast<uint8_t>(index & 4 ? 255 : 96)
+        };
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const bool _dark { ((x * _cells / size) + (y * _cells / size)) % 2 == 1 };
+                auto* _pixel { &_texture.pixels[(size_t { y } * size + x) * 4] };
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    _pixel[c] = static_cast<std::byte>(_dark ? _tint[c] / 3 : _tint[c]);
+                }
+                _pixel[3] = std::byte { 255 };
+            }
+        }
+        return _texture;
+    }
+}
+
+SceneData buildDemoScene(uint32_t instanceCount, uint32_t textureSize)
+{
+    SceneData _scene { };
+    addCube(_scene);
+    addSphere(_scene);
+    addOctahedron(_scene);
+    for (uint32_t i = 0; i < TEXTURE_COUNT; i++)
+    {
+        _scene.textures.push_back(makeCheckerTexture(i, textureSize));
+    }
+    placeDemoInstances(_scene, instanceCount, TEXTURE_COUNT);
+    return _scene;
+}
+
+void placeDemoInstances(SceneData& scene, uint32_t instanceCount, uint32_t textureCount)
+{
+    if (scene.meshBounds.empty() || textureCount == 0)
+    {
+        throw std::runtime_error("Failed to place instances, the scene has no meshes or textures!");
+    }
+    scene.halfExtent = 0.5f * INSTANCE_SPACING * std::cbrt(static_cast<float>(std::max(instanceCount, 1u)));
+    // Clusters hold CLUSTER_SIZE instances at the average spacing.
+    const float _clusterExtent { 0.5f * INSTANCE_SPACING * std::cbrt(static_cast<float>(CLUSTER_SIZE)) };
+    const float _rootExtent { std::max(scene.halfExtent - _clusterExtent, 0.0f) };
+    std::mt19937 _random { 1234 };
+    std::uniform_real_distribution<float> _rootPosition { -_rootExtent, _rootExtent };
+    std::uniform_real_distribution<float> _position { -_clusterExtent, _clusterExtent };
+    std::uniform_real_distribution<float> _unit { -1.0f, 1.0f };
+    std::uniform_real_distribution<float> _angle { 0.0f, 2.0f * std::numbers::pi_v<float> };
+    std::uniform_real_distribution<float> _scale { 0.4f, 1.2f };
+    std::uniform_real_distribution<float> _tint { 0.6f, 1.0f };
+    std::uniform_int_distribution<uint32_t> _mesh { 0, static_cast<uint32_t>(scene.meshBounds.size()) - 1 };
+    std::uniform_int_distribution<uint32_t> _texture { 0, textureCount - 1 };
+
+    // All roots first, then all instances: the graph wants its nodes level by level.
+    const uint32_t _clusterCount { (instanceCount + CLUSTER_SIZE - 1) / CLUSTER_SIZE };
+    for (uint32_t cluster = 0; cluster < _clusterCount; cluster++)
+    {
+        const glm::vec3 _origin { _rootPosition(_random), _rootPosition(_random), _rootPosition(_random) };
+        const auto _root { scene.graph.addNode(SceneGraph::NO_PARENT, _origin, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), 1.0f, { }) };
+        scene.instances.push_back({ .mesh = NO_MESH });
+        if (cluster % SPIN_INTERVAL == 0)
+        {
+            scene.animatedNodes.push_back(_root);
+        }
+    }
+    for (uint32_t i = 0; i < instanceCount; i++)
+    {
+        const glm::vec3 _offset { _position(_random), _position(_random), _position(_random) };
+        glm::vec3 _axis { _unit(_random), _unit(_random), _unit(_random) };
+        if (glm::dot(_axis, _axis) < 1e-4f)
+        {
+            _axis = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+        const auto _rotation { glm::angleAxis(_angle(_random), glm::normalize(_axis)) };
+        const GpuInstance _instance {
+            .color = { _tint(_random), _tint(_random), _tint(_random), 1.0f },
+            .mesh = _mesh(_random),
+            .texture = _texture(_random)
+        };
+        scene.graph.addNode(i / CLUSTER_SIZE, _offset, _rotation, _scale(_random), scene.meshBounds[_instance.mesh]);
+        scene.instances.push_back(_instance);
+    }
+}
+
+void animateDemoScene(SceneData& scene, float time)
+{
+    const auto _rotation { glm::angleAxis(time * SPIN_SPEED, glm::vec3(0.0f, 1.0f, 0.0f)) };
+    for (const auto node : scene.animatedNodes)
+    {
+        scene.graph.setRotation(node, _rotation);
+    }
+}
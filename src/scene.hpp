@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scene_graph.hpp"
+
+// CPU-side mirrors of the std430 structs in shaders/common.glsl, keep the two in sync.
+// Quantized by quantizeVertex() in mesh_optimizer.hpp, the vertex shader decodes it.
+struct GpuVertex
+{
+    // Half floats, the fourth is padding.
+    uint16_t position[4]    { };
+    // Octahedral unit normal, snorm16.
+    int16_t normal[2]       { };
+    // unorm16, UVs outside [0, 1] are clamped.
+    uint16_t uv[2]          { };
+};
+static_assert(sizeof(GpuVertex) == 16);
+
+// Static per-node data, the transform comes from the node's GpuTransform.
+struct GpuInstance
+{
+    float color[4]          { };
+    // NO_MESH for nodes that only carry a transform, the cull pass skips them.
+    uint32_t mesh           { };
+    uint32_t texture        { };
+    uint32_t padding[2]     { };
+};
+static_assert(sizeof(GpuInstance) == 32);
+
+constexpr uint32_t NO_MESH  { ~0u };
+
+struct GpuMeshInfo
+{
+    uint32_t indexCount     { };
+    uint32_t firstIndex     { };
+    int32_t vertexOffset    { };
+    // Bounding sphere around the mesh origin, in mesh units.
+    float radius            { };
+    // The mesh's indices are its meshlets' indices, in order.
+    uint32_t firstMeshlet   { };
+    uint32_t meshletCount   { };
+    uint32_t padding[2]     { };
+};
+static_assert(sizeof(GpuMeshInfo) == 32);
+
+// A cluster of at most MESHLET_MAX_TRIANGLES triangles of one mesh, culled on its own.
+struct GpuMeshlet
+{
+    // Bounding sphere in mesh units: xyz center, w radius.
+    float bounds[4]         { };
+    // Normal cone: xyz axis, w the sine of the widest angle between a triangle normal and the
+    // axis. A zero axis with w = 1 never culls.
+    float cone[4]           { };
+    // Range of the scene's index buffer.
+    uint32_t firstIndex     { };
+    uint32_t indexCount     { };
+    uint32_t padding[2]     { };
+};
+static_assert(sizeof(GpuMeshlet) == 48);
+
+// Geometry totals before or after optimizeMesh(), see reportGeometry().
+struct GeometryStats
+{
+    uint64_t vertices       { };
+    uint64_t triangles      { };
+    // Vertex shader runs with a simulated post-transform cache, per triangle this is the ACMR.
+    uint64_t cacheMisses    { };
+    uint64_t vertexBytes    { };
+    uint64_t meshlets       { };
+
+    GeometryStats& operator+=(const GeometryStats& other);
+};
+
+struct SceneTexture
+{
+    uint32_t width          { };
+    uint32_t height         { };
+    // Tightly packed R8G8B8A8_UNORM.
+    std::vector<std::byte> pixels;
+};
+
+// Everything the GPU-driven renderer draws: all meshes share one vertex and one index buffer, and
+// every graph node has one GpuInstance.
+struct SceneData
+{
+    std::vector<GpuVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<GpuMeshInfo> meshes;
+    std::vector<GpuMeshlet> meshlets;
+    // Mesh-space bounding box of every mesh.
+    std::vector<SceneGraph::Aabb> meshBounds;
+    SceneGraph graph;
+    std::vector<GpuInstance> instances;
+    std::vector<SceneTexture> textures;
+    // Instances are scattered through a cube of this half extent around the origin.
+    float halfExtent        { };
+    // Nodes animateDemoScene() moves.
+    std::vector<SceneGraph::NodeId> animatedNodes;
+    // The generated geometry before and after optimizeMesh(), empty for archived scenes.
+    GeometryStats sourceGeometry;
+    GeometryStats geometry;
+};
+
+// Deterministic demo scene: a few procedural meshes, run through optimizeMesh(), and square
+// textures of textureSize, instanceCount instances placed randomly with a fixed seed so runs stay
+// comparable. Instances are grouped into clusters under transform-only root nodes, some of which
+// animateDemoScene() spins.
+SceneData buildDemoScene(uint32_t instanceCount, uint32_t textureSize = 64);
+// The instance half of buildDemoScene(), for scenes whose meshes and textures come from an asset
+// archive: only scene.meshBounds has to be filled in.
+void placeDemoInstances(SceneData& scene, uint32_t instanceCount, uint32_t textureCount);
+// Poses the animated nodes for time seconds, SceneGraph::update() picks the changes up.
+void animateDemoScene(SceneData& scene, float time);
@@ -0,0 +1,140 @@
+#include "scene_archive.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    template<typename T>
+    std::span<const std::byte> asBytes(const std::vector<T>& data)
+    {
+        return std::as_bytes(std::span(data));
+    }
+
+    // Mesh bounds are stored as center xyz, extent xyz.
+    constexpr size_t MESH_BOUNDS_FLOATS { 6 };
+
+    // Element count of a buffer entry holding an array of T.
+    template<typename T>
+    size_t bufferElements(const AssetArchive& archive, const char* name)
+    {
+        const auto& _entry { archive.entry(name, AssetType::Buffer) };
+        if (_entry.size % sizeof(T) != 0)
+        {
+            throw std::runtime_error("Asset archive entry '" + std::string(name) + "' is not a whole number of elements!");
+        }
+        return _entry.size / sizeof(T);
+    }
+
+    // The cull pass and the draws trust the mesh table, so everything it points at has to be in
+    // the archive: meshlets, their index ranges inside their mesh's, and the vertex offset.
+    void validateMeshes(const AssetArchive& archive, std::span<const GpuMeshInfo> meshes)
+    {
+        const auto _vertexCount { bufferElements<GpuVertex>(archive, SCENE_VERTICES_ASSET) };
+        const auto _indexCount { bufferElements<uint32_t>(archive, SCENE_INDICES_ASSET) };
+        const auto _meshletCount { bufferElements<GpuMeshlet>(archive, SCENE_MESHLETS_ASSET) };
+        const auto _meshletData { archive.data(archive.entry(SCENE_MESHLETS_ASSET, AssetType::Buffer)) };
+        for (const auto& mesh : meshes)
+        {
+            if (uint64_t { mesh.firstIndex } + mesh.indexCount > _indexCount
+                || uint64_t { mesh.firstMeshlet } + mesh.meshletCount > _meshletCount
+                || mesh.vertexOffset < 0 || static_cast<uint64_t>(mesh.vertexOffset) > _vertexCount)
+            {
+                throw std::runtime_error("Asset archive mesh table is out of bounds!");
+            }
+            for (uint32_t i = 0; i < mesh.meshletCount; i++)
+            {
+                GpuMeshlet _meshlet { };
+                std::memcpy(&_meshlet, _meshletData.data() + (size_t { mesh.firstMeshlet } + i) * sizeof(_meshlet), sizeof(_meshlet));
+                if (_meshlet.firstIndex < mesh.firstIndex || _meshlet.indexCount % 3 != 0
+                    || uint64_t { _meshlet.firstIndex } + _meshlet.indexCount > uint64_t { mesh.firstIndex } + mesh.indexCount)
+                {
+                    throw std::runtime_error("Asset archive meshlet is outside its mesh!");
+                }
+            }
+        }
+    }
+}
+
+std::string sceneTextureAsset(uint32_t index)
+{
+    return "scene/texture" + std::to_string(index);
+}
+
+uint32_t sceneTextureCount(std::span<const ArchiveEntry> entries)
+{
+    uint32_t _count { };
+    while (std::any_of(entries.begin(), entries.end(),
+        [&](const auto& entry) { return entry.nameView() == sceneTextureAsset(_count); }))
+    {
+        _count++;
+    }
+    return _count;
+}
+
+void bakeSceneAssets(const SceneData& scene, bool compress, AssetArchiveWriter& writer)
+{
+    writer.addBuffer(SCENE_VERTICES_ASSET, asBytes(scene.vertices));
+    writer.addBuffer(SCENE_INDICES_ASSET, asBytes(scene.indices));
+    writer.addBuffer(SCENE_MESHES_ASSET, asBytes(scene.meshes));
+    writer.addBuffer(SCENE_MESHLETS_ASSET, asBytes(scene.meshlets));
+    std::vector<float> _bounds;
+    for (const auto& bounds : scene.meshBounds)
+    {
+        _bounds.insert(_bounds.end(), { bounds.center.x, bounds.center.y, bounds.center.z,
+            bounds.extent.x, bounds.extent.y, bounds.extent.z });
+    }
+    writer.addBuffer(SCENE_MESH_BOUNDS_ASSET, asBytes(_bounds));
+
+    for (uint32_t i = 0; i < scene.textures.size(); i++)
+    {
+        const auto& _texture { scene.textures[i] };
+        const auto _chain { buildMipChain(_texture.pixels, _texture.width, _texture.height) };
+        const auto _levels { mipLevelCount(_texture.width, _texture.height) };
+        if (!compress)
+        {
+            writer.addTexture(sceneTextureAsset(i), TextureEncoding::Rgba8, _texture.width, _texture.height, _levels, _chain);
+            continue;
+        }
+        std::vector<std::byte> _blocks(textureSize(TextureEncoding::Bc1, _texture.width, _texture.height, _levels));
+        for (uint32_t level = 0; level < _levels; level++)
+        {
+            const auto _source { std::span(_chain).subspan(
+                textureLevelOffset(TextureEncoding::Rgba8, _texture.width, _texture.height, level),
+                textureLevelSize(TextureEncoding::Rgba8, _texture.width, _texture.height, level)) };
+            const auto _target { std::span(_blocks).subspan(
+                textureLevelOffset(TextureEncoding::Bc1, _texture.width, _texture.height, level),
+                textureLevelSize(TextureEncoding::Bc1, _texture.width, _texture.height, level)) };
+            encodeBc1(_source, mipExtent(_texture.width, level), mipExtent(_texture.height, level), _target);
+        }
+        writer.addTexture(sceneTextureAsset(i), TextureEncoding::Bc1, _texture.width, _texture.height, _levels, _blocks);
+    }
+}
+
+uint32_t loadSceneLayout(const AssetArchive& archive, SceneData& scene)
+{
+    const auto _data { archive.data(archive.entry(SCENE_MESH_BOUNDS_ASSET, AssetType::Buffer)) };
+    const auto _meshData { archive.data(archive.entry(SCENE_MESHES_ASSET, AssetType::Buffer)) };
+    const auto _meshes { bufferElements<GpuMeshInfo>(archive, SCENE_MESHES_ASSET) };
+    if (_data.size() != _meshes * MESH_BOUNDS_FLOATS * sizeof(float))
+    {
+        throw std::runtime_error("Asset archive mesh bounds don't match its meshes!");
+    }
+    scene.meshes.resize(_meshes);
+    if (_meshes)
+    {
+        std::memcpy(scene.meshes.data(), _meshData.data(), _meshes * sizeof(GpuMeshInfo));
+    }
+    validateMeshes(archive, scene.meshes);
+    scene.meshBounds.resize(_meshes);
+    for (size_t i = 0; i < _meshes; i++)
+    {
+        std::array<float, MESH_BOUNDS_FLOATS> _bounds { };
+        std::memcpy(_bounds.data(), _data.data() + i * sizeof(_bounds), sizeof(_bounds));
+        scene.meshBounds[i] = { { _bounds[0], _bounds[1], _bounds[2] }, { _bounds[3], _bounds[4], _bounds[5] } };
+    }
+    return sceneTextureCount(archive.entries());
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "asset_archive.hpp"
+#include "scene.hpp"
+
+// Entry names of a scene's assets in an archive, textures are numbered from 0.
+constexpr const char* SCENE_VERTICES_ASSET = "scene/vertices";
+constexpr const char* SCENE_INDICES_ASSET = "scene/indices";
+constexpr const char* SCENE_MESHES_ASSET = "scene/meshes";
+constexpr const char* SCENE_MESH_BOUNDS_ASSET = "scene/mesh-bounds";
+constexpr const char* SCENE_MESHLETS_ASSET = "scene/meshlets";
+std::string sceneTextureAsset(uint32_t index);
+// Textures are numbered without gaps, this is the first missing index.
+uint32_t sceneTextureCount(std::span<const ArchiveEntry> entries);
+
+// Packs a scene's geometry and textures (with full mip chains, BC1 compressed when compress is
+// set) for loadSceneLayout() and the loaders in asset_streamer.hpp.
+void bakeSceneAssets(const SceneData& scene, bool compress, AssetArchiveWriter& writer);
+
+// Reads the mesh table and bounds of an archived scene into scene.meshes and scene.meshBounds,
+// enough to place instances and size the draws without touching the geometry. Throws
+// std::runtime_error when the table points outside the archive's meshlets, indices or vertices.
+// Returns the number of textures.
+uint32_t loadSceneLayout(const AssetArchive& archive, SceneData& scene);
@@ -0,0 +1,115 @@
+#include "scene_assets.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    template<typename T>
+    std::span<const std::byte> asBytes(const std::vector<T>& data)
+    {
+        return std::as_bytes(std::span(data));
+    }
+}
+
+GpuBuffer createSceneBuffer(GpuAllocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    return allocator.createBuffer(std::max<VkDeviceSize>(size, 4), usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        MemoryUsage::GpuOnly);
+}
+
+GpuTexture createSceneTexture(VkDevice device, GpuAllocator& allocator, VkFormat format, uint32_t width, uint32_t height,
+    uint32_t mipLevels)
+{
+    GpuTexture _texture { };
+    VkImageCreateInfo imageInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = format,
+        .extent = { width, height, 1 },
+        .mipLevels = mipLevels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+    };
+    _texture.image = allocator.createImage(imageInfo, MemoryUsage::GpuOnly);
+
+    VkImageViewCreateInfo viewInfo {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = _texture.image.image,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = format,
+        .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 }
+    };
+    if (vkCreateImageView(device, &viewInfo, nullptr, &_texture.view) != VK_SUCCESS)
+    {
+        allocator.destroyImage(_texture.image);
+        throw std::runtime_error("Failed to create texture image view!");
+    }
+    return _texture;
+}
+
+std::vector<VkBufferImageCopy> textureCopyRegions(TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t mipLevels)
+{
+    std::vector<VkBufferImageCopy> _regions;
+    for (uint32_t level = 0; level < mipLevels; level++)
+    {
+        _regions.push_back({
+            .bufferOffset = textureLevelOffset(encoding, width, height, level),
+            .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 },
+            .imageExtent = { mipExtent(width, level), mipExtent(height, level), 1 }
+        });
+    }
+    return _regions;
+}
+
+VkFormat textureFormat(TextureEncoding encoding)
+{
+    return encoding == TextureEncoding::Bc1 ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+GpuSceneAssets uploadSceneAssets(VkDevice device, GpuAllocator& allocator, StagingUploader& uploader, const SceneData& scene)
+{
+    GpuSceneAssets _assets { };
+    const auto _upload = [&](GpuBuffer& buffer, std::span<const std::byte> data, VkBufferUsageFlags usage) {
+        buffer = createSceneBuffer(allocator, data.size(), usage);
+        if (!data.empty())
+        {
+            _assets.uploadSerial = std::max(_assets.uploadSerial, uploader.uploadBuffer(buffer.buffer, 0, data));
+        }
+    };
+    _upload(_assets.vertices, asBytes(scene.vertices), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    _upload(_assets.indices, asBytes(scene.indices), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    _upload(_assets.meshes, asBytes(scene.meshes), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    _upload(_assets.meshlets, asBytes(scene.meshlets), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+    for (const auto& source : scene.textures)
+    {
+        auto& _texture { _assets.textures.emplace_back(createSceneTexture(device, allocator, VK_FORMAT_R8G8B8A8_UNORM,
+            source.width, source.height, 1)) };
+        const auto _regions { textureCopyRegions(TextureEncoding::Rgba8, source.width, source.height, 1) };
+        _assets.uploadSerial = std::max(_assets.uploadSerial, uploader.uploadImage(_texture.image.image,
+            { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }, _regions, source.pixels, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+    }
+    uploader.flush();
+    return _assets;
+}
+
+void destroySceneAssets(VkDevice device, GpuAllocator& allocator, GpuSceneAssets& assets)
+{
+    for (auto& texture : assets.textures)
+    {
+        vkDestroyImageView(device, texture.view, nullptr);
+        allocator.destroyImage(texture.image);
+    }
+    assets.textures.clear();
+    for (auto* buffer : { &assets.vertices, &assets.indices, &assets.meshes, &assets.meshlets })
+    {
+        allocator.destroyBuffer(*buffer);
+    }
+}
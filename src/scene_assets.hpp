@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "gpu_allocator.hpp"
+#include "scene.hpp"
+#include "staging_uploader.hpp"
+#include "texture_codec.hpp"
+
+struct GpuTexture
+{
+    GpuImage image;
+    VkImageView view            { };
+};
+
+// GPU copies of a scene's geometry and textures, usable once the uploader has acquired uploadSerial.
+struct GpuSceneAssets
+{
+    GpuBuffer vertices;
+    GpuBuffer indices;
+    GpuBuffer meshes;
+    GpuBuffer meshlets;
+    std::vector<GpuTexture> textures;
+    uint64_t uploadSerial       { };
+};
+
+// Creates the (empty) buffers and images of a scene, loaders fill them through the uploader.
+GpuBuffer createSceneBuffer(GpuAllocator& allocator, VkDeviceSize size, VkBufferUsageFlags usage);
+GpuTexture createSceneTexture(VkDevice device, GpuAllocator& allocator, VkFormat format, uint32_t width, uint32_t height,
+    uint32_t mipLevels);
+// One copy region per mip level of a texture stored as described by texture_codec.hpp.
+std::vector<VkBufferImageCopy> textureCopyRegions(TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t mipLevels);
+VkFormat textureFormat(TextureEncoding encoding);
+
+// Uploads the geometry and textures buildDemoScene() generated in memory.
+GpuSceneAssets uploadSceneAssets(VkDevice device, GpuAllocator& allocator, StagingUploader& uploader, const SceneData& scene);
+void destroySceneAssets(VkDevice device, GpuAllocator& allocator, GpuSceneAssets& assets);
@@ -0,0 +1,328 @@
+#include "scene_graph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // The update kernel is written once against these lane types: ScalarLanes handles one node,
+    // the SIMD ones a batch of consecutive nodes per instruction.
+    struct ScalarLanes
+    {
+        static constexpr uint32_t WIDTH { 1 };
+        float value;
+
+        static ScalarLanes load(const float* source) { return { *source }; }
+        static ScalarLanes splat(float value) { return { value }; }
+        static ScalarLanes gather(const float* base, const uint32_t* indices) { return { base[indices[0]] }; }
+        void store(float* target) const { *target = value; }
+
+        friend ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return { a.value + b.value }; }
+        friend ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return { a.value - b.value }; }
+        friend ScalarLanes operator*(ScalarLanes a, ScalarLanes b) { return { a.value * b.value }; }
+        friend ScalarLanes abs(ScalarLanes a) { return { std::fabs(a.value) }; }
+    };
+
+#if defined(__SSE__) || defined(_M_X64)
+    struct SseLanes
+    {
+        static constexpr uint32_t WIDTH { 4 };
+        __m128 value;
+
+        static SseLanes load(const float* source) { return { _mm_loadu_ps(source) }; }
+        static SseLanes splat(float value) { return { _mm_set1_ps(value) }; }
+        static SseLanes gather(const float* base, const uint32_t* indices)
+        {
+            return { _mm_setr_ps(base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]]) };
+        }
+        void store(float* target) const { _mm_storeu_ps(target, value); }
+
+        friend SseLanes operator+(SseLanes a, SseLanes b) { return { _mm_add_ps(a.value, b.value) }; }
+        friend SseLanes operator-(SseLanes a, SseLanes b) { return { _mm_sub_ps(a.value, b.value) }; }
+        friend SseLanes operator*(SseLanes a, SseLanes b) { return { _mm_mul_ps(a.value, b.value) }; }
+        friend SseLanes abs(SseLanes a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.value) }; }
+    };
+#endif
+
+#if defined(__AVX__)
+    struct AvxLanes
+    {
+        static constexpr uint32_t WIDTH { 8 };
+        __m256 value;
+
+        static AvxLanes load(const float* source) { return { _mm256_loadu_ps(source) }; }
+        static AvxLanes splat(float value) { return { _mm256_set1_ps(value) }; }
+        static AvxLanes gather(const float* base, const uint32_t* indices)
+        {
+            return { _mm256_setr_ps(base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]],
+                base[indices[4]], base[indices[5]], base[indices[6]], base[indices[7]]) };
+        }
+        void store(float* target) const { _mm256_storeu_ps(target, value); }
+
+        friend AvxLanes operator+(AvxLanes a, AvxLanes b) { return { _mm256_add_ps(a.value, b.value) }; }
+        friend AvxLanes operator-(AvxLanes a, AvxLanes b) { return { _mm256_sub_ps(a.value, b.value) }; }
+        friend AvxLanes operator*(AvxLanes a, AvxLanes b) { return { _mm256_mul_ps(a.value, b.value) }; }
+        friend AvxLanes abs(AvxLanes a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.value) }; }
+    };
+    using BatchLanes = AvxLanes;
+#elif defined(__SSE__) || defined(_M_X64)
+    using BatchLanes = SseLanes;
+#else
+    using BatchLanes = ScalarLanes;
+#endif
+}
+
+SceneGraph::NodeId SceneGraph::addNode(NodeId parent, const glm::vec3& position, const glm::quat& rotation, float scale,
+    const Aabb& bounds)
+{
+    const NodeId _node { size() };
+    if (parent == NO_PARENT)
+    {
+        if (levelStarts.size() > 1)
+        {
+            throw std::runtime_error("Scene graph roots must be added before any child!");
+        }
+        if (levelStarts.empty())
+        {
+            levelStarts.push_back(0);
+        }
+    }
+    else
+    {
+        if (parent >= _node)
+        {
+            throw std::runtime_error("Scene graph parent must be added before its children!");
+        }
+        // The parent's level has to be the last one (a new level starts) or the one before it.
+        const auto _parentLevel { static_cast<size_t>(std::upper_bound(levelStarts.begin(), levelStarts.end(), parent)
+            - levelStarts.begin()) - 1 };
+        if (_parentLevel + 1 == levelStarts.size())
+        {
+            levelStarts.push_back(_node);
+        }
+        else if (_parentLevel + 2 != levelStarts.size())
+        {
+            throw std::runtime_error("Scene graph nodes must be added level by level!");
+        }
+    }
+
+    parents.push_back(parent);
+    for (int i = 0; i < 3; i++)
+    {
+        positions[i].push_back(position[i]);
+        localCenters[i].push_back(bounds.center[i]);
+        localExtents[i].push_back(bounds.extent[i]);
+        worldCenters[i].push_back(0.0f);
+        worldExtents[i].push_back(0.0f);
+    }
+    rotations[0].push_back(rotation.x);
+    rotations[1].push_back(rotation.y);
+    rotations[2].push_back(rotation.z);
+    rotations[3].push_back(rotation.w);
+    scales.push_back(scale);
+    for (auto& element : world)
+    {
+        element.push_back(0.0f);
+    }
+    dirty.push_back(1);
+    return _node;
+}
+
+void SceneGraph::setPosition(NodeId node, const glm::vec3& position)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        positions[i][node] = position[i];
+    }
+    dirty[node] = 1;
+}
+
+void SceneGraph::setRotation(NodeId node, const glm::quat& rotation)
+{
+    rotations[0][node] = rotation.x;
+    rotations[1][node] = rotation.y;
+    rotations[2][node] = rotation.z;
+    rotations[3][node] = rotation.w;
+    dirty[node] = 1;
+}
+
+void SceneGraph::setScale(NodeId node, float scale)
+{
+    scales[node] = scale;
+    dirty[node] = 1;
+}
+
+// Computes Lanes::WIDTH consecutive nodes starting at first, all on the same level: local matrix
+// from the quaternion, scale and position, world = parent world * local, then the world AABB with
+// Arvo's method (center transformed, extent through the absolute matrix).
+template<typename Lanes>
+void SceneGraph::updateLanes(uint32_t first, bool hasParent)
+{
+    const auto _load = [first](const std::vector<float>& source) { return Lanes::load(source.data() + first); };
+    const auto _one { Lanes::splat(1.0f) };
+    const auto _two { Lanes::splat(2.0f) };
+
+    const auto _qx { _load(rotations[0]) };
+    const auto _qy { _load(rotations[1]) };
+    const auto _qz { _load(rotations[2]) };
+    const auto _qw { _load(rotations[3]) };
+    const auto _scale { _load(scales) };
+    const auto _xx { _qx * _qx };
+    const auto _yy { _qy * _qy };
+    const auto _zz { _qz * _qz };
+    const auto _xy { _qx * _qy };
+    const auto _xz { _qx * _qz };
+    const auto _yz { _qy * _qz };
+    const auto _wx { _qw * _qx };
+    const auto _wy { _qw * _qy };
+    const auto _wz { _qw * _qz };
+    const std::array<Lanes, 12> _local {
+        (_one - _two * (_yy + _zz)) * _scale, _two * (_xy - _wz) * _scale, _two * (_xz + _wy) * _scale, _load(positions[0]),
+        _two * (_xy + _wz) * _scale, (_one - _two * (_xx + _zz)) * _scale, _two * (_yz - _wx) * _scale, _load(positions[1]),
+        _two * (_xz - _wy) * _scale, _two * (_yz + _wx) * _scale, (_one - _two * (_xx + _yy)) * _scale, _load(positions[2])
+    };
+
+    auto _world { _local };
+    if (hasParent)
+    {
+        const auto* _parents { parents.data() + first };
+        for (uint32_t r = 0; r < 3; r++)
+        {
+            const auto _p0 { Lanes::gather(world[r * 4 + 0].data(), _parents) };
+            const auto _p1 { Lanes::gather(world[r * 4 + 1].data(), _parents) };
+            const auto _p2 { Lanes::gather(world[r * 4 + 2].data(), _parents) };
+            const auto _p3 { Lanes::gather(world[r * 4 + 3].data(), _parents) };
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                _world[r * 4 + c] = _p0 * _local[c] + _p1 * _local[4 + c] + _p2 * _local[8 + c];
+            }
+            _world[r * 4 + 3] = _world[r * 4 + 3] + _p3;
+        }
+    }
+    for (uint32_t i = 0; i < _world.size(); i++)
+    {
+        _world[i].store(world[i].data() + first);
+    }
+
+    const auto _cx { _load(localCenters[0]) };
+    const auto _cy { _load(localCenters[1]) };
+    const auto _cz { _load(localCenters[2]) };
+    const auto _ex { _load(localExtents[0]) };
+    const auto _ey { _load(localExtents[1]) };
+    const auto _ez { _load(localExtents[2]) };
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        const auto* _row { &_world[r * 4] };
+        (_row[0] * _cx + _row[1] * _cy + _row[2] * _cz + _row[3]).store(worldCenters[r].data() + first);
+        (abs(_row[0]) * _ex + abs(_row[1]) * _ey + abs(_row[2]) * _ez).store(worldExtents[r].data() + first);
+    }
+}
+
+uint32_t SceneGraph::update()
+{
+    changed.clear();
+    for (size_t level = 0; level < levelStarts.size(); level++)
+    {
+        const uint32_t _begin { levelStarts[level] };
+        const uint32_t _end { level + 1 < levelStarts.size() ? levelStarts[level + 1] : size() };
+        const bool _hasParent { level > 0 };
+        if (_hasParent)
+        {
+            for (uint32_t i = _begin; i < _end; i++)
+            {
+                dirty[i] |= dirty[parents[i]];
+            }
+        }
+
+        // A batch is recomputed as soon as one of its nodes is dirty, the clean ones are rewritten
+        // with the values they already had.
+        uint32_t _node { _begin };
+        for (; _node + BatchLanes::WIDTH <= _end; _node += BatchLanes::WIDTH)
+        {
+            const auto _flags { dirty.begin() + _node };
+            if (std::any_of(_flags, _flags + BatchLanes::WIDTH, [](uint8_t flag) { return flag != 0; }))
+            {
+                updateLanes<BatchLanes>(_node, _hasParent);
+            }
+        }
+        for (; _node < _end; _node++)
+        {
+            if (dirty[_node])
+            {
+                updateLanes<ScalarLanes>(_node, _hasParent);
+            }
+        }
+
+        for (uint32_t i = _begin; i < _end; i++)
+        {
+            if (dirty[i])
+            {
+                changed.push_back(i);
+            }
+        }
+    }
+    // Children read their parent's flag, so flags are only cleared once every level is done.
+    for (const auto node : changed)
+    {
+        dirty[node] = 0;
+    }
+    return static_cast<uint32_t>(changed.size());
+}
+
+GpuTransform SceneGraph::gpuTransform(NodeId node) const
+{
+    GpuTransform _transform { };
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            _transform.rows[r][c] = world[r * 4 + c][node];
+        }
+        _transform.bounds[r] = worldCenters[r][node];
+    }
+    _transform.bounds[3] = std::hypot(worldExtents[0][node], worldExtents[1][node], worldExtents[2][node]);
+    return _transform;
+}
+
+void SceneGraph::writeTransforms(std::span<GpuTransform> out, std::span<const NodeId> nodes) const
+{
+    // Whole structs only, out is usually write-combined memory.
+    for (const auto node : nodes)
+    {
+        out[node] = gpuTransform(node);
+    }
+}
+
+void SceneGraph::writeTransforms(std::span<GpuTransform> out) const
+{
+    for (NodeId node = 0; node < size(); node++)
+    {
+        out[node] = gpuTransform(node);
+    }
+}
+
+glm::mat4 SceneGraph::worldMatrix(NodeId node) const
+{
+    glm::mat4 _matrix { 1.0f };
+    for (int r = 0; r < 3; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            _matrix[c][r] = world[r * 4 + c][node];
+        }
+    }
+    return _matrix;
+}
+
+SceneGraph::Aabb SceneGraph::worldBounds(NodeId node) const
+{
+    return {
+        { worldCenters[0][node], worldCenters[1][node], worldCenters[2][node] },
+        { worldExtents[0][node], worldExtents[1][node], worldExtents[2][node] }
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Per-node world transform as the shaders read it, mirrors Transform in shaders/common.glsl.
+struct GpuTransform
+{
+    // Rows of the 3x4 world matrix: xyz of each row are the rotation/scale, w the translation.
+    float rows[3][4]        { };
+    // World bounding sphere around the node's world AABB: xyz center, w radius.
+    float bounds[4]         { };
+};
+static_assert(sizeof(GpuTransform) == 64);
+
+// Transform hierarchy stored as a structure of arrays: every component of every node lives in its
+// own contiguous array, so update() streams through memory and transforms four nodes per SSE
+// instruction instead of one glm::mat4 per object. Nodes must be added parents first and level by
+// level (every node one level deeper than its parent, levels never interleaved), which keeps each
+// level a contiguous range whose parents are all final before it is processed.
+//
+// Setters only flag a node dirty, update() then recomputes dirty nodes and their descendants and
+// records which nodes changed so writeTransforms() uploads just those.
+class SceneGraph
+{
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId NO_PARENT { ~0u };
+
+    // Axis-aligned box in node-local space.
+    struct Aabb
+    {
+        glm::vec3 center    { 0.0f };
+        glm::vec3 extent    { 0.0f };
+    };
+
+    NodeId addNode(NodeId parent, const glm::vec3& position, const glm::quat& rotation, float scale, const Aabb& bounds);
+
+    void setPosition(NodeId node, const glm::vec3& position);
+    void setRotation(NodeId node, const glm::quat& rotation);
+    void setScale(NodeId node, float scale);
+
+    // Recomputes world matrices and bounds of every dirty node and its descendants, returns how
+    // many nodes changed.
+    uint32_t update();
+    // Nodes update() recomputed, in ascending order.
+    std::span<const NodeId> changedNodes() const { return changed; }
+
+    // Copies the given nodes' transforms into out (indexed by node), typically a mapped buffer.
+    void writeTransforms(std::span<GpuTransform> out, std::span<const NodeId> nodes) const;
+    void writeTransforms(std::span<GpuTransform> out) const;
+    GpuTransform gpuTransform(NodeId node) const;
+
+    uint32_t size() const { return static_cast<uint32_t>(parents.size()); }
+    glm::mat4 worldMatrix(NodeId node) const;
+    Aabb worldBounds(NodeId node) const;
+
+private:
+    // One array per component, e.g. positions[1][node] is the node's local y.
+    template<size_t N>
+    using Components = std::array<std::vector<float>, N>;
+
+    template<typename Lanes>
+    void updateLanes(uint32_t first, bool hasParent);
+
+    std::vector<NodeId> parents;
+    // First node of every level, level 0 being the roots.
+    std::vector<uint32_t> levelStarts;
+
+    Components<3> positions;
+    Components<4> rotations;    // x, y, z, w
+    std::vector<float> scales;
+    Components<3> localCenters;
+    Components<3> localExtents;
+
+    // Row-major 3x4 world matrices, element r * 4 + c in its own array.
+    Components<12> world;
+    Components<3> worldCenters;
+    Components<3> worldExtents;
+
+    std::vector<uint8_t> dirty;
+    std::vector<NodeId> changed;
+};
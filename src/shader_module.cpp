@@ -0,0 +1,93 @@
+#include "shader_module.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "vulkan_dispatch.hpp"
+
+VkShaderModule createShaderModule(VkDevice device, const EmbeddedShader& shader)
+{
+    VkShaderModuleCreateInfo createInfo {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = shader.code.size_bytes(),
+        .pCode = shader.code.data()
+    };
+    VkShaderModule _module { };
+    if (vkCreateShaderModule(device, &createInfo, nullptr, &_module) != VK_SUCCESS)
+    {
+        throw std::runtime_error(std::string("Failed to create shader module ") + shader.name + "!");
+    }
+    return _module;
+}
+
+VkDescriptorSetLayout createShaderSetLayout(VkDevice device, std::span<const EmbeddedShader* const> shaders, uint32_t set)
+{
+    std::vector<VkDescriptorSetLayoutBinding> _bindings;
+    for (const auto* shader : shaders)
+    {
+        for (const auto& binding : shader->bindings)
+        {
+            if (binding.set != set)
+            {
+                continue;
+            }
+            if (!binding.count)
+            {
+                throw std::runtime_error(std::string("Shader ") + shader->name + " has a runtime-sized array in set "
+                    + std::to_string(set) + "!");
+            }
+            const auto _existing { std::find_if(_bindings.begin(), _bindings.end(),
+                [&](const auto& other) { return other.binding == binding.binding; }) };
+            if (_existing == _bindings.end())
+            {
+                _bindings.push_back({
+                    .binding = binding.binding,
+                    .descriptorType = binding.type,
+                    .descriptorCount = binding.count,
+                    .stageFlags = static_cast<VkShaderStageFlags>(shader->stage)
+                });
+            }
+            else if (_existing->descriptorType != binding.type || _existing->descriptorCount != binding.count)
+            {
+                throw std::runtime_error(std::string("Shader ") + shader->name + " disagrees on set " + std::to_string(set)
+                    + " binding " + std::to_string(binding.binding) + "!");
+            }
+            else
+            {
+                _existing->stageFlags |= shader->stage;
+            }
+        }
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = static_cast<uint32_t>(_bindings.size()),
+        .pBindings = _bindings.data()
+    };
+    VkDescriptorSetLayout _layout { };
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create reflected descriptor set layout!");
+    }
+    return _layout;
+}
+
+VkPipelineLayout createShaderPipelineLayout(VkDevice device, std::span<const EmbeddedShader* const> shaders,
+    std::span<const VkDescriptorSetLayout> setLayouts)
+{
+    const auto _pushConstants { shaderPushConstants(shaders) };
+    VkPipelineLayoutCreateInfo layoutInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+        .pSetLayouts = setLayouts.data(),
+        .pushConstantRangeCount = _pushConstants.size ? 1u : 0u,
+        .pPushConstantRanges = &_pushConstants
+    };
+    VkPipelineLayout _layout { };
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &_layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create reflected pipeline layout!");
+    }
+    return _layout;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <vulkan/vulkan.h>
+
+// Reflection of an embedded shader, generated at build time by tools/shader_embed.cpp into
+// embedded_shaders.hpp. Everything is constexpr, so layouts can be checked with static_assert.
+struct ShaderBinding
+{
+    uint32_t set                { };
+    uint32_t binding            { };
+    VkDescriptorType type       { };
+    // Array size, 0 for runtime-sized (bindless) arrays.
+    uint32_t count              { };
+};
+
+struct ShaderSpecConstant
+{
+    uint32_t id                 { };
+    const char* name            { };
+    // In bytes, booleans are 4 like VkBool32.
+    uint32_t size               { };
+    uint64_t defaultValue       { };
+};
+
+struct EmbeddedShader
+{
+    const char* name            { };
+    VkShaderStageFlagBits stage { };
+    std::span<const uint32_t> code;
+    std::span<const ShaderBinding> bindings;
+    // 0 when the shader has no push constant block.
+    uint32_t pushConstantSize   { };
+    std::span<const ShaderSpecConstant> specConstants;
+    std::array<uint32_t, 3> localSize { };
+};
+
+// Push constant range covering every stage of shaders that declares a push constant block, the
+// stage flags are what vkCmdPushConstants must be called with.
+constexpr VkPushConstantRange shaderPushConstants(std::span<const EmbeddedShader* const> shaders)
+{
+    VkPushConstantRange _range { };
+    for (const auto* shader : shaders)
+    {
+        if (shader->pushConstantSize)
+        {
+            _range.stageFlags |= shader->stage;
+            _range.size = std::max(_range.size, shader->pushConstantSize);
+        }
+    }
+    return _range;
+}
+
+// True when every binding of shader exists in layout with the same type and room for its array.
+constexpr bool shaderBindingsMatch(const EmbeddedShader& shader, std::span<const ShaderBinding> layout)
+{
+    return std::all_of(shader.bindings.begin(), shader.bindings.end(), [&](const ShaderBinding& binding) {
+        return std::any_of(layout.begin(), layout.end(), [&](const ShaderBinding& available) {
+            return available.set == binding.set && available.binding == binding.binding && available.type == binding.type
+                && (!available.count || (binding.count && binding.count <= available.count));
+        });
+    });
+}
+
+VkShaderModule createShaderModule(VkDevice device, const EmbeddedShader& shader);
+
+// Descriptor set layout of one set from the union of the shaders' bindings, each visible to the
+// stages that declare it. Runtime-sized arrays have no count to create a layout from, sets using
+// them (the bindless one) are created by hand and checked with shaderBindingsMatch().
+VkDescriptorSetLayout createShaderSetLayout(VkDevice device, std::span<const EmbeddedShader* const> shaders, uint32_t set);
+
+// Pipeline layout with setLayouts and the shaders' push constant range.
+VkPipelineLayout createShaderPipelineLayout(VkDevice device, std::span<const EmbeddedShader* const> shaders,
+    std::span<const VkDescriptorSetLayout> setLayouts);
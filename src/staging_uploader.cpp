@@ -0,0 +1,368 @@
+#include "staging_uploader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "vulkan_dispatch.hpp"
+
+namespace
+{
+    constexpr size_t BATCH_COUNT                { 8 };
+    // Covers texel sizes up to 16 bytes and every compressed block size.
+    constexpr VkDeviceSize STAGING_ALIGNMENT    { 16 };
+}
+
+StagingUploader::StagingUploader(VkDevice device, GpuAllocator& allocator, uint32_t transferFamily, VkQueue transferQueue,
+    uint32_t graphicsFamily, VkDeviceSize stagingSize)
+    : device(device), allocator(allocator), transferFamily(transferFamily), transferQueue(transferQueue),
+    graphicsFamily(graphicsFamily), stagingRing(stagingSize)
+{
+    stagingBuffer = allocator.createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::Upload);
+
+    batches.resize(BATCH_COUNT);
+    for (auto& batch : batches)
+    {
+        VkCommandPoolCreateInfo poolInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = transferFamily
+        };
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &batch.pool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create transfer command pool!");
+        }
+        VkCommandBufferAllocateInfo allocInfo {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = batch.pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1
+        };
+        if (vkAllocateCommandBuffers(device, &allocInfo, &batch.commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate transfer command buffer!");
+        }
+        VkFenceCreateInfo fenceInfo { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+        if (vkCreateFence(device, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create transfer fence!");
+        }
+    }
+}
+
+StagingUploader::~StagingUploader()
+{
+    for (auto& batch : batches)
+    {
+        if (batch.submitted)
+        {
+            vkWaitForFences(device, 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+        vkDestroyFence(device, batch.fence, nullptr);
+        vkDestroyCommandPool(device, batch.pool, nullptr);
+    }
+    allocator.destroyBuffer(stagingBuffer);
+}
+
+StagingUploader::Batch& StagingUploader::recordingBatch()
+{
+    auto* _batch { &batches[currentBatch] };
+    if (_batch->recording)
+    {
+        return *_batch;
+    }
+    if (_batch->submitted)
+    {
+        vkWaitForFences(device, 1, &_batch->fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        collect();
+    }
+
+    vkResetCommandPool(device, _batch->pool, 0);
+    VkCommandBufferBeginInfo beginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+    if (vkBeginCommandBuffer(_batch->commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin transfer command buffer!");
+    }
+    _batch->serial = nextSerial++;
+    _batch->recording = true;
+    return *_batch;
+}
+
+std::byte* StagingUploader::allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, bool mayFlush)
+{
+    while (true)
+    {
+        if (const auto _offset { stagingRing.allocate(size, alignment) })
+        {
+            offset = *_offset;
+            return static_cast<std::byte*>(stagingBuffer.allocation.mapped) + offset;
+        }
+        // Ring is full: push out what we have and wait for the oldest batch to free its space.
+        if (batches[currentBatch].recording)
+        {
+            if (!mayFlush)
+            {
+                return nullptr;
+            }
+            flush();
+        }
+        if (std::none_of(batches.begin(), batches.end(), [](const auto& batch) { return batch.submitted; }))
+        {
+            throw std::runtime_error("Upload does not fit the staging ring!");
+        }
+        waitOldest();
+    }
+}
+
+uint64_t StagingUploader::recordBufferCopy(VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize stagingOffset, VkDeviceSize size)
+{
+    auto& _batch { recordingBatch() };
+    const VkBufferCopy _region { stagingOffset, dstOffset, size };
+    vkCmdCopyBuffer(_batch.commandBuffer, stagingBuffer.buffer, dst, 1, &_region);
+    _batch.bufferReleases.push_back(VkBufferMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = 0,
+        .srcQueueFamilyIndex = transferFamily,
+        .dstQueueFamilyIndex = graphicsFamily,
+        .buffer = dst,
+        .offset = dstOffset,
+        .size = size
+    });
+    uploadedBytes += size;
+    return _batch.serial;
+}
+
+uint64_t StagingUploader::recordImageCopy(VkImage dst, const VkImageSubresourceRange& range,
+    std::span<const VkBufferImageCopy> regions, VkDeviceSize stagingOffset, VkDeviceSize size, VkImageLayout finalLayout)
+{
+    auto& _batch { recordingBatch() };
+    VkImageMemoryBarrier toTransferDst {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = dst,
+        .subresourceRange = range
+    };
+    vkCmdPipelineBarrier(_batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &toTransferDst);
+
+    std::vector<VkBufferImageCopy> _regions(regions.begin(), regions.end());
+    for (auto& region : _regions)
+    {
+        region.bufferOffset += stagingOffset;
+    }
+    vkCmdCopyBufferToImage(_batch.commandBuffer, stagingBuffer.buffer, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(_regions.size()), _regions.data());
+
+    // The release barrier also performs the layout transition, the acquire repeats it verbatim.
+    _batch.imageReleases.push_back(VkImageMemoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = 0,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = finalLayout,
+        .srcQueueFamilyIndex = usesDedicatedQueue() ? transferFamily : VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = usesDedicatedQueue() ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED,
+        .image = dst,
+        .subresourceRange = range
+    });
+    uploadedBytes += size;
+    return _batch.serial;
+}
+
+uint64_t StagingUploader::uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, std::span<const std::byte> data)
+{
+    // Keep pieces well below the ring size so one big upload can't monopolise it.
+    const auto _maxPiece { std::max<VkDeviceSize>(stagingRing.size() / 4, STAGING_ALIGNMENT) };
+    uint64_t _serial { };
+    VkDeviceSize _done { };
+    while (_done < data.size())
+    {
+        const auto _size { std::min<VkDeviceSize>(data.size() - _done, _maxPiece) };
+        VkDeviceSize _stagingOffset { };
+        auto* _staging { allocateStaging(_size, STAGING_ALIGNMENT, _stagingOffset) };
+        std::memcpy(_staging, data.data() + _done, _size);
+        _serial = recordBufferCopy(dst, dstOffset + _done, _stagingOffset, _size);
+        _done += _size;
+    }
+    return _serial;
+}
+
+uint64_t StagingUploader::uploadImage(VkImage dst, const VkImageSubresourceRange& range, std::span<const VkBufferImageCopy> regions,
+    std::span<const std::byte> data, VkImageLayout finalLayout)
+{
+    VkDeviceSize _stagingOffset { };
+    auto* _staging { allocateStaging(data.size(), STAGING_ALIGNMENT, _stagingOffset) };
+    std::memcpy(_staging, data.data(), data.size());
+    return recordImageCopy(dst, range, regions, _stagingOffset, data.size(), finalLayout);
+}
+
+std::optional<StagingReservation> StagingUploader::reserveBuffer(VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size)
+{
+    VkDeviceSize _stagingOffset { };
+    auto* _staging { allocateStaging(size, STAGING_ALIGNMENT, _stagingOffset, false) };
+    if (!_staging)
+    {
+        return std::nullopt;
+    }
+    return StagingReservation { { _staging, size }, recordBufferCopy(dst, dstOffset, _stagingOffset, size) };
+}
+
+std::optional<StagingReservation> StagingUploader::reserveImage(VkImage dst, const VkImageSubresourceRange& range,
+    std::span<const VkBufferImageCopy> regions, VkDeviceSize size, VkImageLayout finalLayout)
+{
+    VkDeviceSize _stagingOffset { };
+    auto* _staging { allocateStaging(size, STAGING_ALIGNMENT, _stagingOffset, false) };
+    if (!_staging)
+    {
+        return std::nullopt;
+    }
+    return StagingReservation { { _staging, size }, recordImageCopy(dst, range, regions, _stagingOffset, size, finalLayout) };
+}
+
+void StagingUploader::flush()
+{
+    auto& _batch { batches[currentBatch] };
+    if (!_batch.recording)
+    {
+        return;
+    }
+
+    // Buffers only need the release half when they actually change queue family.
+    const auto _bufferReleases { usesDedicatedQueue() ? static_cast<uint32_t>(_batch.bufferReleases.size()) : 0u };
+    vkCmdPipelineBarrier(_batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+        0, nullptr, _bufferReleases, _batch.bufferReleases.data(),
+        static_cast<uint32_t>(_batch.imageReleases.size()), _batch.imageReleases.data());
+    if (vkEndCommandBuffer(_batch.commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record transfer command buffer!");
+    }
+
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &_batch.commandBuffer
+    };
+    vkResetFences(device, 1, &_batch.fence);
+    if (vkQueueSubmit(transferQueue, 1, &submitInfo, _batch.fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit transfer batch!");
+    }
+    stagingRing.endFrame(_batch.serial);
+    _batch.recording = false;
+    _batch.submitted = true;
+    currentBatch = (currentBatch + 1) % batches.size();
+}
+
+void StagingUploader::retire(Batch& batch)
+{
+    // Batches complete in submission order on the single transfer queue.
+    stagingRing.release(batch.serial);
+    completed = batch.serial;
+    pendingAcquireSerial = batch.serial;
+
+    for (auto barrier : batch.bufferReleases)
+    {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        pendingBufferAcquires.push_back(barrier);
+    }
+    for (auto barrier : batch.imageReleases)
+    {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        pendingImageAcquires.push_back(barrier);
+    }
+    batch.bufferReleases.clear();
+    batch.imageReleases.clear();
+    batch.submitted = false;
+}
+
+void StagingUploader::collect()
+{
+    // Walk from the oldest submitted batch and stop at the first one still running.
+    for (size_t i = 0; i < batches.size(); i++)
+    {
+        auto& _batch { batches[(currentBatch + i) % batches.size()] };
+        if (!_batch.submitted)
+        {
+            continue;
+        }
+        if (vkGetFenceStatus(device, _batch.fence) != VK_SUCCESS)
+        {
+            break;
+        }
+        retire(_batch);
+    }
+}
+
+void StagingUploader::waitOldest()
+{
+    for (size_t i = 0; i < batches.size(); i++)
+    {
+        auto& _batch { batches[(currentBatch + i) % batches.size()] };
+        if (_batch.submitted)
+        {
+            vkWaitForFences(device, 1, &_batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+            break;
+        }
+    }
+    collect();
+}
+
+void StagingUploader::waitIdle()
+{
+    flush();
+    for (auto& batch : batches)
+    {
+        if (batch.submitted)
+        {
+            vkWaitForFences(device, 1, &batch.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+    }
+    collect();
+}
+
+bool StagingUploader::hasPendingWork() const
+{
+    return acquired < nextSerial - 1;
+}
+
+void StagingUploader::acquireOnGraphics(VkCommandBuffer commandBuffer)
+{
+    if (pendingAcquireSerial == acquired)
+    {
+        return;
+    }
+
+    if (usesDedicatedQueue())
+    {
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+            0, nullptr, static_cast<uint32_t>(pendingBufferAcquires.size()), pendingBufferAcquires.data(),
+            static_cast<uint32_t>(pendingImageAcquires.size()), pendingImageAcquires.data());
+    }
+    else
+    {
+        // Same family: the copies are already ordered before us by the fence, they only need to
+        // become visible. Image layouts were transitioned by the release barrier.
+        VkMemoryBarrier memoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT
+        };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+            1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+    pendingBufferAcquires.clear();
+    pendingImageAcquires.clear();
+    acquired = pendingAcquireSerial;
+}
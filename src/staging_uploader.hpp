@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "gpu_allocator.hpp"
+#include "ring_allocator.hpp"
+
+// Staging memory handed out by reserveBuffer()/reserveImage(), the copy out of it is already recorded.
+struct StagingReservation
+{
+    std::span<std::byte> memory;
+    uint64_t serial         { };
+};
+
+// Streams buffer and image data to the GPU through a persistently mapped staging ring and,
+// when the device has one, a dedicated transfer-only queue. Uploads are batched per flush();
+// once a batch's fence has signalled its ownership is handed to the graphics queue by the next
+// acquireOnGraphics(), so rendering never waits on a copy that is still running.
+class StagingUploader
+{
+public:
+    StagingUploader(VkDevice device, GpuAllocator& allocator, uint32_t transferFamily, VkQueue transferQueue,
+        uint32_t graphicsFamily, VkDeviceSize stagingSize);
+    ~StagingUploader();
+
+    StagingUploader(const StagingUploader&) = delete;
+    StagingUploader& operator=(const StagingUploader&) = delete;
+
+    // Copies data into dst at dstOffset, splitting it over several batches when it is bigger than
+    // the staging ring. Returns the serial of the last batch involved.
+    uint64_t uploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, std::span<const std::byte> data);
+
+    // Copies data into mip levels/layers of dst as described by regions, whose bufferOffset is
+    // relative to data. dst ends up in finalLayout; the whole upload must fit the staging ring.
+    uint64_t uploadImage(VkImage dst, const VkImageSubresourceRange& range, std::span<const VkBufferImageCopy> regions,
+        std::span<const std::byte> data, VkImageLayout finalLayout);
+
+    // Two-phase variants for callers that produce the data themselves, e.g. decode it on worker
+    // threads straight into the ring: the copy is recorded now and memory must be completely
+    // written before the next flush(). They never flush on their own, so they return nullopt when
+    // the ring is full; fill what was reserved so far, flush() and retry. Only the reserve calls
+    // themselves must stay on the uploader's thread.
+    std::optional<StagingReservation> reserveBuffer(VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size);
+    std::optional<StagingReservation> reserveImage(VkImage dst, const VkImageSubresourceRange& range,
+        std::span<const VkBufferImageCopy> regions, VkDeviceSize size, VkImageLayout finalLayout);
+    // Largest single reservation that can ever succeed.
+    VkDeviceSize stagingCapacity() const { return stagingRing.size(); }
+
+    // Submits everything recorded since the previous flush.
+    void flush();
+
+    // Retires finished batches without blocking.
+    void collect();
+
+    // Graphics-queue half of the hand-over: records the acquire barriers of every completed batch
+    // into commandBuffer. Resources of batches <= acquiredSerial() may be used after it.
+    void acquireOnGraphics(VkCommandBuffer commandBuffer);
+
+    // Blocks until everything flushed so far has completed on the transfer queue.
+    void waitIdle();
+
+    uint64_t acquiredSerial() const { return acquired; }
+    bool hasPendingWork() const;
+    bool usesDedicatedQueue() const { return transferFamily != graphicsFamily; }
+    uint64_t bytesUploaded() const { return uploadedBytes; }
+
+private:
+    struct Batch
+    {
+        VkCommandPool pool                                  { };
+        VkCommandBuffer commandBuffer                       { };
+        VkFence fence                                       { };
+        uint64_t serial                                     { };
+        bool recording                                      { };
+        bool submitted                                      { };
+        std::vector<VkBufferMemoryBarrier> bufferReleases;
+        std::vector<VkImageMemoryBarrier> imageReleases;
+    };
+
+    Batch& recordingBatch();
+    // Returns nullptr instead of flushing when mayFlush is false and the ring is full.
+    std::byte* allocateStaging(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, bool mayFlush = true);
+    uint64_t recordBufferCopy(VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize stagingOffset, VkDeviceSize size);
+    uint64_t recordImageCopy(VkImage dst, const VkImageSubresourceRange& range, std::span<const VkBufferImageCopy> regions,
+        VkDeviceSize stagingOffset, VkDeviceSize size, VkImageLayout finalLayout);
+    void retire(Batch& batch);
+    void waitOldest();
+
+    VkDevice device                                         { };
+    GpuAllocator& allocator;
+    uint32_t transferFamily                                 { };
+    VkQueue transferQueue                                   { };
+    uint32_t graphicsFamily                                 { };
+
+    GpuBuffer stagingBuffer;
+    RingAllocator stagingRing;
+    std::vector<Batch> batches;
+    size_t currentBatch                                     { };
+    uint64_t nextSerial                                     { 1 };
+    uint64_t completed                                      { };
+    uint64_t acquired                                       { };
+    uint64_t uploadedBytes                                  { };
+
+    std::vector<VkBufferMemoryBarrier> pendingBufferAcquires;
+    std::vector<VkImageMemoryBarrier> pendingImageAcquires;
+    uint64_t pendingAcquireSerial                           { };
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Wall-clock breakdown of application startup, one entry per init phase.
+class StartupTimings
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    template<typename Fn>
+    void measure(std::string_view phase, Fn&& fn)
+    {
+        const auto _start { Clock::now() };
+        std::forward<Fn>(fn)();
+        phases.push_back({ std::string(phase), std::chrono::duration<double, std::milli>(Clock::now() - _start).count() });
+    }
+
+    double totalMs() const
+    {
+        double _total { };
+        for (const auto& phase : phases)
+        {
+            _total += phase.ms;
+        }
+        return _total;
+    }
+
+    void report(std::ostream& out, std::string_view label) const
+    {
+        out << "Startup (" << label << "): " << totalMs() << " ms\n";
+        for (const auto& phase : phases)
+        {
+            out << '\t' << phase.name << ": " << phase.ms << " ms\n";
+        }
+    }
+
+private:
+    struct Phase
+    {
+        std::string name;
+        double ms { };
+    };
+    std::vector<Phase> phases;
+};
@@ -0,0 +1,244 @@
+#include "texture_codec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t BC1_BLOCK_SIZE   { 8 };
+
+    using Color = std::array<int, 3>;
+
+    uint32_t blockCount(uint32_t extent)
+    {
+        return (extent + 3) / 4;
+    }
+
+    uint16_t packRgb565(const Color& color)
+    {
+        return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+
+    Color unpackRgb565(uint16_t packed)
+    {
+        const int _r { (packed >> 11) & 0x1f };
+        const int _g { (packed >> 5) & 0x3f };
+        const int _b { packed & 0x1f };
+        return { (_r << 3) | (_r >> 2), (_g << 2) | (_g >> 4), (_b << 3) | (_b >> 2) };
+    }
+
+    // Palette as the hardware decodes it: four colors when c0 > c1, otherwise three plus black.
+    std::array<Color, 4> bc1Palette(uint16_t c0, uint16_t c1)
+    {
+        const auto _a { unpackRgb565(c0) };
+        const auto _b { unpackRgb565(c1) };
+        std::array<Color, 4> _palette { _a, _b, Color { }, Color { } };
+        for (int i = 0; i < 3; i++)
+        {
+            if (c0 > c1)
+            {
+                _palette[2][i] = (2 * _a[i] + _b[i]) / 3;
+                _palette[3][i] = (_a[i] + 2 * _b[i]) / 3;
+            }
+            else
+            {
+                _palette[2][i] = (_a[i] + _b[i]) / 2;
+            }
+        }
+        return _palette;
+    }
+
+    int distance(const Color& a, const Color& b)
+    {
+        int _sum { };
+        for (int i = 0; i < 3; i++)
+        {
+            _sum += (a[i] - b[i]) * (a[i] - b[i]);
+        }
+        return _sum;
+    }
+}
+
+uint32_t mipLevelCount(uint32_t width, uint32_t height)
+{
+    return static_cast<uint32_t>(std::bit_width(std::max({ width, height, 1u })));
+}
+
+uint32_t mipExtent(uint32_t extent, uint32_t level)
+{
+    return std::max(extent >> level, 1u);
+}
+
+size_t textureLevelSize(TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t level)
+{
+    const uint32_t _width { mipExtent(width, level) };
+    const uint32_t _height { mipExtent(height, level) };
+    if (encoding == TextureEncoding::Bc1)
+    {
+        return size_t { blockCount(_width) } * blockCount(_height) * BC1_BLOCK_SIZE;
+    }
+    return size_t { _width } * _height * 4;
+}
+
+size_t textureLevelOffset(TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t level)
+{
+    size_t _offset { };
+    for (uint32_t i = 0; i < level; i++)
+    {
+        _offset += textureLevelSize(encoding, width, height, i);
+    }
+    return _offset;
+}
+
+size_t textureSize(TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t levels)
+{
+    return textureLevelOffset(encoding, width, height, levels);
+}
+
+std::vector<std::byte> buildMipChain(std::span<const std::byte> pixels, uint32_t width, uint32_t height)
+{
+    const uint32_t _levels { mipLevelCount(width, height) };
+    if (pixels.size() != textureLevelSize(TextureEncoding::Rgba8, width, height, 0))
+    {
+        throw std::runtime_error("Mip chain source has the wrong size!");
+    }
+    std::vector<std::byte> _chain(textureSize(TextureEncoding::Rgba8, width, height, _levels));
+    std::memcpy(_chain.data(), pixels.data(), pixels.size());
+    for (uint32_t level = 1; level < _levels; level++)
+    {
+        const auto* _source { _chain.data() + textureLevelOffset(TextureEncoding::Rgba8, width, height, level - 1) };
+        auto* _target { _chain.data() + textureLevelOffset(TextureEncoding::Rgba8, width, height, level) };
+        const uint32_t _sourceWidth { mipExtent(width, level - 1) };
+        const uint32_t _sourceHeight { mipExtent(height, level - 1) };
+        const uint32_t _width { mipExtent(width, level) };
+        const uint32_t _height { mipExtent(height, level) };
+        for (uint32_t y = 0; y < _height; y++)
+        {
+            // Odd source extents fold their last row/column into the previous texel.
+            const std::array<uint32_t, 2> _rows { std::min(2 * y, _sourceHeight - 1), std::min(2 * y + 1, _sourceHeight - 1) };
+            for (uint32_t x = 0; x < _width; x++)
+            {
+                const std::array<uint32_t, 2> _columns { std::min(2 * x, _sourceWidth - 1), std::min(2 * x + 1, _sourceWidth - 1) };
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    uint32_t _sum { 2 };
+                    for (const auto row : _rows)
+                    {
+                        for (const auto column : _columns)
+                        {
+                            _sum += std::to_integer<uint32_t>(_source[(size_t { row } * _sourceWidth + column) * 4 + c]);
+                        }
+                    }
+                    _target[(size_t { y } * _width + x) * 4 + c] = static_cast<std::byte>(_sum / 4);
+                }
+            }
+        }
+    }
+    return _chain;
+}
+
+void encodeBc1(std::span<const std::byte> pixels, uint32_t width, uint32_t height, std::span<std::byte> blocks)
+{
+    if (pixels.size() != textureLevelSize(TextureEncoding::Rgba8, width, height, 0)
+        || blocks.size() != textureLevelSize(TextureEncoding::Bc1, width, height, 0))
+    {
+        throw std::runtime_error("BC1 encode buffers have the wrong size!");
+    }
+    const uint32_t _blockColumns { blockCount(width) };
+    for (uint32_t by = 0; by < blockCount(height); by++)
+    {
+        for (uint32_t bx = 0; bx < _blockColumns; bx++)
+        {
+            // Blocks hanging over the edge repeat the last row/column.
+            std::array<Color, 16> _texels { };
+            Color _min { 255, 255, 255 };
+            Color _max { 0, 0, 0 };
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                const uint32_t _x { std::min(bx * 4 + i % 4, width - 1) };
+                const uint32_t _y { std::min(by * 4 + i / 4, height - 1) };
+                const auto* _pixel { &pixels[(size_t { _y } * width + _x) * 4] };
+                for (int c = 0; c < 3; c++)
+                {
+                    _texels[i][c] = std::to_integer<int>(_pixel[c]);
+                    _min[c] = std::min(_min[c], _texels[i][c]);
+                    _max[c] = std::max(_max[c], _texels[i][c]);
+                }
+            }
+
+            // Channel-wise max >= min, so c0 >= c1 and the block is in four color mode unless both
+            // endpoints quantise to the same color, which then is as close as RGB565 gets.
+            const uint16_t _c0 { packRgb565(_max) };
+            const uint16_t _c1 { packRgb565(_min) };
+            uint32_t _indices { };
+            if (_c0 != _c1)
+            {
+                const auto _palette { bc1Palette(_c0, _c1) };
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    uint32_t _best { };
+                    for (uint32_t p = 1; p < 4; p++)
+                    {
+                        if (distance(_texels[i], _palette[p]) < distance(_texels[i], _palette[_best]))
+                        {
+                            _best = p;
+                        }
+                    }
+                    _indices |= _best << (2 * i);
+                }
+            }
+
+            auto* _block { &blocks[(size_t { by } * _blockColumns + bx) * BC1_BLOCK_SIZE] };
+            const std::array<uint8_t, BC1_BLOCK_SIZE> _bytes {
+                static_cast<uint8_t>(_c0), static_cast<uint8_t>(_c0 >> 8),
+                static_cast<uint8_t>(_c1), static_cast<uint8_t>(_c1 >> 8),
+                static_cast<uint8_t>(_indices), static_cast<uint8_t>(_indices >> 8),
+                static_cast<uint8_t>(_indices >> 16), static_cast<uint8_t>(_indices >> 24)
+            };
+            std::memcpy(_block, _bytes.data(), _bytes.size());
+        }
+    }
+}
+
+void decodeBc1(std::span<const std::byte> blocks, uint32_t width, uint32_t height, uint32_t firstRow, uint32_t rowCount,
+    std::span<std::byte> pixels)
+{
+    if (blocks.size() != textureLevelSize(TextureEncoding::Bc1, width, height, 0)
+        || pixels.size() != textureLevelSize(TextureEncoding::Rgba8, width, height, 0)
+        || firstRow + rowCount > blockCount(height))
+    {
+        throw std::runtime_error("BC1 decode buffers have the wrong size!");
+    }
+    const uint32_t _blockColumns { blockCount(width) };
+    for (uint32_t by = firstRow; by < firstRow + rowCount; by++)
+    {
+        for (uint32_t bx = 0; bx < _blockColumns; bx++)
+        {
+            std::array<uint8_t, BC1_BLOCK_SIZE> _bytes { };
+            std::memcpy(_bytes.data(), &blocks[(size_t { by } * _blockColumns + bx) * BC1_BLOCK_SIZE], _bytes.size());
+            const auto _c0 { static_cast<uint16_t>(_bytes[0] | (_bytes[1] << 8)) };
+            const auto _c1 { static_cast<uint16_t>(_bytes[2] | (_bytes[3] << 8)) };
+            const uint32_t _indices { _bytes[4] | (_bytes[5] << 8) | (_bytes[6] << 16) | (uint32_t { _bytes[7] } << 24) };
+            const auto _palette { bc1Palette(_c0, _c1) };
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                const uint32_t _x { bx * 4 + i % 4 };
+                const uint32_t _y { by * 4 + i / 4 };
+                if (_x >= width || _y >= height)
+                {
+                    continue;
+                }
+                const auto& _color { _palette[(_indices >> (2 * i)) & 3] };
+                auto* _pixel { &pixels[(size_t { _y } * width + _x) * 4] };
+                for (int c = 0; c < 3; c++)
+                {
+                    _pixel[c] = static_cast<std::byte>(_color[c]);
+                }
+                _pixel[3] = std::byte { 255 };
+            }
+        }
+    }
+}
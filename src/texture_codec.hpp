@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// How a texture's texels are stored, in an asset archive and in staging memory. Levels of a mip
+// chain are stored back to back, largest first, without padding.
+enum class TextureEncoding : uint32_t
+{
+    // R8G8B8A8_UNORM.
+    Rgba8,
+    // BC1_RGB_UNORM_BLOCK: 8 bytes per 4x4 block, opaque.
+    Bc1
+};
+
+uint32_t mipLevelCount(uint32_t width, uint32_t height);
+uint32_t mipExtent(uint32_t extent, uint32_t level);
+size_t textureLevelSize(TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t level);
+size_t textureLevelOffset(TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t level);
+size_t textureSize(TextureEncoding encoding, uint32_t width, uint32_t height, uint32_t levels);
+
+// Full RGBA8 mip chain of an RGBA8 image, each level box filtered from the previous one.
+std::vector<std::byte> buildMipChain(std::span<const std::byte> pixels, uint32_t width, uint32_t height);
+
+// Compresses one RGBA8 level into BC1 blocks, endpoints are the corners of each block's color
+// bounding box. Alpha is ignored.
+void encodeBc1(std::span<const std::byte> pixels, uint32_t width, uint32_t height, std::span<std::byte> blocks);
+
+// Decompresses rowCount block rows starting at firstRow of a BC1 level into the matching rows of
+// an RGBA8 level, so a level can be split over several threads.
+void decodeBc1(std::span<const std::byte> blocks, uint32_t width, uint32_t height, uint32_t firstRow, uint32_t rowCount,
+    std::span<std::byte> pixels);
@@ -0,0 +1,240 @@
+#include "validation_log.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    // How long the logging thread sleeps once the ring is empty, the callback never wakes it.
+    constexpr auto IDLE_INTERVAL { std::chrono::milliseconds(2) };
+    // Marks a used IdCounter key, message ID 0 is a valid key otherwise.
+    constexpr uint64_t KEY_USED { 1ull << 32 };
+
+    VkDebugUtilsMessageSeverityFlagsEXT severityMask(ValidationSeverity minSeverity)
+    {
+        VkDebugUtilsMessageSeverityFlagsEXT mask { VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT };
+        if (minSeverity <= ValidationSeverity::Warning)
+        {
+            mask |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+        }
+        if (minSeverity <= ValidationSeverity::Info)
+        {
+            mask |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+        }
+        if (minSeverity <= ValidationSeverity::Verbose)
+        {
+            mask |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+        }
+        return mask;
+    }
+
+    void copyTruncated(const char* source, char* destination, size_t capacity)
+    {
+        const size_t _length { source ? std::min(std::strlen(source), capacity - 1) : 0 };
+        std::memcpy(destination, source ? source : "", _length);
+        destination[_length] = '\0';
+    }
+}
+
+ValidationLog::ValidationLog(const ValidationConfig& validationConfig)
+    : config(validationConfig)
+{
+    for (uint32_t i = 0; i < RING_SIZE; i++)
+    {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    loggingThread = std::thread(&ValidationLog::loggingLoop, this);
+}
+
+ValidationLog::~ValidationLog()
+{
+    stopping.store(true, std::memory_order_release);
+    loggingThread.join();
+    reportStats(std::cout);
+}
+
+VkDebugUtilsMessengerCreateInfoEXT ValidationLog::messengerCreateInfo()
+{
+    VkDebugUtilsMessengerCreateInfoEXT createInfo {
+        .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
+        .messageSeverity = severityMask(config.minSeverity),
+        .pfnUserCallback = ValidationLog::callback,
+        .pUserData = this
+    };
+    if (config.general)
+    {
+        createInfo.messageType |= VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT;
+    }
+    if (config.validation)
+    {
+        createInfo.messageType |= VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+    }
+    if (config.performance)
+    {
+        createInfo.messageType |= VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+    }
+    return createInfo;
+}
+
+void ValidationLog::reportStats(std::ostream& out) const
+{
+    const auto _messages { messageCount.load(std::memory_order_relaxed) };
+    if (!_messages)
+    {
+        return;
+    }
+    out << "Validation: " << _messages << " messages, " << suppressedCount.load(std::memory_order_relaxed)
+        << " repeats suppressed, " << droppedCount.load(std::memory_order_relaxed) << " dropped (log ring full)\n";
+
+    std::vector<const IdCounter*> _counters;
+    for (const auto& counter : idCounters)
+    {
+        if (counter.named.load(std::memory_order_acquire))
+        {
+            _counters.push_back(&counter);
+        }
+    }
+    std::sort(_counters.begin(), _counters.end(), [](const IdCounter* a, const IdCounter* b) {
+        return a->count.load(std::memory_order_relaxed) > b->count.load(std::memory_order_relaxed);
+    });
+    _counters.resize(std::min<size_t>(_counters.size(), REPORTED_IDS));
+    for (const auto* counter : _counters)
+    {
+        out << '\t' << counter->count.load(std::memory_order_relaxed) << "x " << counter->name.data()
+            << " (0x" << std::hex << static_cast<uint32_t>(counter->key.load(std::memory_order_relaxed)) << std::dec << ")\n";
+    }
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL ValidationLog::callback(
+    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+    VkDebugUtilsMessageTypeFlagsEXT messageType,
+    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+    void* pUserData)
+{
+    static_cast<ValidationLog*>(pUserData)->push(messageSeverity, *pCallbackData);
+    return VK_FALSE;
+}
+
+void ValidationLog::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT& data)
+{
+    messageCount.fetch_add(1, std::memory_order_relaxed);
+    uint32_t _repeat { };
+    if (auto* _counter = counterFor(data.messageIdNumber, data.pMessageIdName))
+    {
+        _repeat = _counter->count.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (config.maxRepeats && _repeat > config.maxRepeats)
+        {
+            suppressedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    auto _position { enqueuePosition.load(std::memory_order_relaxed) };
+    Slot* _slot { };
+    for (;;)
+    {
+        _slot = &ring[_position % RING_SIZE];
+        const auto _sequence { _slot->sequence.load(std::memory_order_acquire) };
+        if (_sequence == _position)
+        {
+            if (enqueuePosition.compare_exchange_weak(_position, _position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (_sequence < _position)
+        {
+            // The consumer hasn't freed this slot yet: the ring is full.
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            _position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    _slot->severity = severity;
+    _slot->repeat = _repeat;
+    copyTruncated(data.pMessage, _slot->text.data(), MESSAGE_CAPACITY);
+    _slot->sequence.store(_position + 1, std::memory_order_release);
+}
+
+ValidationLog::IdCounter* ValidationLog::counterFor(int32_t messageId, const char* messageIdName)
+{
+    if (!messageId)
+    {
+        return nullptr;
+    }
+    const uint64_t _key { static_cast<uint32_t>(messageId) | KEY_USED };
+    // Message IDs are already hashes of the VUID string.
+    const auto _start { static_cast<uint32_t>(messageId) };
+    for (uint32_t probe = 0; probe < ID_TABLE_SIZE; probe++)
+    {
+        auto& _counter { idCounters[(_start + probe) % ID_TABLE_SIZE] };
+        auto _current { _counter.key.load(std::memory_order_acquire) };
+        if (!_current && _counter.key.compare_exchange_strong(_current, _key, std::memory_order_acq_rel))
+        {
+            copyTruncated(messageIdName, _counter.name.data(), ID_NAME_CAPACITY);
+            _counter.named.store(true, std::memory_order_release);
+            return &_counter;
+        }
+        if (_current == _key)
+        {
+            return &_counter;
+        }
+    }
+    return nullptr;
+}
+
+void ValidationLog::loggingLoop()
+{
+    for (;;)
+    {
+        // Read the flag first so the final drain sees everything pushed before the destructor ran.
+        const bool _stopping { stopping.load(std::memory_order_acquire) };
+        if (!drain())
+        {
+            if (_stopping)
+            {
+                return;
+            }
+            std::this_thread::sleep_for(IDLE_INTERVAL);
+        }
+    }
+}
+
+bool ValidationLog::drain()
+{
+    bool _printed { };
+    for (;;)
+    {
+        auto& _slot { ring[dequeuePosition % RING_SIZE] };
+        if (_slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+        {
+            return _printed;
+        }
+
+        std::string_view _label;
+        switch (_slot.severity)
+        {
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: _label = "error"; break;
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: _label = "warning"; break;
+            default: _label = "info"; break;
+        }
+        auto& _out { _slot.severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT ? std::cerr : std::cout };
+        _out << "Validation layer " << _label << ": " << _slot.text.data();
+        if (config.maxRepeats && _slot.repeat == config.maxRepeats)
+        {
+            _out << " (further repeats suppressed)";
+        }
+        _out << "\n";
+
+        _slot.sequence.store(dequeuePosition + RING_SIZE, std::memory_order_release);
+        dequeuePosition++;
+        _printed = true;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+
+#include <vulkan/vulkan.h>
+
+#include "app_config.hpp"
+
+// Debug messenger sink that keeps iostream off the threads calling into the driver. The callback
+// counts each message per message ID and, unless that ID already hit maxRepeats, copies it into a
+// lock-free ring; a logging thread prints the ring. Nothing in the callback takes a lock or
+// allocates, a full ring drops the message and counts it instead of waiting.
+//
+// Severity and type filtering happen in the layer itself through the messenger's masks.
+class ValidationLog
+{
+public:
+    explicit ValidationLog(const ValidationConfig& config);
+    // Stops the logging thread after it printed everything queued, then prints reportStats().
+    ~ValidationLog();
+
+    ValidationLog(const ValidationLog&) = delete;
+    ValidationLog& operator=(const ValidationLog&) = delete;
+
+    // For vkCreateDebugUtilsMessengerEXT and the vkCreateInstance pNext chain. The log has to
+    // outlive both the messenger and the instance.
+    VkDebugUtilsMessengerCreateInfoEXT messengerCreateInfo();
+
+    // Message totals and the most repeated message IDs.
+    void reportStats(std::ostream& out) const;
+
+private:
+    static constexpr uint32_t RING_SIZE         { 256 };
+    // Longer messages are cut, validation messages rarely go past a few hundred characters.
+    static constexpr size_t MESSAGE_CAPACITY    { 1024 };
+    static constexpr size_t ID_NAME_CAPACITY    { 96 };
+    static constexpr uint32_t ID_TABLE_SIZE     { 512 };
+    static constexpr uint32_t REPORTED_IDS      { 10 };
+
+    struct Slot
+    {
+        // Vyukov bounded queue: == position when free for it, position + 1 once written.
+        std::atomic<uint64_t> sequence      { };
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity { };
+        // Which repeat of its message ID this is, 0 when the ID isn't tracked.
+        uint32_t repeat                     { };
+        std::array<char, MESSAGE_CAPACITY> text { };
+    };
+
+    // Open-addressed, insert-only: a claimed entry keeps its ID for the life of the log.
+    struct IdCounter
+    {
+        std::atomic<uint64_t> key           { };
+        std::atomic<uint32_t> count         { };
+        std::atomic<bool> named             { };
+        std::array<char, ID_NAME_CAPACITY> name { };
+    };
+
+    static VKAPI_ATTR VkBool32 VKAPI_CALL callback(
+        VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+        VkDebugUtilsMessageTypeFlagsEXT messageType,
+        const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+        void* pUserData);
+
+    void push(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT& data);
+    // Null for messages without an ID (loader messages) or when the table is full.
+    IdCounter* counterFor(int32_t messageId, const char* messageIdName);
+
+    void loggingLoop();
+    // Consumer only, returns whether anything was printed.
+    bool drain();
+
+    const ValidationConfig config;
+
+    std::array<Slot, RING_SIZE> ring;
+    std::atomic<uint64_t> enqueuePosition   { };
+    uint64_t dequeuePosition                { };
+    std::array<IdCounter, ID_TABLE_SIZE> idCounters;
+
+    std::atomic<uint64_t> messageCount      { };
+    std::atomic<uint64_t> suppressedCount   { };
+    std::atomic<uint64_t> droppedCount      { };
+
+    std::atomic<bool> stopping              { };
+    std::thread loggingThread;
+};
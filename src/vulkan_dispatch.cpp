@@ -0,0 +1,53 @@
+#include "vulkan_dispatch.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#define VKP_DEFINE_FUNCTION(name) PFN_##name name { };
+VKP_GLOBAL_FUNCTIONS(VKP_DEFINE_FUNCTION)
+VKP_INSTANCE_FUNCTIONS(VKP_DEFINE_FUNCTION)
+VKP_INSTANCE_EXTENSION_FUNCTIONS(VKP_DEFINE_FUNCTION)
+VKP_DEVICE_FUNCTIONS(VKP_DEFINE_FUNCTION)
+VKP_DEVICE_EXTENSION_FUNCTIONS(VKP_DEFINE_FUNCTION)
+VKP_DEVICE_PROMOTED_FUNCTIONS(VKP_DEFINE_FUNCTION)
+#undef VKP_DEFINE_FUNCTION
+
+namespace
+{
+    template<typename Function>
+    void require(Function function, const char* name)
+    {
+        if (!function)
+        {
+            throw std::runtime_error(std::string("Failed to load ") + name + "!");
+        }
+    }
+}
+
+#define VKP_LOAD_GLOBAL(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(VK_NULL_HANDLE, #name)); \
+    require(name, #name);
+#define VKP_LOAD_INSTANCE(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+#define VKP_LOAD_DEVICE(name) name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));
+#define VKP_LOAD_PROMOTED(name) VKP_LOAD_DEVICE(name) \
+    if (!name) { name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name "KHR")); }
+#define VKP_REQUIRE(name) require(name, #name);
+
+void loadGlobalDispatch()
+{
+    VKP_GLOBAL_FUNCTIONS(VKP_LOAD_GLOBAL)
+}
+
+void loadInstanceDispatch(VkInstance instance)
+{
+    VKP_INSTANCE_FUNCTIONS(VKP_LOAD_INSTANCE)
+    VKP_INSTANCE_FUNCTIONS(VKP_REQUIRE)
+    VKP_INSTANCE_EXTENSION_FUNCTIONS(VKP_LOAD_INSTANCE)
+}
+
+void loadDeviceDispatch(VkDevice device)
+{
+    VKP_DEVICE_FUNCTIONS(VKP_LOAD_DEVICE)
+    VKP_DEVICE_FUNCTIONS(VKP_REQUIRE)
+    VKP_DEVICE_EXTENSION_FUNCTIONS(VKP_LOAD_DEVICE)
+    VKP_DEVICE_PROMOTED_FUNCTIONS(VKP_LOAD_PROMOTED)
+}
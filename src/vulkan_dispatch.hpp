@@ -0,0 +1,155 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// Every Vulkan entry point the playground calls, as a global function pointer of the same name.
+// Targets are built with VK_NO_PROTOTYPES, so a call to anything missing from these lists fails to
+// compile instead of silently going through the loader.
+//
+// Device functions come from vkGetDeviceProcAddr and call straight into the driver, skipping the
+// loader's trampoline and dispatch table lookup on every call. There is one set of pointers per
+// process, loaded for the one device the application creates.
+#ifndef VK_NO_PROTOTYPES
+#error "vulkan_dispatch.hpp needs VK_NO_PROTOTYPES, see CMakeLists.txt"
+#endif
+
+// vkGetInstanceProcAddr(nullptr, ...)
+#define VKP_GLOBAL_FUNCTIONS(X) \
+    X(vkCreateInstance) \
+    X(vkEnumerateInstanceExtensionProperties) \
+    X(vkEnumerateInstanceLayerProperties)
+
+#define VKP_INSTANCE_FUNCTIONS(X) \
+    X(vkCreateDevice) \
+    X(vkDestroyInstance) \
+    X(vkEnumerateDeviceExtensionProperties) \
+    X(vkEnumeratePhysicalDevices) \
+    X(vkGetDeviceProcAddr) \
+    X(vkGetPhysicalDeviceFeatures) \
+    X(vkGetPhysicalDeviceFeatures2) \
+    X(vkGetPhysicalDeviceFormatProperties) \
+    X(vkGetPhysicalDeviceMemoryProperties) \
+    X(vkGetPhysicalDeviceProperties) \
+    X(vkGetPhysicalDeviceProperties2) \
+    X(vkGetPhysicalDeviceQueueFamilyProperties)
+
+// Null unless the instance enabled the extension.
+#define VKP_INSTANCE_EXTENSION_FUNCTIONS(X) \
+    X(vkCreateDebugUtilsMessengerEXT) \
+    X(vkDestroyDebugUtilsMessengerEXT) \
+    X(vkDestroySurfaceKHR) \
+    X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+    X(vkGetPhysicalDeviceSurfaceFormatsKHR) \
+    X(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+    X(vkGetPhysicalDeviceSurfaceSupportKHR)
+
+#define VKP_DEVICE_FUNCTIONS(X) \
+    X(vkAllocateCommandBuffers) \
+    X(vkAllocateDescriptorSets) \
+    X(vkAllocateMemory) \
+    X(vkBeginCommandBuffer) \
+    X(vkBindBufferMemory) \
+    X(vkBindImageMemory) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdClearAttachments) \
+    X(vkCmdCopyBuffer) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdDispatch) \
+    X(vkCmdDrawIndexedIndirectCount) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdExecuteCommands) \
+    X(vkCmdFillBuffer) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdPushConstants) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdSetScissor) \
+    X(vkCmdSetViewport) \
+    X(vkCmdWriteTimestamp) \
+    X(vkCreateBuffer) \
+    X(vkCreateCommandPool) \
+    X(vkCreateComputePipelines) \
+    X(vkCreateDescriptorPool) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkCreateFence) \
+    X(vkCreateFramebuffer) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkCreateImage) \
+    X(vkCreateImageView) \
+    X(vkCreatePipelineCache) \
+    X(vkCreatePipelineLayout) \
+    X(vkCreateQueryPool) \
+    X(vkCreateRenderPass) \
+    X(vkCreateSampler) \
+    X(vkCreateSemaphore) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyBuffer) \
+    X(vkDestroyCommandPool) \
+    X(vkDestroyDescriptorPool) \
+    X(vkDestroyDescriptorSetLayout) \
+    X(vkDestroyDevice) \
+    X(vkDestroyFence) \
+    X(vkDestroyFramebuffer) \
+    X(vkDestroyImage) \
+    X(vkDestroyImageView) \
+    X(vkDestroyPipeline) \
+    X(vkDestroyPipelineCache) \
+    X(vkDestroyPipelineLayout) \
+    X(vkDestroyQueryPool) \
+    X(vkDestroyRenderPass) \
+    X(vkDestroySampler) \
+    X(vkDestroySemaphore) \
+    X(vkDestroyShaderModule) \
+    X(vkDeviceWaitIdle) \
+    X(vkEndCommandBuffer) \
+    X(vkFreeMemory) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkGetDeviceQueue) \
+    X(vkGetFenceStatus) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkGetPipelineCacheData) \
+    X(vkGetQueryPoolResults) \
+    X(vkMapMemory) \
+    X(vkMergePipelineCaches) \
+    X(vkQueueSubmit) \
+    X(vkQueueWaitIdle) \
+    X(vkResetCommandPool) \
+    X(vkResetFences) \
+    X(vkUnmapMemory) \
+    X(vkUpdateDescriptorSets) \
+    X(vkWaitForFences)
+
+// Null unless the device enabled the extension, e.g. in headless mode.
+#define VKP_DEVICE_EXTENSION_FUNCTIONS(X) \
+    X(vkAcquireNextImageKHR) \
+    X(vkCreateSwapchainKHR) \
+    X(vkDestroySwapchainKHR) \
+    X(vkGetSwapchainImagesKHR) \
+    X(vkQueuePresentKHR)
+
+// Core in 1.3, loaded from the KHR extension under the core name on 1.2 devices. Null unless
+// dynamic rendering is enabled, see createLogicalDevice().
+#define VKP_DEVICE_PROMOTED_FUNCTIONS(X) \
+    X(vkCmdBeginRendering) \
+    X(vkCmdEndRendering) \
+    X(vkCmdPipelineBarrier2)
+
+#define VKP_DECLARE_FUNCTION(name) extern PFN_##name name;
+VKP_GLOBAL_FUNCTIONS(VKP_DECLARE_FUNCTION)
+VKP_INSTANCE_FUNCTIONS(VKP_DECLARE_FUNCTION)
+VKP_INSTANCE_EXTENSION_FUNCTIONS(VKP_DECLARE_FUNCTION)
+VKP_DEVICE_FUNCTIONS(VKP_DECLARE_FUNCTION)
+VKP_DEVICE_EXTENSION_FUNCTIONS(VKP_DECLARE_FUNCTION)
+VKP_DEVICE_PROMOTED_FUNCTIONS(VKP_DECLARE_FUNCTION)
+#undef VKP_DECLARE_FUNCTION
+
+// The one symbol still linked from the loader, everything else is looked up through it.
+extern "C" VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char* pName);
+
+// Each throws std::runtime_error when a core function is missing. Call in order: before
+// vkCreateInstance, after it, and after vkCreateDevice.
+void loadGlobalDispatch();
+void loadInstanceDispatch(VkInstance instance);
+void loadDeviceDispatch(VkDevice device);
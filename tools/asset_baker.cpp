@@ -0,0 +1,86 @@
+// Bakes the demo scene's meshes, optimized and split into meshlets as buildDemoScene() does, and
+// its textures into a packed asset archive for --assets. Textures get full mip chains and are BC1
+// compressed unless --uncompressed is given; instance placement is not stored, the app still
+// generates it from --instances.
+//
+//     asset-baker <out.vkpa> [--texture-size <px>] [--uncompressed]
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "asset_archive.hpp"
+#include "mesh_optimizer.hpp"
+#include "scene.hpp"
+#include "scene_archive.hpp"
+
+namespace
+{
+    constexpr uint32_t DEFAULT_TEXTURE_SIZE { 1024 };
+
+    uint32_t parseTextureSize(std::string_view value)
+    {
+        uint32_t _size { };
+        const auto [_end, _error] { std::from_chars(value.data(), value.data() + value.size(), _size) };
+        if (_error != std::errc { } || _end != value.data() + value.size() || !_size || _size > 16384)
+        {
+            throw std::runtime_error("Invalid texture size " + std::string(value) + "!");
+        }
+        return _size;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const std::string _usage { "Usage: " + std::string(argv[0]) + " <out.vkpa> [--texture-size <px>] [--uncompressed]" };
+        std::filesystem::path _output;
+        uint32_t _textureSize { DEFAULT_TEXTURE_SIZE };
+        bool _compress { true };
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string_view _arg { argv[i] };
+            if (_arg == "--texture-size" && i + 1 < argc)
+            {
+                _textureSize = parseTextureSize(argv[++i]);
+            }
+            else if (_arg == "--uncompressed")
+            {
+                _compress = false;
+            }
+            else if (_output.empty() && !_arg.starts_with("--"))
+            {
+                _output = _arg;
+            }
+            else
+            {
+                throw std::runtime_error(_usage);
+            }
+        }
+        if (_output.empty())
+        {
+            throw std::runtime_error(_usage);
+        }
+
+        const auto _scene { buildDemoScene(0, _textureSize) };
+        reportGeometry(std::cout, _scene.sourceGeometry, _scene.geometry);
+        AssetArchiveWriter _writer;
+        bakeSceneAssets(_scene, _compress, _writer);
+        _writer.write(_output);
+        std::cout << "Wrote " << _output.string() << ": " << _scene.meshes.size() << " meshes, " << _scene.textures.size()
+            << " " << _textureSize << "px " << (_compress ? "BC1" : "RGBA8") << " textures, "
+            << std::filesystem::file_size(_output) / 1e6 << " MB\n";
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,628 @@
+// Build step that embeds SPIR-V binaries into the executable and reflects what pipeline creation
+// needs from them: stage, descriptor bindings, push constant block size, workgroup size and
+// specialization constants. Writes embedded_shaders.hpp, whose constexpr tables layouts are created
+// from and static_asserts can check against, and embedded_shaders.cpp with the code words.
+//
+//     shader-embed <output dir> <shader.spv>...
+//
+// Only the subset of SPIR-V glslc emits for our shaders is understood, anything else that would
+// change a layout (unknown descriptor types, unsized push constant members) is an error.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t SPIRV_MAGIC { 0x07230203 };
+
+    // The opcodes, decorations and enums below are from the SPIR-V specification.
+    enum Op : uint32_t
+    {
+        OpName = 5,
+        OpEntryPoint = 15,
+        OpExecutionMode = 16,
+        OpTypeBool = 20,
+        OpTypeInt = 21,
+        OpTypeFloat = 22,
+        OpTypeVector = 23,
+        OpTypeMatrix = 24,
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstantTrue = 41,
+        OpConstantFalse = 42,
+        OpConstant = 43,
+        OpConstantComposite = 44,
+        OpSpecConstantTrue = 48,
+        OpSpecConstantFalse = 49,
+        OpSpecConstant = 50,
+        OpSpecConstantComposite = 51,
+        OpVariable = 59,
+        OpDecorate = 71,
+        OpMemberDecorate = 72,
+        OpTypeAccelerationStructure = 5341
+    };
+
+    enum Decoration : uint32_t
+    {
+        SpecId = 1,
+        Block = 2,
+        BufferBlock = 3,
+        ArrayStride = 6,
+        MatrixStride = 7,
+        BuiltIn = 11,
+        Binding = 33,
+        DescriptorSet = 34,
+        Offset = 35
+    };
+
+    enum StorageClass : uint32_t
+    {
+        UniformConstant = 0,
+        Uniform = 2,
+        PushConstant = 9,
+        StorageBuffer = 12
+    };
+
+    constexpr uint32_t BUILT_IN_WORKGROUP_SIZE      { 25 };
+    constexpr uint32_t EXECUTION_MODE_LOCAL_SIZE    { 17 };
+    constexpr uint32_t EXECUTION_MODE_LOCAL_SIZE_ID { 38 };
+    constexpr uint32_t DIM_BUFFER                   { 5 };
+    constexpr uint32_t DIM_SUBPASS_DATA             { 6 };
+    // Entry points are in SPIR-V 1.4+ interface lists with every global they use.
+    constexpr uint32_t INTERFACE_LISTS_GLOBALS      { 0x00010400 };
+
+    struct Instruction
+    {
+        uint32_t opcode             { };
+        std::span<const uint32_t> operands;
+    };
+
+    struct DescriptorBinding
+    {
+        uint32_t set                { };
+        uint32_t binding            { };
+        std::string type;
+        // 0 for runtime-sized arrays.
+        uint32_t count              { 1 };
+    };
+
+    struct SpecConstant
+    {
+        uint32_t id                 { };
+        std::string name;
+        uint32_t size               { };
+        uint64_t defaultValue       { };
+    };
+
+    struct Reflection
+    {
+        std::string name;
+        std::string identifier;
+        std::string stage;
+        std::vector<uint32_t> code;
+        std::vector<DescriptorBinding> bindings;
+        uint32_t pushConstantSize   { };
+        std::vector<SpecConstant> specConstants;
+        uint32_t localSize[3]       { 1, 1, 1 };
+    };
+
+    std::string literalString(std::span<const uint32_t> words)
+    {
+        std::string _string;
+        for (const auto word : words)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                const char _c { static_cast<char>((word >> (8 * i)) & 0xff) };
+                if (!_c)
+                {
+                    return _string;
+                }
+                _string += _c;
+            }
+        }
+        return _string;
+    }
+
+    const char* stageName(uint32_t executionModel)
+    {
+        switch (executionModel)
+        {
+        case 0: return "VK_SHADER_STAGE_VERTEX_BIT";
+        case 1: return "VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT";
+        case 2: return "VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT";
+        case 3: return "VK_SHADER_STAGE_GEOMETRY_BIT";
+        case 4: return "VK_SHADER_STAGE_FRAGMENT_BIT";
+        case 5: return "VK_SHADER_STAGE_COMPUTE_BIT";
+        case 5364: return "VK_SHADER_STAGE_TASK_BIT_EXT";
+        case 5365: return "VK_SHADER_STAGE_MESH_BIT_EXT";
+        default: throw std::runtime_error("Unsupported execution model " + std::to_string(executionModel) + "!");
+        }
+    }
+
+    // cull.comp.spv -> SHADER_CULL_COMP
+    std::string identifierFor(std::string name)
+    {
+        std::string _identifier { "SHADER_" };
+        for (const char c : name)
+        {
+            _identifier += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(c)) : '_';
+        }
+        return _identifier;
+    }
+
+    class Reflector
+    {
+    public:
+        explicit Reflector(const std::filesystem::path& path)
+        {
+            reflection.name = path.stem().string();
+            reflection.identifier = identifierFor(reflection.name);
+            std::ifstream _file { path, std::ios::binary | std::ios::ate };
+            const auto _size { _file ? static_cast<size_t>(_file.tellg()) : 0 };
+            if (_size < 5 * sizeof(uint32_t) || _size % sizeof(uint32_t))
+            {
+                throw std::runtime_error("Failed to read SPIR-V binary " + path.string() + "!");
+            }
+            reflection.code.resize(_size / sizeof(uint32_t));
+            _file.seekg(0);
+            _file.read(reinterpret_cast<char*>(reflection.code.data()), static_cast<std::streamsize>(_size));
+            if (reflection.code[0] != SPIRV_MAGIC)
+            {
+                throw std::runtime_error(path.string() + " is not a SPIR-V binary!");
+            }
+            version = reflection.code[1];
+
+            for (size_t offset = 5; offset < reflection.code.size();)
+            {
+                const auto _word { reflection.code[offset] };
+                const auto _length { _word >> 16 };
+                if (!_length || offset + _length > reflection.code.size())
+                {
+                    throw std::runtime_error(path.string() + " has a malformed instruction!");
+                }
+                instructions.push_back({ _word & 0xffff, std::span(reflection.code).subspan(offset + 1, _length - 1) });
+                offset += _length;
+            }
+        }
+
+        Reflection reflect()
+        {
+            for (const auto& instruction : instructions)
+            {
+                record(instruction);
+            }
+            if (!entryPoint)
+            {
+                throw std::runtime_error(reflection.name + " has no entry point!");
+            }
+            reflectVariables();
+            reflectSpecConstants();
+            reflectLocalSize();
+            return reflection;
+        }
+
+    private:
+        void record(const Instruction& instruction)
+        {
+            const auto& _ops { instruction.operands };
+            switch (instruction.opcode)
+            {
+            case OpName:
+                names[_ops[0]] = literalString(_ops.subspan(1));
+                break;
+            case OpEntryPoint:
+                if (!entryPoint)
+                {
+                    entryPoint = _ops[1];
+                    reflection.stage = stageName(_ops[0]);
+                    // Interface ids follow the zero terminated name.
+                    const auto _nameWords { literalString(_ops.subspan(2)).size() / 4 + 1 };
+                    for (const auto id : _ops.subspan(2 + _nameWords))
+                    {
+                        interface.insert(id);
+                    }
+                }
+                break;
+            case OpExecutionMode:
+                if (_ops[0] == entryPoint && (_ops[1] == EXECUTION_MODE_LOCAL_SIZE || _ops[1] == EXECUTION_MODE_LOCAL_SIZE_ID))
+                {
+                    localSizeMode = _ops[1];
+                    localSizeOperands.assign(_ops.begin() + 2, _ops.end());
+                }
+                break;
+            case OpDecorate:
+                decorations[_ops[0]][_ops[1]] = _ops.size() > 2 ? _ops[2] : 0;
+                break;
+            case OpMemberDecorate:
+                memberDecorations[{ _ops[0], _ops[1] }][_ops[2]] = _ops.size() > 3 ? _ops[3] : 0;
+                break;
+            case OpVariable:
+                variables.push_back({ _ops[1], _ops[0], _ops[2] });
+                break;
+            case OpConstant:
+            case OpSpecConstant:
+                constants[_ops[1]] = { _ops[0], _ops[2] | (_ops.size() > 3 ? uint64_t { _ops[3] } << 32 : 0) };
+                break;
+            case OpConstantTrue:
+            case OpSpecConstantTrue:
+                constants[_ops[1]] = { _ops[0], 1 };
+                break;
+            case OpConstantFalse:
+            case OpSpecConstantFalse:
+                constants[_ops[1]] = { _ops[0], 0 };
+                break;
+            case OpConstantComposite:
+            case OpSpecConstantComposite:
+                composites[_ops[1]].assign(_ops.begin() + 2, _ops.end());
+                break;
+            default:
+                break;
+            }
+            if ((instruction.opcode >= OpTypeBool && instruction.opcode <= OpTypePointer)
+                || instruction.opcode == OpTypeAccelerationStructure)
+            {
+                types[_ops[0]] = instruction;
+            }
+            if (instruction.opcode >= OpSpecConstantTrue && instruction.opcode <= OpSpecConstant)
+            {
+                specConstants.push_back(_ops[1]);
+            }
+        }
+
+        std::optional<uint32_t> decoration(uint32_t id, uint32_t kind) const
+        {
+            const auto _found { decorations.find(id) };
+            if (_found == decorations.end() || !_found->second.contains(kind))
+            {
+                return std::nullopt;
+            }
+            return _found->second.at(kind);
+        }
+
+        std::optional<uint32_t> memberDecoration(uint32_t id, uint32_t member, uint32_t kind) const
+        {
+            const auto _found { memberDecorations.find({ id, member }) };
+            if (_found == memberDecorations.end() || !_found->second.contains(kind))
+            {
+                return std::nullopt;
+            }
+            return _found->second.at(kind);
+        }
+
+        const Instruction& type(uint32_t id) const
+        {
+            const auto _found { types.find(id) };
+            if (_found == types.end())
+            {
+                throw std::runtime_error(reflection.name + " uses unknown type %" + std::to_string(id) + "!");
+            }
+            return _found->second;
+        }
+
+        uint64_t constantValue(uint32_t id) const
+        {
+            const auto _found { constants.find(id) };
+            if (_found == constants.end())
+            {
+                throw std::runtime_error(reflection.name + " sizes an array with a non-constant %" + std::to_string(id) + "!");
+            }
+            return _found->second.value;
+        }
+
+        std::string descriptorType(uint32_t typeId, uint32_t storageClass) const
+        {
+            const auto& _type { type(typeId) };
+            switch (_type.opcode)
+            {
+            case OpTypeSampledImage:
+                return "VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER";
+            case OpTypeSampler:
+                return "VK_DESCRIPTOR_TYPE_SAMPLER";
+            case OpTypeAccelerationStructure:
+                return "VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR";
+            case OpTypeImage:
+            {
+                const auto _dim { _type.operands[2] };
+                const bool _storage { _type.operands[6] == 2 };
+                if (_dim == DIM_BUFFER)
+                {
+                    return _storage ? "VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER" : "VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER";
+                }
+                if (_dim == DIM_SUBPASS_DATA)
+                {
+                    return "VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT";
+                }
+                return _storage ? "VK_DESCRIPTOR_TYPE_STORAGE_IMAGE" : "VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE";
+            }
+            case OpTypeStruct:
+                if (storageClass == StorageBuffer || decoration(typeId, BufferBlock))
+                {
+                    return "VK_DESCRIPTOR_TYPE_STORAGE_BUFFER";
+                }
+                return "VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER";
+            default:
+                throw std::runtime_error(reflection.name + " has a resource of unsupported type %" + std::to_string(typeId) + "!");
+            }
+        }
+
+        // Size of a type inside a push constant block, strides come from the explicit layout
+        // decorations glslc always emits there.
+        uint32_t typeSize(uint32_t typeId, std::optional<uint32_t> matrixStride = std::nullopt) const
+        {
+            const auto& _type { type(typeId) };
+            const auto& _ops { _type.operands };
+            switch (_type.opcode)
+            {
+            case OpTypeBool:
+                return 4;
+            case OpTypeInt:
+            case OpTypeFloat:
+                return _ops[1] / 8;
+            case OpTypeVector:
+                return typeSize(_ops[1]) * _ops[2];
+            case OpTypeMatrix:
+                return (matrixStride ? *matrixStride : typeSize(_ops[1])) * _ops[2];
+            case OpTypeArray:
+            {
+                const auto _stride { decoration(typeId, ArrayStride) };
+                return static_cast<uint32_t>((_stride ? *_stride : typeSize(_ops[1])) * constantValue(_ops[2]));
+            }
+            case OpTypeStruct:
+            {
+                uint32_t _size { };
+                for (uint32_t member = 0; member + 1 < _ops.size(); member++)
+                {
+                    const auto _offset { memberDecoration(typeId, member, Offset) };
+                    if (!_offset)
+                    {
+                        throw std::runtime_error(reflection.name + " has a block member without an offset!");
+                    }
+                    _size = std::max(_size, *_offset + typeSize(_ops[member + 1], memberDecoration(typeId, member, MatrixStride)));
+                }
+                return _size;
+            }
+            default:
+                throw std::runtime_error(reflection.name + " has a push constant of unsupported type %" + std::to_string(typeId) + "!");
+            }
+        }
+
+        void reflectVariables()
+        {
+            for (const auto& variable : variables)
+            {
+                if (version >= INTERFACE_LISTS_GLOBALS && !interface.contains(variable.id))
+                {
+                    continue;
+                }
+                const auto& _pointer { type(variable.pointerType) };
+                auto _typeId { _pointer.operands[2] };
+                if (variable.storageClass == PushConstant)
+                {
+                    reflection.pushConstantSize = std::max(reflection.pushConstantSize, typeSize(_typeId));
+                    continue;
+                }
+                if (variable.storageClass != UniformConstant && variable.storageClass != Uniform
+                    && variable.storageClass != StorageBuffer)
+                {
+                    continue;
+                }
+
+                DescriptorBinding _binding {
+                    .set = decoration(variable.id, DescriptorSet).value_or(0),
+                    .binding = decoration(variable.id, Binding).value_or(0)
+                };
+                while (type(_typeId).opcode == OpTypeArray || type(_typeId).opcode == OpTypeRuntimeArray)
+                {
+                    const auto& _array { type(_typeId) };
+                    _binding.count = _array.opcode == OpTypeArray
+                        ? static_cast<uint32_t>(_binding.count * constantValue(_array.operands[2])) : 0;
+                    _typeId = _array.operands[1];
+                }
+                _binding.type = descriptorType(_typeId, variable.storageClass);
+                addBinding(_binding);
+            }
+            std::sort(reflection.bindings.begin(), reflection.bindings.end(),
+                [](const auto& a, const auto& b) { return std::tie(a.set, a.binding) < std::tie(b.set, b.binding); });
+        }
+
+        // Several blocks may alias one binding, as the bindless buffer views in common.glsl do.
+        void addBinding(const DescriptorBinding& binding)
+        {
+            const auto _existing { std::find_if(reflection.bindings.begin(), reflection.bindings.end(),
+                [&](const auto& other) { return other.set == binding.set && other.binding == binding.binding; }) };
+            if (_existing == reflection.bindings.end())
+            {
+                reflection.bindings.push_back(binding);
+                return;
+            }
+            if (_existing->type != binding.type || _existing->count != binding.count)
+            {
+                throw std::runtime_error(reflection.name + " declares set " + std::to_string(binding.set) + " binding "
+                    + std::to_string(binding.binding) + " with different types!");
+            }
+        }
+
+        void reflectSpecConstants()
+        {
+            for (const auto id : specConstants)
+            {
+                const auto _specId { decoration(id, SpecId) };
+                if (!_specId)
+                {
+                    // An OpSpecConstantOp input or similar, not settable from the API.
+                    continue;
+                }
+                const auto& _constant { constants.at(id) };
+                const auto& _type { type(_constant.type) };
+                const auto _name { names.contains(id) ? names.at(id) : "constant" + std::to_string(*_specId) };
+                reflection.specConstants.push_back({
+                    *_specId,
+                    _name,
+                    _type.opcode == OpTypeBool ? 4 : _type.operands[1] / 8,
+                    _constant.value
+                });
+            }
+            std::sort(reflection.specConstants.begin(), reflection.specConstants.end(),
+                [](const auto& a, const auto& b) { return a.id < b.id; });
+        }
+
+        // A constant decorated WorkgroupSize wins over the execution mode, it is what
+        // local_size_x_id and friends turn into.
+        void reflectLocalSize()
+        {
+            for (const auto& [id, components] : composites)
+            {
+                if (decoration(id, BuiltIn) == BUILT_IN_WORKGROUP_SIZE && components.size() == 3)
+                {
+                    for (int i = 0; i < 3; i++)
+                    {
+                        reflection.localSize[i] = static_cast<uint32_t>(constantValue(components[i]));
+                    }
+                    return;
+                }
+            }
+            if (localSizeOperands.size() != 3)
+            {
+                return;
+            }
+            for (int i = 0; i < 3; i++)
+            {
+                reflection.localSize[i] = localSizeMode == EXECUTION_MODE_LOCAL_SIZE_ID
+                    ? static_cast<uint32_t>(constantValue(localSizeOperands[i])) : localSizeOperands[i];
+            }
+        }
+
+        struct Variable
+        {
+            uint32_t id             { };
+            uint32_t pointerType    { };
+            uint32_t storageClass   { };
+        };
+
+        struct Constant
+        {
+            uint32_t type           { };
+            uint64_t value          { };
+        };
+
+        Reflection reflection;
+        uint32_t version                { };
+        std::vector<Instruction> instructions;
+        std::optional<uint32_t> entryPoint;
+        std::set<uint32_t> interface;
+        uint32_t localSizeMode          { };
+        std::vector<uint32_t> localSizeOperands;
+        std::map<uint32_t, std::string> names;
+        std::map<uint32_t, std::map<uint32_t, uint32_t>> decorations;
+        std::map<std::pair<uint32_t, uint32_t>, std::map<uint32_t, uint32_t>> memberDecorations;
+        std::map<uint32_t, Instruction> types;
+        std::map<uint32_t, Constant> constants;
+        std::map<uint32_t, std::vector<uint32_t>> composites;
+        std::vector<Variable> variables;
+        std::vector<uint32_t> specConstants;
+    };
+
+    void writeHeader(const std::filesystem::path& path, const std::vector<Reflection>& shaders)
+    {
+        std::ofstream _file { path, std::ios::trunc };
+        _file << "// Generated by shader-embed from the build's SPIR-V binaries, do not edit.\n"
+            << "#pragma once\n\n#include <array>\n#include <cstdint>\n\n#include \"shader_module.hpp\"\n";
+        for (const auto& shader : shaders)
+        {
+            const auto& _id { shader.identifier };
+            _file << "\n// " << shader.name << "\nextern const uint32_t " << _id << "_CODE[" << shader.code.size() << "];\n"
+                << "inline constexpr std::array<ShaderBinding, " << shader.bindings.size() << "> " << _id << "_BINDINGS { {\n";
+            for (const auto& binding : shader.bindings)
+            {
+                _file << "    { " << binding.set << ", " << binding.binding << ", " << binding.type << ", " << binding.count
+                    << " },\n";
+            }
+            _file << "} };\ninline constexpr std::array<ShaderSpecConstant, " << shader.specConstants.size() << "> " << _id
+                << "_SPEC_CONSTANTS { {\n";
+            for (const auto& constant : shader.specConstants)
+            {
+                _file << "    { " << constant.id << ", \"" << constant.name << "\", " << constant.size << ", "
+                    << constant.defaultValue << "u },\n";
+            }
+            _file << "} };\ninline constexpr EmbeddedShader " << _id << " {\n"
+                << "    .name = \"" << shader.name << "\",\n"
+                << "    .stage = " << shader.stage << ",\n"
+                << "    .code = " << _id << "_CODE,\n"
+                << "    .bindings = " << _id << "_BINDINGS,\n"
+                << "    .pushConstantSize = " << shader.pushConstantSize << ",\n"
+                << "    .specConstants = " << _id << "_SPEC_CONSTANTS,\n"
+                << "    .localSize = { " << shader.localSize[0] << ", " << shader.localSize[1] << ", "
+                << shader.localSize[2] << " }\n};\n";
+        }
+        if (!_file.flush())
+        {
+            throw std::runtime_error("Failed to write " + path.string() + "!");
+        }
+    }
+
+    void writeSource(const std::filesystem::path& path, const std::vector<Reflection>& shaders)
+    {
+        std::ofstream _file { path, std::ios::trunc };
+        _file << "// Generated by shader-embed from the build's SPIR-V binaries, do not edit.\n"
+            << "#include \"embedded_shaders.hpp\"\n" << std::hex << std::setfill('0');
+        for (const auto& shader : shaders)
+        {
+            _file << "\nconst uint32_t " << shader.identifier << "_CODE[" << std::dec << shader.code.size() << std::hex << "] {";
+            for (size_t i = 0; i < shader.code.size(); i++)
+            {
+                _file << (i % 8 ? " " : "\n    ") << "0x" << std::setw(8) << shader.code[i] << ",";
+            }
+            _file << "\n};\n";
+        }
+        if (!_file.flush())
+        {
+            throw std::runtime_error("Failed to write " + path.string() + "!");
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 3)
+        {
+            throw std::runtime_error("Usage: " + std::string(argv[0]) + " <output dir> <shader.spv>...");
+        }
+        std::vector<Reflection> _shaders;
+        for (int i = 2; i < argc; i++)
+        {
+            _shaders.push_back(Reflector(argv[i]).reflect());
+        }
+        const std::filesystem::path _output { argv[1] };
+        writeHeader(_output / "embedded_shaders.hpp", _shaders);
+        writeSource(_output / "embedded_shaders.cpp", _shaders);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}